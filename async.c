@@ -0,0 +1,245 @@
+/* RamseyScript
+ * Written in 2012 by
+ *   Andrew Poelstra <apoelstra@wpsoftware.net>
+ *
+ * To the extent possible under law, the author(s) have dedicated all
+ * copyright and related and neighboring rights to this software to
+ * the public domain worldwide. This software is distributed without
+ * any warranty.
+ *
+ * You should have received a copy of the CC0 Public Domain Dedication
+ * along with this software.
+ * If not, see <http://creativecommons.org/publicdomain/zero/1.0/>.
+ */
+/*! \file async.c
+ *  \brief Implementation of background searches.
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <errno.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "global.h"
+#include "async.h"
+#include "ramsey/ramsey.h"
+#include "strategy/strategy.h"
+
+/*! \brief Private data for a background search. */
+struct _async_search {
+  /*! \brief Guards everything below, and the targets and dumps while
+   *         the search runs (as the state's record_lock). */
+  pthread_mutex_t lock;
+  /*! \brief Signalled when the deadline changes, or the search ends. */
+  pthread_cond_t changed;
+  /*! \brief Held while the search outputs its results, and by the main
+   *         thread while it outputs anything (see async_search_hold_output).
+   *         Taken before lock, never after it. */
+  pthread_mutex_t output_lock;
+
+  /*! \brief The thread running the search. */
+  pthread_t search_thread;
+  /*! \brief The thread enforcing max-run-time. */
+  pthread_t watch_thread;
+
+  /*! \brief The seed being searched from. */
+  ramsey_t *seed;
+  /*! \brief The strategy being searched with. */
+  strategy_t *strategy;
+  /*! \brief The function to call when the search finishes. */
+  async_done_fn done;
+  /*! \brief The global state of the program. */
+  global_data_t *state;
+
+  /*! \brief The time the search command was given. */
+  time_t start;
+  /*! \brief The time to stop the search at, or 0 for none. */
+  time_t deadline;
+  /*! \brief Whether the strategy has returned. */
+  bool finished;
+  /*! \brief Whether the results have been output. */
+  bool output;
+  /*! \brief Whether async_search_destroy() is waiting for the search. */
+  bool waiting;
+};
+
+static void *_search_main (void *arg)
+{
+  async_search_t *as = arg;
+  bool at_prompt;
+
+  as->strategy->run (as->strategy, as->seed, as->state);
+
+  pthread_mutex_lock (&as->lock);
+  as->finished = 1;
+  at_prompt = !as->waiting;
+  pthread_cond_broadcast (&as->changed);
+  pthread_mutex_unlock (&as->lock);
+
+  /* The seed and strategy are freed by done() */
+  pthread_mutex_lock (&as->output_lock);
+  as->done (as->seed, as->strategy, as->start, as->state, at_prompt);
+  pthread_mutex_unlock (&as->output_lock);
+
+  pthread_mutex_lock (&as->lock);
+  as->output = 1;
+  pthread_mutex_unlock (&as->lock);
+  return NULL;
+}
+
+static void *_watch_main (void *arg)
+{
+  async_search_t *as = arg;
+
+  pthread_mutex_lock (&as->lock);
+  while (!as->finished)
+    {
+      if (as->deadline == 0)
+        pthread_cond_wait (&as->changed, &as->lock);
+      else
+        {
+          struct timespec ts;
+          ts.tv_sec = as->deadline;
+          ts.tv_nsec = 0;
+          if (pthread_cond_timedwait (&as->changed, &as->lock, &ts) == ETIMEDOUT &&
+              as->deadline && time (NULL) >= as->deadline)
+            {
+              as->state->kill_now = 1;
+              break;
+            }
+        }
+    }
+  pthread_mutex_unlock (&as->lock);
+  return NULL;
+}
+
+async_search_t *async_search_start (ramsey_t *seed, strategy_t *strategy,
+                                    time_t start, async_done_fn done,
+                                    global_data_t *state)
+{
+  async_search_t *rv = malloc (sizeof *rv);
+
+  if (rv == NULL)
+    return NULL;
+  pthread_mutex_init (&rv->lock, NULL);
+  pthread_cond_init (&rv->changed, NULL);
+  pthread_mutex_init (&rv->output_lock, NULL);
+  rv->seed = seed;
+  rv->strategy = strategy;
+  rv->done = done;
+  rv->state = state;
+  rv->start = start;
+  rv->finished = 0;
+  rv->output = 0;
+  rv->waiting = 0;
+
+  /* Take over max-run-time from the recursion */
+  rv->deadline = seed->r_max_run_time ? start + seed->r_max_run_time : 0;
+  seed->r_max_run_time = 0;
+
+  state->progress = seed->r_iterations;
+  state->record_lock = &rv->lock;
+  if (pthread_create (&rv->watch_thread, NULL, _watch_main, rv) != 0)
+    {
+      state->record_lock = NULL;
+      seed->r_max_run_time = rv->deadline ? rv->deadline - start : 0;
+      pthread_mutex_destroy (&rv->output_lock);
+      pthread_cond_destroy (&rv->changed);
+      pthread_mutex_destroy (&rv->lock);
+      free (rv);
+      return NULL;
+    }
+  if (pthread_create (&rv->search_thread, NULL, _search_main, rv) != 0)
+    {
+      pthread_mutex_lock (&rv->lock);
+      rv->finished = 1;
+      pthread_cond_broadcast (&rv->changed);
+      pthread_mutex_unlock (&rv->lock);
+      pthread_join (rv->watch_thread, NULL);
+
+      state->record_lock = NULL;
+      seed->r_max_run_time = rv->deadline ? rv->deadline - start : 0;
+      pthread_mutex_destroy (&rv->output_lock);
+      pthread_cond_destroy (&rv->changed);
+      pthread_mutex_destroy (&rv->lock);
+      free (rv);
+      return NULL;
+    }
+  return rv;
+}
+
+bool async_search_running (async_search_t *as)
+{
+  bool rv;
+  pthread_mutex_lock (&as->lock);
+  rv = !as->output;
+  pthread_mutex_unlock (&as->lock);
+  return rv;
+}
+
+void async_search_status (async_search_t *as, stream_t *out)
+{
+  pthread_mutex_lock (&as->lock);
+  if (as->finished)
+    stream_printf (out, "The search has finished.\n");
+  else
+    {
+      stream_printf (out, "Searching for %lds: %ld iterations.\n",
+                     (long) (time (NULL) - as->start), as->state->progress);
+      if (as->deadline)
+        stream_printf (out, "  Stop after: \t%ld seconds\n",
+                       (long) (as->deadline - as->start));
+    }
+  pthread_mutex_unlock (&as->lock);
+}
+
+void async_search_best (async_search_t *as, stream_t *out)
+{
+  dc_list *dlist;
+
+  pthread_mutex_lock (&as->lock);
+  for (dlist = as->state->targets; dlist; dlist = dlist->next)
+    dlist->data->output (dlist->data, out);
+  pthread_mutex_unlock (&as->lock);
+}
+
+void async_search_hold_output (async_search_t *as)
+{
+  pthread_mutex_lock (&as->output_lock);
+}
+
+void async_search_release_output (async_search_t *as)
+{
+  pthread_mutex_unlock (&as->output_lock);
+}
+
+void async_search_set_max_run_time (async_search_t *as, long seconds)
+{
+  pthread_mutex_lock (&as->lock);
+  as->deadline = seconds > 0 ? as->start + seconds : 0;
+  pthread_cond_broadcast (&as->changed);
+  pthread_mutex_unlock (&as->lock);
+}
+
+void async_search_stop (async_search_t *as)
+{
+  as->state->kill_now = 1;
+}
+
+void async_search_destroy (async_search_t *as)
+{
+  pthread_mutex_lock (&as->lock);
+  as->waiting = 1;
+  pthread_mutex_unlock (&as->lock);
+  pthread_join (as->search_thread, NULL);
+  pthread_join (as->watch_thread, NULL);
+  as->state->record_lock = NULL;
+  as->state->kill_now = 0;
+  pthread_mutex_destroy (&as->output_lock);
+  pthread_cond_destroy (&as->changed);
+  pthread_mutex_destroy (&as->lock);
+  free (as);
+}
@@ -0,0 +1,97 @@
+/* RamseyScript
+ * Written in 2012 by
+ *   Andrew Poelstra <apoelstra@wpsoftware.net>
+ *
+ * To the extent possible under law, the author(s) have dedicated all
+ * copyright and related and neighboring rights to this software to
+ * the public domain worldwide. This software is distributed without
+ * any warranty.
+ *
+ * You should have received a copy of the CC0 Public Domain Dedication
+ * along with this software.
+ * If not, see <http://creativecommons.org/publicdomain/zero/1.0/>.
+ */
+/*! \file async.h
+ *  \brief Defines searches run in the background of interactive mode.
+ */
+
+#ifndef ASYNC_H
+#define ASYNC_H
+
+#include <time.h>
+
+#include "global.h"
+
+/*! \brief Convienence typedef for background searches. */
+typedef struct _async_search async_search_t;
+
+/*! \brief Called on the search's thread once it finishes, to output its
+ *         results and free the seed and strategy. at_prompt is false if
+ *         async_search_destroy() is already waiting for the search. The
+ *         output is held back by async_search_hold_output(). */
+typedef void (*async_done_fn) (ramsey_t *seed, strategy_t *strategy,
+                               time_t start, global_data_t *state,
+                               bool at_prompt);
+
+/*! \brief Starts a search on a thread of its own.
+ *
+ *  While the search runs, the targets and dumps are recorded with the
+ *  state's record_lock held, so that async_search_best() may output them,
+ *  and max-run-time is enforced by a second thread rather than by the
+ *  recursion, so that async_search_set_max_run_time() may change it.
+ *
+ *  \param [in] seed      The seed, which must have been set up by
+ *                        recursion_reset().
+ *  \param [in] strategy  The strategy to search with.
+ *  \param [in] start     The time the search command was given.
+ *  \param [in] done      Function to call when the search finishes.
+ *  \param [in] state     The global state of the program.
+ *
+ *  \return The running search, or NULL (with nothing started) if the
+ *          threads could not be started.
+ */
+async_search_t *async_search_start (ramsey_t *seed, strategy_t *strategy,
+                                    time_t start, async_done_fn done,
+                                    global_data_t *state);
+
+/*! \brief Returns whether a search is still running (or outputting). */
+bool async_search_running (async_search_t *as);
+
+/*! \brief Outputs the running time and iteration count of a search. */
+void async_search_status (async_search_t *as, stream_t *out);
+
+/*! \brief Outputs the targets of a search as they are now. */
+void async_search_best (async_search_t *as, stream_t *out);
+
+/*! \brief Holds back the output of a search finishing, so that it cannot
+ *         land in the middle of the caller's own output.
+ *
+ *  Everything written to the terminal while the search runs should be
+ *  written between this and async_search_release_output(). The search
+ *  cannot finish outputting in the meantime, so async_search_destroy()
+ *  must not be called until the output is released.
+ */
+void async_search_hold_output (async_search_t *as);
+
+/*! \brief Lets a search output its results again. */
+void async_search_release_output (async_search_t *as);
+
+/*! \brief Changes the max. run time of a search, counting from its start.
+ *
+ *  \param [in] as       The search.
+ *  \param [in] seconds  The new max. run time, or 0 for none.
+ */
+void async_search_set_max_run_time (async_search_t *as, long seconds);
+
+/*! \brief Stops a search as soon as possible, by setting kill_now. */
+void async_search_stop (async_search_t *as);
+
+/*! \brief Waits for a search to finish and frees it.
+ *
+ *  kill_now is cleared, so that later searches may run.
+ *
+ *  \param [in] as  The search.
+ */
+void async_search_destroy (async_search_t *as);
+
+#endif
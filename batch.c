@@ -0,0 +1,539 @@
+/* RamseyScript
+ * Written in 2012 by
+ *   Andrew Poelstra <apoelstra@wpsoftware.net>
+ *
+ * To the extent possible under law, the author(s) have dedicated all
+ * copyright and related and neighboring rights to this software to
+ * the public domain worldwide. This software is distributed without
+ * any warranty.
+ *
+ * You should have received a copy of the CC0 Public Domain Dedication
+ * along with this software.
+ * If not, see <http://creativecommons.org/publicdomain/zero/1.0/>.
+ */
+
+/*! \file batch.c
+ *  \brief Searches from many seeds on a pool of threads.
+ *
+ *  The calling thread reads seeds from the file into a small queue, and
+ *  the workers take them off it. Nothing but the queue, the program's
+ *  output stream, targets and dumps, and the running total of
+ *  iterations is shared between threads, and all of these are only
+ *  touched with the lock held. The seed objects, strategies, targets,
+ *  dumps and random number generators used while searching are the
+ *  worker's own.
+ *
+ *  Files of objects to process are mapped rather than read, and split
+ *  up where they lie. The objects are checked in chunks: the threads
+ *  each check a slice of the chunk, noting which objects pass, and once
+ *  they are all done the calling thread records those objects, in file
+ *  order, before starting the next chunk. Since the parsers expect text
+ *  to end with a NUL, each object is copied into a buffer of the
+ *  thread's own to be parsed.
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "global.h"
+#include "batch.h"
+#include "buffer-stream.h"
+#include "process.h"
+#include "recurse.h"
+#include "dump/dump.h"
+#include "ramsey/ramsey.h"
+#include "strategy/strategy.h"
+#include "target/target.h"
+
+/*! \brief Number of seeds queued for each worker. */
+#define QUEUE_PER_WORKER	4
+/*! \brief Number of objects processed from a file at once. */
+#define CHUNK_OBJECTS	65536
+
+/*! \brief State shared between the workers. */
+struct _batch {
+  /*! \brief Guards everything below, and the program's output and
+   *         data collectors. */
+  pthread_mutex_t lock;
+  /*! \brief Signalled when a seed is queued, or the file ends. */
+  pthread_cond_t more;
+  /*! \brief Signalled when a seed is taken off the queue. */
+  pthread_cond_t room;
+
+  /*! \brief Queued seeds, as text. */
+  char **queue;
+  /*! \brief Index of the first queued seed. */
+  int head;
+  /*! \brief Number of queued seeds. */
+  int n_queued;
+  /*! \brief Size of the queue. */
+  int max_queued;
+  /*! \brief Whether all seeds have been queued. */
+  bool eof;
+
+  /*! \brief Empty object to copy seeds into. */
+  const ramsey_t *proto;
+  /*! \brief The global state of the program. */
+  global_data_t *state;
+  /*! \brief Total iterations of the searches done. */
+  long iterations;
+};
+
+/*! \brief A thread of the pool. */
+struct _worker {
+  /*! \brief The thread. */
+  pthread_t thread;
+  /*! \brief Whether the thread was started. */
+  bool started;
+  /*! \brief The shared state. */
+  struct _batch *batch;
+  /*! \brief A copy of the global state, with the worker's own data
+   *         collectors, random number generator and output. */
+  global_data_t state;
+  /*! \brief The worker's strategy. */
+  strategy_t *strategy;
+  /*! \brief Scratch stream for saving data collectors. */
+  stream_t *saved;
+};
+
+/* Add a worker's collectors into the program's; lock must be held */
+static void _merge_collectors (struct _worker *w, const dc_list *from,
+                               dc_list *to)
+{
+  for (; from && to; from = from->next, to = to->next)
+    if (from->data && to->data)
+      {
+        buffer_stream_clear (w->saved);
+        from->data->save (from->data, w->saved);
+        to->data->merge (to->data, buffer_stream_get_text (w->saved),
+                         w->batch->proto);
+      }
+}
+
+static void _reset_collectors (dc_list *list)
+{
+  for (; list; list = list->next)
+    if (list->data)
+      list->data->reset (list->data);
+}
+
+/* Take a seed off the queue, or return NULL if there are no more */
+static char *_pop (struct _batch *b)
+{
+  char *rv = NULL;
+
+  pthread_mutex_lock (&b->lock);
+  while (b->n_queued == 0 && !b->eof)
+    pthread_cond_wait (&b->more, &b->lock);
+  if (b->n_queued > 0)
+    {
+      rv = b->queue[b->head];
+      b->head = (b->head + 1) % b->max_queued;
+      --b->n_queued;
+      pthread_cond_signal (&b->room);
+    }
+  pthread_mutex_unlock (&b->lock);
+  return rv;
+}
+
+static void _push (struct _batch *b, char *text)
+{
+  pthread_mutex_lock (&b->lock);
+  while (b->n_queued == b->max_queued)
+    pthread_cond_wait (&b->room, &b->lock);
+  b->queue[(b->head + b->n_queued) % b->max_queued] = text;
+  ++b->n_queued;
+  pthread_cond_signal (&b->more);
+  pthread_mutex_unlock (&b->lock);
+}
+
+static void _search_seed (struct _worker *w, const char *text)
+{
+  struct _batch *b = w->batch;
+  stream_t *out = b->state->out_stream;
+  ramsey_t *seed = b->proto->clone (b->proto);
+
+  if (seed == NULL)
+    {
+      fprintf (stderr, "Out of memory searching from ``%s''.\n", text);
+      return;
+    }
+  seed->empty (seed);
+  seed->parse (seed, text);
+
+  _reset_collectors (w->state.targets);
+  _reset_collectors (w->state.dumps);
+  recursion_reset (seed, &w->state);
+  w->strategy->run (w->strategy, seed, &w->state);
+
+  pthread_mutex_lock (&b->lock);
+  out->write (out, buffer_stream_get_text (w->state.out_stream));
+  if (!b->state->quiet)
+    {
+      stream_printf (out, "Seed ");
+      seed->print (seed, out);
+      stream_printf (out, ": %ld iterations\n", seed->r_iterations);
+    }
+  _merge_collectors (w, w->state.targets, b->state->targets);
+  _merge_collectors (w, w->state.dumps, b->state->dumps);
+  b->iterations += seed->r_iterations;
+  pthread_mutex_unlock (&b->lock);
+
+  buffer_stream_clear (w->state.out_stream);
+  seed->destroy (seed);
+}
+
+static void *_worker_main (void *arg)
+{
+  struct _worker *w = arg;
+  char *text;
+
+  while ((text = _pop (w->batch)) != NULL)
+    {
+      if (!w->batch->state->kill_now)
+        _search_seed (w, text);
+      free (text);
+    }
+  return NULL;
+}
+
+/* Set up a worker's own state; returns 0 on failure */
+static int _worker_init (struct _worker *w, struct _batch *b,
+                         const char *strategy)
+{
+  global_data_t *state = b->state;
+
+  w->started = 0;
+  w->batch = b;
+  memcpy (&w->state, state, sizeof *state);
+  w->state.dist = NULL;
+  w->state.interactive = 0;
+  w->state.targets = copy_collectors (state->targets, target_new, state->settings);
+  w->state.dumps = copy_collectors (state->dumps, dump_new, state->settings);
+  w->state.out_stream = buffer_stream_new ();
+  rng_seed (&w->state.rng, (unsigned long) rng_next (&state->rng));
+  w->strategy = strategy_new (strategy, state->settings);
+  w->saved = buffer_stream_new ();
+
+  return (state->targets == NULL || w->state.targets != NULL)
+      && (state->dumps == NULL || w->state.dumps != NULL)
+      && w->state.out_stream != NULL && w->strategy != NULL
+      && w->saved != NULL;
+}
+
+static void _worker_destroy (struct _worker *w)
+{
+  free_collectors (w->state.targets);
+  free_collectors (w->state.dumps);
+  if (w->state.out_stream)
+    w->state.out_stream->destroy (w->state.out_stream);
+  if (w->strategy)
+    w->strategy->destroy (w->strategy);
+  if (w->saved)
+    w->saved->destroy (w->saved);
+}
+
+int batch_get_n_threads (const global_data_t *state)
+{
+  const setting_t *threads_set = SETTING ("threads");
+  long n = threads_set ? threads_set->get_int_value (threads_set)
+                       : sysconf (_SC_NPROCESSORS_ONLN);
+  return n < 1 ? 1 : (int) n;
+}
+
+long batch_search (const ramsey_t *proto, const char *strategy,
+                   const char *path, global_data_t *state)
+{
+  struct _batch b;
+  struct _worker *worker;
+  int n_workers = batch_get_n_threads (state);
+  FILE *fh = fopen (path, "r");
+  char *line = NULL;
+  size_t max_line = 0;
+  int n_started = 0;
+  int i;
+
+  if (fh == NULL)
+    {
+      fprintf (stderr, "Error: could not read seeds from ``%s'': %s.\n",
+               path, strerror (errno));
+      return -1;
+    }
+
+  worker = malloc (n_workers * sizeof *worker);
+  b.queue = malloc (QUEUE_PER_WORKER * n_workers * sizeof *b.queue);
+  if (worker == NULL || b.queue == NULL)
+    {
+      fputs ("Error: out of memory starting threads.\n", stderr);
+      free (worker);
+      free (b.queue);
+      fclose (fh);
+      return -1;
+    }
+  pthread_mutex_init (&b.lock, NULL);
+  pthread_cond_init (&b.more, NULL);
+  pthread_cond_init (&b.room, NULL);
+  b.head = b.n_queued = 0;
+  b.max_queued = QUEUE_PER_WORKER * n_workers;
+  b.eof = 0;
+  b.proto = proto;
+  b.state = state;
+  b.iterations = 0;
+
+  /* Start the pool */
+  for (i = 0; i < n_workers; ++i)
+    if (!_worker_init (&worker[i], &b, strategy))
+      fputs ("Error: could not set up a thread.\n", stderr);
+    else if (pthread_create (&worker[i].thread, NULL, _worker_main, &worker[i]) != 0)
+      fprintf (stderr, "Error: could not start a thread: %s.\n", strerror (errno));
+    else
+      {
+        worker[i].started = 1;
+        ++n_started;
+      }
+
+  /* Feed it */
+  while (n_started > 0 && getline (&line, &max_line, fh) > 0 && !state->kill_now)
+    {
+      char *text = line + strspn (line, " \t");
+      char *copy;
+
+      text[strcspn (text, "\r\n")] = 0;
+      if (*text == 0 || *text == '#')
+        continue;
+      if (*text != '[')
+        {
+          fprintf (stderr, "Warning: skipping ``%s'', which is not a seed.\n", text);
+          continue;
+        }
+      copy = malloc (strlen (text) + 1);
+      if (copy == NULL)
+        {
+          fputs ("Error: out of memory reading seeds.\n", stderr);
+          break;
+        }
+      strcpy (copy, text);
+      _push (&b, copy);
+    }
+  free (line);
+  fclose (fh);
+
+  pthread_mutex_lock (&b.lock);
+  b.eof = 1;
+  pthread_cond_broadcast (&b.more);
+  pthread_mutex_unlock (&b.lock);
+
+  /* Wait for it */
+  for (i = 0; i < n_workers; ++i)
+    {
+      if (worker[i].started)
+        pthread_join (worker[i].thread, NULL);
+      _worker_destroy (&worker[i]);
+    }
+
+  pthread_cond_destroy (&b.room);
+  pthread_cond_destroy (&b.more);
+  pthread_mutex_destroy (&b.lock);
+  free (b.queue);
+  free (worker);
+  return n_started > 0 ? b.iterations : -1;
+}
+
+/* PROCESSING FILES */
+
+/*! \brief An object in a mapped file. */
+struct _span {
+  /*! \brief Start of the object. */
+  const char *text;
+  /*! \brief Length of the object. */
+  size_t len;
+};
+
+/*! \brief A thread checking objects against the filters. */
+struct _checker {
+  /*! \brief The thread. */
+  pthread_t thread;
+  /*! \brief Whether the thread is running. */
+  bool running;
+  /*! \brief The object parsed into, again and again. */
+  ramsey_t *rt;
+  /*! \brief NUL-terminated copy of the object being parsed. */
+  char *buf;
+  /*! \brief Size of the buffer. */
+  size_t max_buf;
+  /*! \brief The objects of the current chunk. */
+  const struct _span *span;
+  /*! \brief Whether each object of the chunk passed. */
+  bool *pass;
+  /*! \brief The first object to check. */
+  int first;
+  /*! \brief The number of objects to check. */
+  int n;
+};
+
+/* Parse a span into a checker's object; returns 0 on failure */
+static int _parse_span (struct _checker *c, const struct _span *span)
+{
+  if (span->len >= c->max_buf)
+    {
+      size_t new_max = 2 * span->len + 64;
+      char *tmp = realloc (c->buf, new_max);
+      if (tmp == NULL)
+        return 0;
+      c->buf = tmp;
+      c->max_buf = new_max;
+    }
+  memcpy (c->buf, span->text, span->len);
+  c->buf[span->len] = 0;
+  c->rt->empty (c->rt);
+  c->rt->parse (c->rt, c->buf);
+  return 1;
+}
+
+static void *_checker_main (void *arg)
+{
+  struct _checker *c = arg;
+  int i;
+
+  for (i = c->first; i < c->first + c->n; ++i)
+    c->pass[i] = _parse_span (c, &c->span[i]) && c->rt->run_filters (c->rt);
+  return NULL;
+}
+
+/* Find the next object, from its outer brackets; returns 0 at the end */
+static int _next_span (const char **scan, const char *end, struct _span *span)
+{
+  const char *s = *scan;
+  int depth = 0;
+
+  while (s < end && *s != '[')
+    ++s;
+  span->text = s;
+  for (; s < end; ++s)
+    if (*s == '[')
+      ++depth;
+    else if (*s == ']' && --depth == 0)
+      {
+        span->len = s + 1 - span->text;
+        *scan = s + 1;
+        return 1;
+      }
+  *scan = end;
+  return 0;
+}
+
+long batch_process_file (const ramsey_t *proto, const char *path,
+                         global_data_t *state, long *n_passed)
+{
+  int n_checkers = batch_get_n_threads (state);
+  struct _checker *checker = malloc ((n_checkers + 1) * sizeof *checker);
+  struct _span *span = malloc (CHUNK_OBJECTS * sizeof *span);
+  bool *pass = malloc (CHUNK_OBJECTS * sizeof *pass);
+  struct _checker *recorder;
+  const char *map = NULL, *scan, *end;
+  struct stat st;
+  long n_objects = 0;
+  bool ok = 1;
+  int fd, i;
+
+  *n_passed = 0;
+  if (checker == NULL || span == NULL || pass == NULL)
+    {
+      fputs ("Error: out of memory processing file.\n", stderr);
+      free (checker);
+      free (span);
+      free (pass);
+      return -1;
+    }
+
+  fd = open (path, O_RDONLY);
+  if (fd < 0 || fstat (fd, &st) != 0
+      || (st.st_size > 0
+          && (map = mmap (NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0)) == MAP_FAILED))
+    {
+      fprintf (stderr, "Error: could not read ``%s'': %s.\n", path,
+               strerror (errno));
+      if (fd >= 0)
+        close (fd);
+      free (checker);
+      free (span);
+      free (pass);
+      return -1;
+    }
+  close (fd);
+
+  /* The last checker is the calling thread's, for recording */
+  for (i = 0; i <= n_checkers; ++i)
+    {
+      checker[i].rt = proto->clone (proto);
+      checker[i].buf = NULL;
+      checker[i].max_buf = 0;
+      checker[i].span = span;
+      checker[i].pass = pass;
+      checker[i].running = 0;
+      ok &= checker[i].rt != NULL;
+    }
+  recorder = &checker[n_checkers];
+  if (!ok)
+    fputs ("Error: out of memory processing file.\n", stderr);
+
+  scan = map;
+  end = map ? map + st.st_size : map;
+  while (ok && scan < end && !state->kill_now)
+    {
+      int n_span = 0;
+
+      /* Split up the next chunk */
+      while (n_span < CHUNK_OBJECTS && _next_span (&scan, end, &span[n_span]))
+        ++n_span;
+
+      /* Check it */
+      for (i = 0; i < n_checkers; ++i)
+        {
+          checker[i].first = n_span * i / n_checkers;
+          checker[i].n = n_span * (i + 1) / n_checkers - checker[i].first;
+          checker[i].running =
+            pthread_create (&checker[i].thread, NULL, _checker_main, &checker[i]) == 0;
+          if (!checker[i].running)
+            _checker_main (&checker[i]);
+        }
+      for (i = 0; i < n_checkers; ++i)
+        if (checker[i].running)
+          pthread_join (checker[i].thread, NULL);
+
+      /* Record it, in order */
+      for (i = 0; i < n_span; ++i)
+        if (pass[i] && _parse_span (recorder, &span[i]))
+          {
+            dc_list *dlist;
+            for (dlist = state->dumps; dlist; dlist = dlist->next)
+              dlist->data->record (dlist->data, recorder->rt, state->out_stream);
+            for (dlist = state->targets; dlist; dlist = dlist->next)
+              dlist->data->record (dlist->data, recorder->rt, state->out_stream);
+            ++*n_passed;
+          }
+      n_objects += n_span;
+    }
+
+  for (i = 0; i <= n_checkers; ++i)
+    {
+      if (checker[i].rt)
+        checker[i].rt->destroy (checker[i].rt);
+      free (checker[i].buf);
+    }
+  if (map != NULL)
+    munmap ((void *) map, st.st_size);
+  free (checker);
+  free (span);
+  free (pass);
+  return ok ? n_objects : -1;
+}
@@ -0,0 +1,75 @@
+/* RamseyScript
+ * Written in 2012 by
+ *   Andrew Poelstra <apoelstra@wpsoftware.net>
+ *
+ * To the extent possible under law, the author(s) have dedicated all
+ * copyright and related and neighboring rights to this software to
+ * the public domain worldwide. This software is distributed without
+ * any warranty.
+ *
+ * You should have received a copy of the CC0 Public Domain Dedication
+ * along with this software.
+ * If not, see <http://creativecommons.org/publicdomain/zero/1.0/>.
+ */
+
+/*! \file batch.h
+ *  \brief Defines searches from many seeds on a pool of threads.
+ */
+
+#ifndef BATCH_H
+#define BATCH_H
+
+#include "global.h"
+
+/*! \brief Returns the number of threads to work on, from the variable
+ *         threads, or the number of processors if it is unset.
+ *
+ *  \param [in] state  The global state of the program.
+ */
+int batch_get_n_threads (const global_data_t *state);
+
+/*! \brief Searches from every seed in a file, on a pool of threads.
+ *
+ *  The file is read a line at a time, each line holding one seed, and
+ *  the seeds are handed out to the threads, of which there are as many
+ *  as the variable threads says (or as there are processors, if it is
+ *  unset). Each thread has its own copies of the targets and dumps, and
+ *  its own random number generator; the output of each search is held
+ *  back until it is done, and output all at once, so the output of
+ *  different searches never interleaves. The saved state of each search's
+ *  targets and dumps is merged into those of the program as it finishes.
+ *
+ *  \param [in] proto     An empty object of the space to search, with
+ *                        the filters attached, to copy each seed into.
+ *  \param [in] strategy  The name of the strategy to search with.
+ *  \param [in] path      The name of the file of seeds.
+ *  \param [in] state     The global state of the program.
+ *
+ *  \return The total iterations of every search, or -1 (after printing
+ *          an error) if none could be done.
+ */
+long batch_search (const ramsey_t *proto, const char *strategy,
+                   const char *path, global_data_t *state);
+
+/*! \brief Runs every object in a file through the filters, targets and dumps.
+ *
+ *  The file is mapped into memory and split into objects at their outer
+ *  brackets, so any text between objects is ignored. The objects are
+ *  checked against the filters on a pool of threads (see threads), each
+ *  reusing one object of its own; those which pass are then recorded by
+ *  the targets and dumps in the order they appear in the file, exactly
+ *  as ``process'' would record them one at a time.
+ *
+ *  \param [in] proto  An empty object of the space of the objects, with
+ *                     the filters attached.
+ *  \param [in] path   The name of the file.
+ *  \param [in] state  The global state of the program.
+ *  \param [out] n_passed  The number of objects which passed the filters.
+ *
+ *  \return The number of objects in the file, or -1 (after printing an
+ *          error) if it could not be read.
+ */
+long batch_process_file (const ramsey_t *proto, const char *path,
+                         global_data_t *state, long *n_passed);
+
+#endif
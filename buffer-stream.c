@@ -0,0 +1,146 @@
+/* RamseyScript
+ * Written in 2012 by
+ *   Andrew Poelstra <apoelstra@wpsoftware.net>
+ *
+ * To the extent possible under law, the author(s) have dedicated all
+ * copyright and related and neighboring rights to this software to
+ * the public domain worldwide. This software is distributed without
+ * any warranty.
+ *
+ * You should have received a copy of the CC0 Public Domain Dedication
+ * along with this software.
+ * If not, see <http://creativecommons.org/publicdomain/zero/1.0/>.
+ */
+
+/*! \file buffer-stream.c
+ *  \brief Implementation of memory-based stream.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "global.h"
+#include "buffer-stream.h"
+
+/*! \brief Amount of memory to allocate by default for the buffer. */
+#define DEFAULT_BUFFER_LEN	1000
+
+/*! \brief Private data for the buffer stream type. */
+struct _buffer_stream {
+  /*! \brief parent struct. */
+  stream_t parent;
+
+  /*! \brief The text written so far, nul-terminated. */
+  char *text;
+  /*! \brief Length of the text. */
+  size_t len;
+  /*! \brief Size of the text buffer. */
+  size_t max_len;
+  /*! \brief Offset of the next line read_line() will return. */
+  size_t read_pos;
+};
+
+/* OPEN / CLOSE */
+static int _buffer_stream_open (stream_t *s, enum e_stream_mode mode)
+{
+  (void) s;
+  (void) mode;
+  return 1;
+}
+
+static void _buffer_stream_close (stream_t *s)
+{
+  (void) s;
+}
+
+/* READ / WRITE */
+static char *_buffer_stream_read_line (stream_t *s)
+{
+  struct _buffer_stream *priv = (struct _buffer_stream *) s;
+  const char *start = priv->text + priv->read_pos;
+  const char *end;
+  char *rv;
+
+  if (priv->read_pos >= priv->len)
+    return NULL;
+
+  end = strchr (start, '\n');
+  end = end ? end + 1 : priv->text + priv->len;
+  rv = malloc (end - start + 1);
+  if (rv == NULL)
+    return NULL;
+  memcpy (rv, start, end - start);
+  rv[end - start] = 0;
+  priv->read_pos += end - start;
+  return rv;
+}
+
+static int _buffer_stream_write (stream_t *s, const char *line)
+{
+  struct _buffer_stream *priv = (struct _buffer_stream *) s;
+  size_t n = strlen (line);
+
+  if (priv->len + n + 1 > priv->max_len)
+    {
+      size_t new_max = 2 * (priv->len + n + 1);
+      char *tmp = realloc (priv->text, new_max);
+      if (tmp == NULL)
+        return EOF;
+      priv->text = tmp;
+      priv->max_len = new_max;
+    }
+  memcpy (priv->text + priv->len, line, n + 1);
+  priv->len += n;
+  return n;
+}
+
+/* DESTRUCTOR */
+static void _buffer_stream_destroy (stream_t *s)
+{
+  struct _buffer_stream *priv = (struct _buffer_stream *) s;
+  free (priv->text);
+  free (s);
+}
+
+/* ACCESSORS */
+const char *buffer_stream_get_text (const stream_t *s)
+{
+  const struct _buffer_stream *priv = (const struct _buffer_stream *) s;
+  return priv->text;
+}
+
+void buffer_stream_clear (stream_t *s)
+{
+  struct _buffer_stream *priv = (struct _buffer_stream *) s;
+  priv->text[0] = 0;
+  priv->len = 0;
+  priv->read_pos = 0;
+}
+
+/* CONSTRUCTOR */
+stream_t *buffer_stream_new ()
+{
+  struct _buffer_stream *priv = malloc (sizeof *priv);
+  stream_t *rv = (stream_t *) priv;
+  if (rv)
+    {
+      rv->open    = _buffer_stream_open;
+      rv->close   = _buffer_stream_close;
+      rv->read_line = _buffer_stream_read_line;
+      rv->write   = _buffer_stream_write;
+      rv->destroy = _buffer_stream_destroy;
+
+      priv->len = 0;
+      priv->read_pos = 0;
+      priv->max_len = DEFAULT_BUFFER_LEN;
+      priv->text = malloc (priv->max_len);
+      if (priv->text == NULL)
+        {
+          free (priv);
+          return NULL;
+        }
+      priv->text[0] = 0;
+    }
+  return rv;
+}
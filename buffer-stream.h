@@ -0,0 +1,42 @@
+/* RamseyScript
+ * Written in 2012 by
+ *   Andrew Poelstra <apoelstra@wpsoftware.net>
+ *
+ * To the extent possible under law, the author(s) have dedicated all
+ * copyright and related and neighboring rights to this software to
+ * the public domain worldwide. This software is distributed without
+ * any warranty.
+ *
+ * You should have received a copy of the CC0 Public Domain Dedication
+ * along with this software.
+ * If not, see <http://creativecommons.org/publicdomain/zero/1.0/>.
+ */
+
+/*! \file buffer-stream.h
+ *  \brief Defines memory-based streams and related functions.
+ */
+
+#ifndef BUFFER_STREAM_H
+#define BUFFER_STREAM_H
+
+#include "stream.h"
+
+/*! \brief Create a new stream which keeps its text in memory.
+ *
+ *  Everything written to the stream is appended to a buffer, which
+ *  read_line() then reads back a line at a time. The stream is
+ *  permanently open for both reading and writing, and the open/close
+ *  methods are no-ops.
+ *
+ *  \return A newly-allocated stream, or NULL on failure.
+ */
+stream_t *buffer_stream_new ();
+
+/*! \brief Returns everything written to a buffer stream and not yet
+ *         cleared, whether or not it has been read. */
+const char *buffer_stream_get_text (const stream_t *s);
+
+/*! \brief Empties a buffer stream. */
+void buffer_stream_clear (stream_t *s);
+
+#endif
@@ -0,0 +1,223 @@
+/* RamseyScript
+ * Written in 2012 by
+ *   Andrew Poelstra <apoelstra@wpsoftware.net>
+ *
+ * To the extent possible under law, the author(s) have dedicated all
+ * copyright and related and neighboring rights to this software to
+ * the public domain worldwide. This software is distributed without
+ * any warranty.
+ *
+ * You should have received a copy of the CC0 Public Domain Dedication
+ * along with this software.
+ * If not, see <http://creativecommons.org/publicdomain/zero/1.0/>.
+ */
+
+/*! \file child-order.c
+ *  \brief The orders in which searches may try children.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "global.h"
+#include "child-order.h"
+#include "ramsey/ramsey.h"
+#include "ramsey/coloring.h"
+
+/*! \brief Number of values the future of a coloring is looked at for. */
+#define FUTURE_LOOKAHEAD	16
+
+static const char *g_order_name[] = {
+  "natural", "least_constraining", "most_recent_success", "random"
+};
+static const int g_n_orders = sizeof g_order_name / sizeof g_order_name[0];
+
+int child_order_get (const setting_list_t *vars, e_child_order *order)
+{
+  const setting_t *order_set = vars->get_setting (vars, "child_order");
+  int i;
+
+  *order = ORDER_NATURAL;
+  if (order_set == NULL)
+    return 1;
+  for (i = 0; i < g_n_orders; ++i)
+    if (!strcmp (order_set->get_text (order_set), g_order_name[i]))
+      {
+        *order = (e_child_order) i;
+        return 1;
+      }
+  fprintf (stderr, "Error: unknown child-order ``%s''; use natural, "
+                   "least-constraining, most-recent-success or random.\n",
+           order_set->get_text (order_set));
+  return 0;
+}
+
+const char *child_order_name (e_child_order order)
+{
+  return g_order_name[order];
+}
+
+long child_order_future (ramsey_t *rt)
+{
+  long rv = 0;
+  int i;
+
+  if (rt->type == TYPE_COLORING)
+    {
+      const ramsey_t *base = coloring_get_base_sequence (rt);
+      int length = rt->get_length (rt);
+      int n_values = length + FUTURE_LOOKAHEAD;
+      unsigned long all = CELL_MASK_ALL (rt->get_n_cells (rt));
+      const int *value = NULL;
+
+      /* The next values are the base sequence's, if it has any left */
+      if (base != NULL)
+        {
+          value = base->get_priv_data_const (base);
+          if (n_values > base->get_length (base))
+            n_values = base->get_length (base);
+        }
+
+      for (i = length + 1; i <= n_values; ++i)
+        {
+          unsigned long mask = rt->get_allowed_cells (rt, value ? value[i - 1] : i)
+                               & all;
+          while (mask)
+            {
+              mask &= mask - 1;
+              ++rv;
+            }
+        }
+    }
+  else
+    {
+      int n_children = rt->get_n_children (rt);
+      for (i = 0; i < n_children; ++i)
+        if (rt->child_append (rt, i))
+          {
+            rv += rt->run_filters (rt);
+            rt->child_deappend (rt, i);
+          }
+    }
+  return rv;
+}
+
+void child_order_fill (e_child_order how, ramsey_t *rt, global_data_t *state,
+                       int *order, long *score, int n, int success)
+{
+  int i, j;
+
+  for (i = 0; i < n; ++i)
+    order[i] = i;
+
+  switch (how)
+    {
+    case ORDER_NATURAL:
+      break;
+    case ORDER_MOST_RECENT_SUCCESS:
+      if (success > 0 && success < n)
+        {
+          for (i = success; i > 0; --i)
+            order[i] = order[i - 1];
+          order[0] = success;
+        }
+      break;
+    case ORDER_RANDOM:
+      for (i = n - 1; i > 0; --i)
+        {
+          int tmp;
+          j = rng_range (&state->rng, i + 1);
+          tmp = order[i];
+          order[i] = order[j];
+          order[j] = tmp;
+        }
+      break;
+    case ORDER_LEAST_CONSTRAINING:
+      /* Children failing the filters go last */
+      for (i = 0; i < n; ++i)
+        {
+          score[i] = -1;
+          if (rt->child_append (rt, i))
+            {
+              if (rt->run_filters (rt))
+                score[i] = child_order_future (rt);
+              rt->child_deappend (rt, i);
+            }
+        }
+      /* Stable insertion sort; n is small */
+      for (i = 1; i < n; ++i)
+        {
+          int child = order[i];
+          for (j = i; j > 0 && score[order[j - 1]] < score[child]; --j)
+            order[j] = order[j - 1];
+          order[j] = child;
+        }
+      break;
+    }
+}
+
+void child_order_init (child_order_t *co, e_child_order how)
+{
+  co->how = how;
+  co->n_children = 0;
+  co->max_depth = 0;
+  co->order = NULL;
+  co->score = NULL;
+  co->success = NULL;
+}
+
+void child_order_clear (child_order_t *co)
+{
+  free (co->order);
+  free (co->score);
+  free (co->success);
+  child_order_init (co, co->how);
+}
+
+int child_order_begin (child_order_t *co, ramsey_t *rt, global_data_t *state,
+                       int depth, int n)
+{
+  if (n <= 0)
+    return 0;
+  /* Only a new search can change the number of children */
+  if (n != co->n_children)
+    {
+      child_order_clear (co);
+      co->score = malloc (n * sizeof *co->score);
+      if (co->score == NULL)
+        return 0;
+      co->n_children = n;
+    }
+
+  if (depth >= co->max_depth)
+    {
+      int new_max = 2 * (depth + 1);
+      int *tmp = realloc (co->order, new_max * n * sizeof *tmp);
+      int *tmp_success = tmp ? realloc (co->success, new_max * sizeof *tmp_success) : NULL;
+      int i;
+      if (tmp)
+        co->order = tmp;
+      if (tmp_success == NULL)
+        return 0;
+      co->success = tmp_success;
+      for (i = co->max_depth; i < new_max; ++i)
+        co->success[i] = -1;
+      co->max_depth = new_max;
+    }
+
+  child_order_fill (co->how, rt, state, &co->order[depth * n], co->score, n,
+                    co->success[depth]);
+  return 1;
+}
+
+int child_order_at (const child_order_t *co, int depth, int k)
+{
+  return co->order[depth * co->n_children + k];
+}
+
+void child_order_succeed (child_order_t *co, int depth, int child)
+{
+  if (depth < co->max_depth)
+    co->success[depth] = child;
+}
@@ -0,0 +1,125 @@
+/* RamseyScript
+ * Written in 2012 by
+ *   Andrew Poelstra <apoelstra@wpsoftware.net>
+ *
+ * To the extent possible under law, the author(s) have dedicated all
+ * copyright and related and neighboring rights to this software to
+ * the public domain worldwide. This software is distributed without
+ * any warranty.
+ *
+ * You should have received a copy of the CC0 Public Domain Dedication
+ * along with this software.
+ * If not, see <http://creativecommons.org/publicdomain/zero/1.0/>.
+ */
+
+/*! \file child-order.h
+ *  \brief Defines the orders in which searches may try children.
+ */
+
+#ifndef CHILD_ORDER_H
+#define CHILD_ORDER_H
+
+#include "global.h"
+
+/*! \brief An order in which to try the children of a node. */
+typedef enum _e_child_order {
+  /*! \brief The order of the object's child methods. */
+  ORDER_NATURAL,
+  /*! \brief Children leaving the most future choices open first. */
+  ORDER_LEAST_CONSTRAINING,
+  /*! \brief The child which last led to a record at the same depth
+   *         first, then the natural order. */
+  ORDER_MOST_RECENT_SUCCESS,
+  /*! \brief A random order. */
+  ORDER_RANDOM
+} e_child_order;
+
+/*! \brief Child orders for every depth of a recursive search.
+ *
+ *  A recursion works out the order of its children on entering each
+ *  object, and needs it kept until all of them have been tried, so
+ *  the orders are stored as one row per depth. Rows are looked up by
+ *  index, since deeper objects may move the storage around.
+ */
+typedef struct _child_order {
+  /*! \brief The order to use. */
+  e_child_order how;
+  /*! \brief Number of children of each object (the row length). */
+  int n_children;
+  /*! \brief Number of depths allocated. */
+  int max_depth;
+  /*! \brief The child order at each depth. */
+  int *order;
+  /*! \brief Scratch space for child_order_fill(). */
+  long *score;
+  /*! \brief The child which last led to a record at each depth, or -1. */
+  int *success;
+} child_order_t;
+
+/*! \brief Reads the child-order variable.
+ *
+ *  \param [in]  vars   The table of script variables.
+ *  \param [out] order  The order named by child-order, or ORDER_NATURAL
+ *                      if it is unset.
+ *
+ *  \return 1 on success, 0 (after printing an error) if the variable
+ *          names no known order.
+ */
+int child_order_get (const setting_list_t *vars, e_child_order *order);
+
+/*! \brief Returns the name of an order, as used by child-order. */
+const char *child_order_name (e_child_order order);
+
+/*! \brief Lists the children of a node in a given order.
+ *
+ *  \param [in]  how     The order to use.
+ *  \param [in]  rt      The node. It is left unchanged on return.
+ *  \param [in]  state   The global state of the program (for its
+ *                       random number generator).
+ *  \param [out] order   The indices 0 to n - 1 of the children, in the
+ *                       order they should be tried.
+ *  \param [out] score   Scratch space of n entries.
+ *  \param [in]  n       The number of children of rt.
+ *  \param [in]  success The child which last led to a record from an
+ *                       object at this depth, or -1 if none has (or
+ *                       it is not being tracked).
+ */
+void child_order_fill (e_child_order how, ramsey_t *rt, global_data_t *state,
+                       int *order, long *score, int n, int success);
+
+/*! \brief Sets up an empty set of per-depth child orders. */
+void child_order_init (child_order_t *co, e_child_order how);
+
+/*! \brief Frees the storage of a set of per-depth child orders. */
+void child_order_clear (child_order_t *co);
+
+/*! \brief Works out the order of the children of an object.
+ *
+ *  \param [in] co     The per-depth orders.
+ *  \param [in] rt     The object, which is left unchanged.
+ *  \param [in] state  The global state of the program.
+ *  \param [in] depth  The depth of the object; its length will do.
+ *  \param [in] n      The number of children of rt.
+ *
+ *  \return 1 on success, or 0 if memory ran out, in which case the
+ *          natural order should be used.
+ */
+int child_order_begin (child_order_t *co, ramsey_t *rt, global_data_t *state,
+                       int depth, int n);
+
+/*! \brief Returns the k'th child to try at a depth (see child_order_begin). */
+int child_order_at (const child_order_t *co, int depth, int k);
+
+/*! \brief Notes that a child led to a record, for most-recent-success. */
+void child_order_succeed (child_order_t *co, int depth, int child);
+
+/*! \brief Measures how many choices the future leaves open to an object.
+ *
+ *  For colorings, this is the number of colors still allowed to each
+ *  of the next few numbers, taken from the base sequence if the
+ *  coloring has one; for other objects, the number of children
+ *  which pass the filters. Higher is better.
+ */
+long child_order_future (ramsey_t *rt);
+
+#endif
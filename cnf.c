@@ -0,0 +1,300 @@
+/* RamseyScript
+ * Written in 2012 by
+ *   Andrew Poelstra <apoelstra@wpsoftware.net>
+ *
+ * To the extent possible under law, the author(s) have dedicated all
+ * copyright and related and neighboring rights to this software to
+ * the public domain worldwide. This software is distributed without
+ * any warranty.
+ *
+ * You should have received a copy of the CC0 Public Domain Dedication
+ * along with this software.
+ * If not, see <http://creativecommons.org/publicdomain/zero/1.0/>.
+ */
+
+/*! \file cnf.c
+ *  \brief Conversion of coloring problems to and from DIMACS CNF.
+ */
+
+#include <ctype.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "global.h"
+#include "cnf.h"
+#include "sat.h"
+
+/*! \brief State of the clause writer. */
+struct _cnf_writer {
+  /*! \brief Stream to write to, or NULL. */
+  stream_t *out;
+  /*! \brief Solver to add clauses to, or NULL. */
+  sat_solver_t *solver;
+  /*! \brief Number of colors. */
+  int n_colors;
+  /*! \brief Number of clauses written (or counted). */
+  long n_clauses;
+  /*! \brief Scratch space for the literals of a clause. */
+  int *lits;
+  /*! \brief Number of literals allocated. */
+  int max_lits;
+  /*! \brief Set if some clause could not be output. */
+  bool failed;
+};
+
+/* Make room for n literals */
+static int _cnf_reserve (struct _cnf_writer *w, int n)
+{
+  if (n > w->max_lits)
+    {
+      int *tmp = realloc (w->lits, n * sizeof *tmp);
+      if (tmp == NULL)
+        {
+          w->failed = 1;
+          return 0;
+        }
+      w->lits = tmp;
+      w->max_lits = n;
+    }
+  return 1;
+}
+
+/* Output the clause held in w->lits */
+static void _cnf_output (struct _cnf_writer *w, int n_lits)
+{
+  char buf[24];
+  int i;
+
+  ++w->n_clauses;
+  if (w->solver != NULL && !sat_add_clause (w->solver, w->lits, n_lits))
+    w->failed = 1;
+  if (w->out == NULL)
+    return;
+  for (i = 0; i < n_lits; ++i)
+    {
+      sprintf (buf, "%d ", w->lits[i]);
+      w->out->write (w->out, buf);
+    }
+  w->out->write (w->out, "0\n");
+}
+
+/* Write a clause with a single literal per value */
+static void _cnf_write_clause (struct _cnf_writer *w, const int *values,
+                               const int *cells, int n_values)
+{
+  int i;
+
+  if (!_cnf_reserve (w, n_values))
+    return;
+  for (i = 0; i < n_values; ++i)
+    w->lits[i] = -((values[i] - 1) * w->n_colors + cells[i] + 1);
+  _cnf_output (w, n_values);
+}
+
+/* Callback for filter_t->get_constraints() */
+static void _cnf_emit (void *data, const int *values, const int *cells, int n_values)
+{
+  struct _cnf_writer *w = data;
+
+  if (cells != NULL)
+    _cnf_write_clause (w, values, cells, n_values);
+  else
+    {
+      /* Write the clause once for each color */
+      int *mono = malloc (n_values * sizeof *mono);
+      int c, i;
+
+      if (mono == NULL)
+        return;
+      for (c = 0; c < w->n_colors; ++c)
+        {
+          for (i = 0; i < n_values; ++i)
+            mono[i] = c;
+          _cnf_write_clause (w, values, mono, n_values);
+        }
+      free (mono);
+    }
+}
+
+/* Generate (or count) every clause */
+static void _cnf_write_all (struct _cnf_writer *w, const filter_list *filters,
+                            int n, bool break_symmetry)
+{
+  const filter_list *flist;
+  int v, c;
+
+  /* Every number gets a color */
+  if (!_cnf_reserve (w, w->n_colors))
+    return;
+  for (v = 1; v <= n; ++v)
+    {
+      for (c = 0; c < w->n_colors; ++c)
+        w->lits[c] = (v - 1) * w->n_colors + c + 1;
+      _cnf_output (w, w->n_colors);
+    }
+
+  /* Number v may only use the first v colors, as is the case for the
+   * first of any set of colorings which are relabellings of each other */
+  if (break_symmetry)
+    for (v = 1; v <= n && v < w->n_colors; ++v)
+      for (c = v; c < w->n_colors; ++c)
+        _cnf_write_clause (w, &v, &c, 1);
+
+  for (flist = filters; flist; flist = flist->next)
+    flist->data->get_constraints (flist->data, n, w->n_colors, _cnf_emit, w);
+}
+
+/* Check that every filter can be converted; clears *break_symmetry
+ * if some filter does not treat the colors alike */
+static int _cnf_check_filters (const filter_list *filters, bool *break_symmetry)
+{
+  const filter_list *flist;
+
+  for (flist = filters; flist; flist = flist->next)
+    {
+      if (flist->data->get_constraints == NULL)
+        {
+          fprintf (stderr, "Error: filter ``%s'' cannot be converted to CNF.\n",
+                   flist->data->get_type (flist->data));
+          return 0;
+        }
+      if (!flist->data->get_symmetry (flist->data))
+        *break_symmetry = 0;
+    }
+  return 1;
+}
+
+static void _cnf_writer_init (struct _cnf_writer *w, stream_t *out,
+                              sat_solver_t *solver, int n_colors)
+{
+  w->out = out;
+  w->solver = solver;
+  w->n_colors = n_colors;
+  w->n_clauses = 0;
+  w->lits = NULL;
+  w->max_lits = 0;
+  w->failed = 0;
+}
+
+int cnf_export (stream_t *out, const filter_list *filters, int n, int n_colors,
+                bool break_symmetry)
+{
+  struct _cnf_writer w;
+  const filter_list *flist;
+
+  if (!_cnf_check_filters (filters, &break_symmetry))
+    return 0;
+
+  /* Count clauses for the header */
+  _cnf_writer_init (&w, NULL, NULL, n_colors);
+  _cnf_write_all (&w, filters, n, break_symmetry);
+
+  stream_printf (out, "c RamseyScript %s: %d-colorings of [1, %d]\n",
+                 VERSION, n_colors, n);
+  stream_printf (out, "c Variable (v - 1) * %d + c + 1 means v has color c.\n",
+                 n_colors);
+  stream_printf (out, "c Filters:");
+  for (flist = filters; flist; flist = flist->next)
+    stream_printf (out, " %s", flist->data->get_type (flist->data));
+  stream_printf (out, "\n");
+  if (break_symmetry)
+    stream_printf (out, "c Symmetry breaking clauses included.\n");
+  stream_printf (out, "p cnf %ld %ld\n", (long) n * n_colors, w.n_clauses);
+
+  /* And write them */
+  w.out = out;
+  w.n_clauses = 0;
+  _cnf_write_all (&w, filters, n, break_symmetry);
+  free (w.lits);
+  if (w.failed)
+    fprintf (stderr, "Error: out of memory writing CNF.\n");
+  return !w.failed;
+}
+
+long cnf_load (sat_solver_t *solver, const filter_list *filters, int n,
+               int n_colors, bool break_symmetry)
+{
+  struct _cnf_writer w;
+
+  if (!_cnf_check_filters (filters, &break_symmetry))
+    return -1;
+
+  _cnf_writer_init (&w, NULL, solver, n_colors);
+  _cnf_write_all (&w, filters, n, break_symmetry);
+  free (w.lits);
+  if (w.failed)
+    {
+      fprintf (stderr, "Error: out of memory loading CNF into solver.\n");
+      return -1;
+    }
+  return w.n_clauses;
+}
+
+int *cnf_read_model (stream_t *in, int n_colors, int *n)
+{
+  int *rv = NULL;
+  int max_n = 0;
+  bool unsat = 0;
+  char *buf;
+
+  *n = 0;
+  while ((buf = in->read_line (in)))
+    {
+      const char *scan = buf;
+
+      while (isspace (*scan))
+        ++scan;
+      if (*scan == 'c')
+        scan = "";
+      else if (isalpha ((unsigned char) *scan))
+        {
+          /* Status line, e.g., "s UNSATISFIABLE" or "UNSAT" */
+          if (strstr (scan, "UNSAT") || strstr (scan, "unsat"))
+            unsat = 1;
+          if (*scan == 'v')
+            ++scan;
+          else
+            scan = "";
+        }
+
+      while (*scan)
+        {
+          char *end;
+          long lit = strtol (scan, &end, 10);
+          if (end == scan)
+            break;
+          scan = end;
+
+          if (lit > 0)
+            {
+              int v = (lit - 1) / n_colors + 1;
+              if (v > max_n)
+                {
+                  int new_max = v > 2 * max_n ? v : 2 * max_n;
+                  int *tmp = realloc (rv, new_max * sizeof *rv);
+                  if (tmp == NULL)
+                    {
+                      free (buf);
+                      free (rv);
+                      return NULL;
+                    }
+                  for (rv = tmp; max_n < new_max; ++max_n)
+                    rv[max_n] = -1;
+                }
+              if (rv[v - 1] < 0)
+                rv[v - 1] = (lit - 1) % n_colors;
+              if (v > *n)
+                *n = v;
+            }
+        }
+      free (buf);
+    }
+
+  if (unsat)
+    {
+      free (rv);
+      return NULL;
+    }
+  return rv;
+}
@@ -0,0 +1,78 @@
+/* RamseyScript
+ * Written in 2012 by
+ *   Andrew Poelstra <apoelstra@wpsoftware.net>
+ *
+ * To the extent possible under law, the author(s) have dedicated all
+ * copyright and related and neighboring rights to this software to
+ * the public domain worldwide. This software is distributed without
+ * any warranty.
+ *
+ * You should have received a copy of the CC0 Public Domain Dedication
+ * along with this software.
+ * If not, see <http://creativecommons.org/publicdomain/zero/1.0/>.
+ */
+
+/*! \file cnf.h
+ *  \brief Defines conversion of coloring problems to and from DIMACS CNF.
+ *
+ *  The coloring problem for [1, N] with r colors uses the variables
+ *  1 to N * r, variable (v - 1) * r + c + 1 meaning that the number v
+ *  gets color c (counting colors from 0).
+ */
+
+#ifndef CNF_H
+#define CNF_H
+
+#include "global.h"
+#include "sat.h"
+
+/*! \brief Writes the CNF for colorings of [1, n] passing the given filters.
+ *
+ *  Clauses are written as they are generated, so nothing the size of
+ *  the formula is held in memory. (They are generated twice, once to
+ *  count them for the DIMACS header.)
+ *
+ *  \param [in] out             The stream to write to.
+ *  \param [in] filters         The filters to convert.
+ *  \param [in] n               The length of the colorings.
+ *  \param [in] n_colors        The number of colors.
+ *  \param [in] break_symmetry  If nonzero, and all filters treat the colors
+ *                              alike, add clauses ruling out colorings
+ *                              which are relabellings of each other.
+ *
+ *  \return 1 on success, 0 if some filter could not be converted.
+ */
+int cnf_export (stream_t *out, const filter_list *filters, int n, int n_colors,
+                bool break_symmetry);
+
+/*! \brief Adds the clauses of cnf_export() to the built-in solver.
+ *
+ *  \param [in] solver          The solver, created with n * n_colors
+ *                              variables.
+ *  \param [in] filters         The filters to convert.
+ *  \param [in] n               The length of the colorings.
+ *  \param [in] n_colors        The number of colors.
+ *  \param [in] break_symmetry  As for cnf_export().
+ *
+ *  \return The number of clauses added, or -1 on failure.
+ */
+long cnf_load (sat_solver_t *solver, const filter_list *filters, int n,
+               int n_colors, bool break_symmetry);
+
+/*! \brief Reads a solver's model for a CNF written by cnf_export().
+ *
+ *  Accepts the usual output formats of SAT solvers: literals separated
+ *  by whitespace, possibly on lines starting with ``v'', with comment
+ *  lines starting with ``c'' and a status line.
+ *
+ *  \param [in]  in        The stream to read from.
+ *  \param [in]  n_colors  The number of colors.
+ *  \param [out] n         The number of integers colored by the model.
+ *
+ *  \return A newly allocated array of the color of each integer (indexed
+ *          from 0), -1 for those with no color, or NULL on failure or if
+ *          the solver found no model.
+ */
+int *cnf_read_model (stream_t *in, int n_colors, int *n);
+
+#endif
@@ -0,0 +1,166 @@
+/* RamseyScript
+ * Written in 2012 by
+ *   Andrew Poelstra <apoelstra@wpsoftware.net>
+ *
+ * To the extent possible under law, the author(s) have dedicated all
+ * copyright and related and neighboring rights to this software to
+ * the public domain worldwide. This software is distributed without
+ * any warranty.
+ *
+ * You should have received a copy of the CC0 Public Domain Dedication
+ * along with this software.
+ * If not, see <http://creativecommons.org/publicdomain/zero/1.0/>.
+ */
+
+/*! \file cube.c
+ *  \brief Lookahead-balanced splitting of a search into cubes.
+ *
+ *  Splitting every object at a fixed depth (as the fork target does)
+ *  gives pieces whose sizes can differ by many orders of magnitude. As
+ *  in cube-and-conquer SAT solving, this instead splits greedily: the
+ *  piece with the largest estimated tree is always the next split, so
+ *  the tree is cut deep where it is bushy and shallow where it is thin.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "global.h"
+#include "cube.h"
+#include "estimate.h"
+#include "recurse.h"
+#include "ramsey/ramsey.h"
+
+/*! \brief A piece of the search still to be done. */
+struct _cube {
+  /*! \brief The seed of the piece, at its depth in the whole tree. */
+  ramsey_t *rt;
+  /*! \brief Estimated iterations of a search from the seed. */
+  double work;
+  /*! \brief Whether the piece has no children to split it into. */
+  bool final;
+};
+
+/* Largest first */
+static int _cube_compare (const void *a, const void *b)
+{
+  const struct _cube *ca = a;
+  const struct _cube *cb = b;
+
+  if (ca->work > cb->work)
+    return -1;
+  return ca->work < cb->work;
+}
+
+/* Append a cube; returns 0 on failure, destroying the object */
+static int _cube_add (struct _cube **cube, int *n_cubes, int *max_cubes,
+                      ramsey_t *rt, int n_probes, global_data_t *state)
+{
+  if (rt == NULL)
+    return 0;
+  if (*n_cubes == *max_cubes)
+    {
+      int new_max = 2 * *max_cubes + 16;
+      void *tmp = realloc (*cube, new_max * sizeof **cube);
+      if (tmp == NULL)
+        {
+          rt->destroy (rt);
+          return 0;
+        }
+      *cube = tmp;
+      *max_cubes = new_max;
+    }
+  (*cube)[*n_cubes].rt = rt;
+  (*cube)[*n_cubes].work = estimate_size (rt, n_probes, state);
+  (*cube)[*n_cubes].final = 0;
+  ++*n_cubes;
+  return 1;
+}
+
+/* Search a cube's seed, replacing the cube by its children */
+static long _cube_open (struct _cube **cube, int *n_cubes, int *max_cubes,
+                        int index, int n_probes, global_data_t *state)
+{
+  ramsey_t *rt = (*cube)[index].rt;
+  long iterations;
+  int i, n;
+
+  /* Past max-depth there is nothing below the seed to split off */
+  if (rt->r_max_depth && rt->r_depth + 1 >= rt->r_max_depth)
+    {
+      (*cube)[index].final = 1;
+      return 0;
+    }
+
+  (*cube)[index] = (*cube)[--*n_cubes];
+
+  rt->r_iterations = 0;
+  rt->r_stall_index = 0;
+  if (recursion_preamble (rt, state))
+    {
+      n = rt->get_n_children (rt);
+      for (i = 0; i < n; ++i)
+        if (rt->child_append (rt, i))
+          {
+            if (!rt->r_prune_tree || rt->run_filters (rt))
+              if (!_cube_add (cube, n_cubes, max_cubes, rt->clone (rt),
+                              n_probes, state))
+                fprintf (stderr, "Out of memory splitting search; some cubes are lost.\n");
+            rt->child_deappend (rt, i);
+          }
+    }
+  iterations = rt->r_iterations;
+  rt->destroy (rt);
+  return iterations;
+}
+
+long cube_split (ramsey_t *rt, int n_cubes, int n_probes,
+                 manifest_t *manifest, global_data_t *state)
+{
+  struct _cube *cube = NULL;
+  ramsey_t *root = rt->clone (rt);
+  int n = 0, max = 0;
+  long iterations = 0;
+  int i;
+
+  /* The limits are for the searches of the cubes, not for splitting */
+  if (root != NULL)
+    root->r_max_iterations = root->r_stall_after = root->r_max_run_time = 0;
+  if (!_cube_add (&cube, &n, &max, root, n_probes, state))
+    {
+      fprintf (stderr, "Out of memory splitting search.\n");
+      return 0;
+    }
+
+  while (n < n_cubes && !state->kill_now)
+    {
+      int largest = -1;
+      for (i = 0; i < n; ++i)
+        if (!cube[i].final && (largest < 0 || cube[i].work > cube[largest].work))
+          largest = i;
+      if (largest < 0)
+        break;
+      iterations += _cube_open (&cube, &n, &max, largest, n_probes, state);
+    }
+
+  qsort (cube, n, sizeof *cube, _cube_compare);
+  for (i = 0; i < n; ++i)
+    {
+      stream_printf (state->out_stream, "# cube %d: est. %.4g iterations\n",
+                     i + 1, cube[i].work);
+      /* A search counts max-depth from its seed */
+      if (cube[i].rt->r_max_depth)
+        stream_printf (state->out_stream, "set max-depth %d\n",
+                       cube[i].rt->r_max_depth - cube[i].rt->r_depth);
+      stream_printf (state->out_stream, "search %ss ",
+                     cube[i].rt->get_type (cube[i].rt));
+      cube[i].rt->print (cube[i].rt, state->out_stream);
+      stream_printf (state->out_stream, "\n");
+      if (manifest && !manifest_add_job (manifest, cube[i].rt))
+        fprintf (stderr, "Out of memory writing manifest; some cubes are lost.\n");
+      cube[i].rt->destroy (cube[i].rt);
+    }
+  free (cube);
+
+  return iterations;
+}
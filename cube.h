@@ -0,0 +1,54 @@
+/* RamseyScript
+ * Written in 2012 by
+ *   Andrew Poelstra <apoelstra@wpsoftware.net>
+ *
+ * To the extent possible under law, the author(s) have dedicated all
+ * copyright and related and neighboring rights to this software to
+ * the public domain worldwide. This software is distributed without
+ * any warranty.
+ *
+ * You should have received a copy of the CC0 Public Domain Dedication
+ * along with this software.
+ * If not, see <http://creativecommons.org/publicdomain/zero/1.0/>.
+ */
+
+/*! \file cube.h
+ *  \brief Defines lookahead-balanced splitting of a search into cubes.
+ */
+
+#ifndef CUBE_H
+#define CUBE_H
+
+#include "global.h"
+#include "manifest.h"
+
+/*! \brief Splits a search into pieces ("cubes") of similar estimated size.
+ *
+ *  Starting from the seed alone, repeatedly takes the cube with the
+ *  largest estimated search tree (see estimate_size()) and replaces it
+ *  by the children a search of it would enter, until there are at least
+ *  n_cubes cubes or none of them can be split further. Large subtrees
+ *  are so split many levels deep while small ones are left whole. The
+ *  cubes are then output as ``search'' lines, largest first, each
+ *  preceded by its estimate and, if max-depth is set, by the max-depth
+ *  which makes its search stop where the whole search would.
+ *
+ *  The objects which are split are searched as they would be by
+ *  ``search'': they are run through the targets and dumps, and counted
+ *  as iterations, so that these, together with the searches of all the
+ *  cubes, cover the search tree exactly once.
+ *
+ *  \param [in] rt        The seed. Its recursion variables must have
+ *                        been set by recursion_reset(). It is left
+ *                        unchanged on return.
+ *  \param [in] n_cubes   The number of cubes wanted.
+ *  \param [in] n_probes  The number of probes to estimate each cube with.
+ *  \param [in] manifest  If not NULL, the cubes are also added to it as jobs.
+ *  \param [in] state     The global state of the program.
+ *
+ *  \return The number of objects split, i.e., iterations done.
+ */
+long cube_split (ramsey_t *rt, int n_cubes, int n_probes,
+                 manifest_t *manifest, global_data_t *state);
+
+#endif
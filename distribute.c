@@ -0,0 +1,755 @@
+/* RamseyScript
+ * Written in 2012 by
+ *   Andrew Poelstra <apoelstra@wpsoftware.net>
+ *
+ * To the extent possible under law, the author(s) have dedicated all
+ * copyright and related and neighboring rights to this software to
+ * the public domain worldwide. This software is distributed without
+ * any warranty.
+ *
+ * You should have received a copy of the CC0 Public Domain Dedication
+ * along with this software.
+ * If not, see <http://creativecommons.org/publicdomain/zero/1.0/>.
+ */
+
+/*! \file distribute.c
+ *  \brief Searches shared out between processes.
+ *
+ *  The coordinator and its workers all run the same script, so agree
+ *  on the variables, filters, targets and dumps of every search, and
+ *  number the searches the same way. Only the jobs and their results
+ *  go over the socket, as lines of text:
+ *
+ *    worker       request <search>
+ *    coordinator  job <id> <depth> <object>   or   next   or   quit
+ *    worker       output <text>               (any number of times)
+ *                 target <i> <saved state>    (for each target)
+ *                 dump <i> <saved state>      (for each dump)
+ *                 done <id> <iterations>
+ *             or  split <id>
+ *
+ *  where "next" means the search is over, "quit" that the coordinator
+ *  has finished its script, and "split" that the job
+ *  ran past split-iterations and should be split up further. Results
+ *  are held back until "done", so a job whose worker goes away can
+ *  simply be handed out again.
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <errno.h>
+#include <poll.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+#include "global.h"
+#include "buffer-stream.h"
+#include "distribute.h"
+#include "ramsey/ramsey.h"
+#include "strategy/strategy.h"
+
+/*! \brief Default number of iterations before a job is split further. */
+#define DEFAULT_SPLIT_ITERATIONS	1000000
+/*! \brief Number of times a worker tries to connect, 100ms apart. */
+#define CONNECT_TRIES	50
+/*! \brief Number of bytes read from a worker at once. */
+#define READ_CHUNK	4096
+/*! \brief Milliseconds between checks of kill_now while waiting. */
+#define POLL_TIMEOUT	1000
+
+/*! \brief State of a job. */
+enum e_job_state {
+  JOB_PENDING,
+  JOB_RUNNING,
+  JOB_DONE
+};
+
+/*! \brief A subtree to be searched by a worker. */
+struct _job {
+  /*! \brief The root of the subtree, or NULL once done. */
+  ramsey_t *prefix;
+  /*! \brief Depth of the root below the seed. */
+  int depth;
+  /*! \brief Whether it is waiting, being searched, or done. */
+  enum e_job_state state;
+};
+
+/*! \brief A worker connected to the coordinator. */
+struct _client {
+  /*! \brief The connection. */
+  int fd;
+  /*! \brief Text read and not yet handled. */
+  char *buf;
+  /*! \brief Length of the text read. */
+  size_t len;
+  /*! \brief Size of the buffer. */
+  size_t max_len;
+  /*! \brief Search the worker has asked for a job from, or -1. */
+  int want;
+  /*! \brief Job the worker is searching, or -1. */
+  int job;
+  /*! \brief Results of the job, held back until it is done. */
+  stream_t *results;
+};
+
+/*! \brief Coordinator or worker. */
+struct _distribute_t {
+  /*! \brief Whether this is the coordinator. */
+  bool coordinator;
+  /*! \brief Listening socket, or connection to the coordinator. */
+  int fd;
+  /*! \brief Name of the socket. */
+  char *path;
+  /*! \brief Number of searches started so far. */
+  int n_searches;
+  /*! \brief Whether the coordinator has gone (worker only). */
+  bool finished;
+
+  /*! \brief Connected workers (coordinator only). */
+  struct _client *client;
+  /*! \brief Number of connected workers. */
+  int n_clients;
+  /*! \brief Number of workers allocated. */
+  int max_clients;
+
+  /*! \brief Connection to the coordinator, for reading (worker only). */
+  FILE *in;
+  /*! \brief Connection to the coordinator, for writing (worker only). */
+  FILE *out;
+};
+
+/*! \brief A search being coordinated. */
+struct _search {
+  /*! \brief Number of the search in the script. */
+  int index;
+  /*! \brief The seed. */
+  ramsey_t *seed;
+  /*! \brief All jobs so far. */
+  struct _job *job;
+  /*! \brief Number of jobs. */
+  int n_jobs;
+  /*! \brief Number of jobs allocated. */
+  int max_jobs;
+  /*! \brief No job before this one is pending. */
+  int first_pending;
+  /*! \brief Number of jobs pending. */
+  int n_pending;
+  /*! \brief Number of jobs being searched. */
+  int n_running;
+  /*! \brief Iterations done by workers, and in splitting jobs. */
+  long iterations;
+};
+
+static long _get_setting (global_data_t *state, const char *name, long dflt)
+{
+  const setting_t *set = SETTING (name);
+  return set ? set->get_int_value (set) : dflt;
+}
+
+static int _send (int fd, const char *text)
+{
+  size_t len = strlen (text);
+  while (len > 0)
+    {
+      ssize_t n = write (fd, text, len);
+      if (n < 0 && errno == EINTR)
+        continue;
+      if (n <= 0)
+        return 0;
+      text += n;
+      len -= n;
+    }
+  return 1;
+}
+
+/* COORDINATOR */
+static int _add_job (struct _search *s, ramsey_t *prefix, int depth)
+{
+  if (prefix == NULL)
+    return 0;
+  if (s->n_jobs == s->max_jobs)
+    {
+      int new_max = s->max_jobs ? 2 * s->max_jobs : 64;
+      struct _job *tmp = realloc (s->job, new_max * sizeof *tmp);
+      if (tmp == NULL)
+        {
+          prefix->destroy (prefix);
+          return 0;
+        }
+      s->job = tmp;
+      s->max_jobs = new_max;
+    }
+  s->job[s->n_jobs].prefix = prefix;
+  s->job[s->n_jobs].depth = depth;
+  s->job[s->n_jobs].state = JOB_PENDING;
+  ++s->n_jobs;
+  ++s->n_pending;
+  return 1;
+}
+
+/* Walks levels further down from rt, which is at the given depth,
+ * running targets and dumps exactly as a search would, and makes a
+ * job of each object reached. */
+static void _split (struct _search *s, ramsey_t *rt, int depth, int levels,
+                    global_data_t *state)
+{
+  int i, n;
+
+  if (levels == 0)
+    {
+      if (!_add_job (s, rt->clone (rt), depth))
+        fprintf (stderr, "Out of memory splitting search; some jobs are lost.\n");
+      return;
+    }
+
+  if (!recursion_preamble (rt, state))
+    return;
+  n = rt->get_n_children (rt);
+  for (i = 0; i < n && !state->kill_now; ++i)
+    if (rt->child_append (rt, i))
+      {
+        _split (s, rt, depth + 1, levels - 1, state);
+        rt->child_deappend (rt, i);
+      }
+  recursion_postamble (rt);
+}
+
+static void _resplit (struct _search *s, int id, global_data_t *state)
+{
+  ramsey_t *prefix = s->job[id].prefix;
+  int depth = s->job[id].depth;
+
+  s->job[id].prefix = NULL;
+  s->job[id].state = JOB_DONE;
+
+  recursion_reset (prefix, state);
+  prefix->r_depth = depth;
+  _split (s, prefix, depth, 1, state);
+  s->iterations += prefix->r_iterations;
+  prefix->destroy (prefix);
+}
+
+static void _apply_results (struct _search *s, struct _client *c,
+                            global_data_t *state)
+{
+  char *line;
+
+  while ((line = c->results->read_line (c->results)))
+    {
+      int index = 0, off = 0;
+      dc_list *dlist = NULL;
+
+      line[strcspn (line, "\n")] = 0;
+      if (!strncmp (line, "output ", 7))
+        {
+          state->out_stream->write (state->out_stream, line + 7);
+          state->out_stream->write (state->out_stream, "\n");
+        }
+      else if (sscanf (line, "target %d %n", &index, &off) == 1)
+        dlist = state->targets;
+      else if (sscanf (line, "dump %d %n", &index, &off) == 1)
+        dlist = state->dumps;
+
+      while (dlist && index-- > 0)
+        dlist = dlist->next;
+      if (dlist)
+        dlist->data->merge (dlist->data, line + off, s->seed);
+      free (line);
+    }
+  buffer_stream_clear (c->results);
+}
+
+static void _drop_client (distribute_t *d, struct _search *s, int ci)
+{
+  struct _client *c = &d->client[ci];
+
+  if (c->job >= 0)
+    {
+      s->job[c->job].state = JOB_PENDING;
+      if (c->job < s->first_pending)
+        s->first_pending = c->job;
+      ++s->n_pending;
+      --s->n_running;
+    }
+  close (c->fd);
+  free (c->buf);
+  c->results->destroy (c->results);
+  d->client[ci] = d->client[--d->n_clients];
+}
+
+static void _handle_line (struct _search *s, struct _client *c, char *line,
+                          global_data_t *state)
+{
+  int id;
+  long iterations;
+
+  if (sscanf (line, "request %d", &c->want) == 1)
+    return;
+  else if (sscanf (line, "done %d %ld", &id, &iterations) == 2)
+    {
+      if (id != c->job)
+        return;
+      _apply_results (s, c, state);
+      s->iterations += iterations;
+      s->job[id].prefix->destroy (s->job[id].prefix);
+      s->job[id].prefix = NULL;
+      s->job[id].state = JOB_DONE;
+      --s->n_running;
+      c->job = -1;
+    }
+  else if (sscanf (line, "split %d", &id) == 1)
+    {
+      if (id != c->job)
+        return;
+      buffer_stream_clear (c->results);
+      --s->n_running;
+      c->job = -1;
+      _resplit (s, id, state);
+    }
+  else if (c->job >= 0)
+    {
+      c->results->write (c->results, line);
+      c->results->write (c->results, "\n");
+    }
+}
+
+/* Reads what a worker has sent; returns 0 if it has gone away */
+static int _read_client (struct _search *s, struct _client *c,
+                         global_data_t *state)
+{
+  char *start, *end;
+  ssize_t n;
+
+  if (c->len + READ_CHUNK + 1 > c->max_len)
+    {
+      size_t new_max = 2 * (c->len + READ_CHUNK + 1);
+      char *tmp = realloc (c->buf, new_max);
+      if (tmp == NULL)
+        return 0;
+      c->buf = tmp;
+      c->max_len = new_max;
+    }
+  n = read (c->fd, c->buf + c->len, READ_CHUNK);
+  if (n < 0 && errno == EINTR)
+    return 1;
+  if (n <= 0)
+    return 0;
+  c->len += n;
+  c->buf[c->len] = 0;
+
+  start = c->buf;
+  while ((end = strchr (start, '\n')))
+    {
+      *end = 0;
+      _handle_line (s, c, start, state);
+      start = end + 1;
+    }
+  c->len -= start - c->buf;
+  memmove (c->buf, start, c->len);
+  return 1;
+}
+
+static int _accept_client (distribute_t *d)
+{
+  int fd = accept (d->fd, NULL, NULL);
+  struct _client *c;
+
+  if (fd < 0)
+    return 0;
+  if (d->n_clients == d->max_clients)
+    {
+      int new_max = d->max_clients ? 2 * d->max_clients : 16;
+      struct _client *tmp = realloc (d->client, new_max * sizeof *tmp);
+      if (tmp == NULL)
+        {
+          close (fd);
+          return 0;
+        }
+      d->client = tmp;
+      d->max_clients = new_max;
+    }
+  c = &d->client[d->n_clients];
+  c->fd = fd;
+  c->buf = NULL;
+  c->len = 0;
+  c->max_len = 0;
+  c->want = -1;
+  c->job = -1;
+  c->results = buffer_stream_new ();
+  if (c->results == NULL)
+    {
+      close (fd);
+      return 0;
+    }
+  ++d->n_clients;
+  return 1;
+}
+
+/* Gives jobs to the workers asking for them */
+static void _hand_out (distribute_t *d, struct _search *s, bool over)
+{
+  stream_t *text = NULL;
+  int i;
+
+  for (i = 0; i < d->n_clients; ++i)
+    {
+      struct _client *c = &d->client[i];
+      if (c->want < 0 || c->job >= 0)
+        continue;
+
+      if (c->want < s->index || (over && c->want == s->index))
+        {
+          c->want = -1;
+          _send (c->fd, "next\n");
+        }
+      else if (c->want == s->index && s->n_pending > 0)
+        {
+          int id = s->first_pending;
+          while (s->job[id].state != JOB_PENDING)
+            ++id;
+          s->first_pending = id + 1;
+
+          if (text == NULL && (text = buffer_stream_new ()) == NULL)
+            return;
+          buffer_stream_clear (text);
+          stream_printf (text, "job %d %d ", id, s->job[id].depth);
+          s->job[id].prefix->print (s->job[id].prefix, text);
+          stream_printf (text, "\n");
+
+          s->job[id].state = JOB_RUNNING;
+          --s->n_pending;
+          ++s->n_running;
+          c->job = id;
+          c->want = -1;
+          _send (c->fd, buffer_stream_get_text (text));
+        }
+    }
+  if (text)
+    text->destroy (text);
+}
+
+static void _coordinate (distribute_t *d, ramsey_t *seed, global_data_t *state)
+{
+  struct _search s;
+  struct pollfd *pfd = NULL;
+  int i;
+
+  s.index = d->n_searches++;
+  s.seed = seed;
+  s.job = NULL;
+  s.n_jobs = s.max_jobs = 0;
+  s.first_pending = 0;
+  s.n_pending = s.n_running = 0;
+  s.iterations = 0;
+
+  _split (&s, seed, 0, _get_setting (state, "split_depth", DEFAULT_SPLIT_DEPTH), state);
+
+  while ((s.n_pending > 0 || s.n_running > 0) && !state->kill_now)
+    {
+      struct pollfd *tmp;
+      int n_clients;
+
+      _hand_out (d, &s, 0);
+
+      tmp = realloc (pfd, (d->n_clients + 1) * sizeof *pfd);
+      if (tmp == NULL)
+        break;
+      pfd = tmp;
+      pfd[0].fd = d->fd;
+      pfd[0].events = POLLIN;
+      for (i = 0; i < d->n_clients; ++i)
+        {
+          pfd[i + 1].fd = d->client[i].fd;
+          pfd[i + 1].events = POLLIN;
+        }
+      n_clients = d->n_clients;
+      if (poll (pfd, n_clients + 1, POLL_TIMEOUT) <= 0)
+        continue;
+
+      /* Go backward, since dropping a worker moves the last one */
+      for (i = n_clients - 1; i >= 0; --i)
+        if (pfd[i + 1].revents && !_read_client (&s, &d->client[i], state))
+          _drop_client (d, &s, i);
+      if (pfd[0].revents & POLLIN)
+        _accept_client (d);
+    }
+  _hand_out (d, &s, 1);
+
+  if (state->kill_now)
+    for (i = 0; i < d->n_clients; ++i)
+      if (d->client[i].job >= 0)
+        {
+          d->client[i].job = -1;
+          buffer_stream_clear (d->client[i].results);
+        }
+  for (i = 0; i < s.n_jobs; ++i)
+    if (s.job[i].prefix)
+      s.job[i].prefix->destroy (s.job[i].prefix);
+  free (s.job);
+  free (pfd);
+
+  seed->r_iterations += s.iterations;
+}
+
+distribute_t *distribute_coordinator_new (const char *path)
+{
+  distribute_t *d = malloc (sizeof *d);
+  struct sockaddr_un addr;
+
+  if (d == NULL)
+    {
+      fprintf (stderr, "Out of memory creating coordinator!\n");
+      return NULL;
+    }
+  if (strlen (path) >= sizeof addr.sun_path)
+    {
+      fprintf (stderr, "Error: socket name ``%s'' is too long.\n", path);
+      free (d);
+      return NULL;
+    }
+
+  signal (SIGPIPE, SIG_IGN);
+  memset (&addr, 0, sizeof addr);
+  addr.sun_family = AF_UNIX;
+  strcpy (addr.sun_path, path);
+  d->fd = socket (AF_UNIX, SOCK_STREAM, 0);
+  if (d->fd < 0 || bind (d->fd, (struct sockaddr *) &addr, sizeof addr) < 0 ||
+      listen (d->fd, SOMAXCONN) < 0)
+    {
+      fprintf (stderr, "Error: could not listen on ``%s'': %s.\n", path,
+               strerror (errno));
+      if (d->fd >= 0)
+        close (d->fd);
+      free (d);
+      return NULL;
+    }
+
+  d->coordinator = 1;
+  d->path = malloc (strlen (path) + 1);
+  if (d->path)
+    strcpy (d->path, path);
+  d->n_searches = 0;
+  d->finished = 0;
+  d->client = NULL;
+  d->n_clients = d->max_clients = 0;
+  d->in = d->out = NULL;
+  return d;
+}
+
+/* WORKER */
+static void _work (distribute_t *d, ramsey_t *seed, strategy_t *strategy,
+                   global_data_t *state, int id, int depth, const char *text)
+{
+  long budget = _get_setting (state, "split_iterations", DEFAULT_SPLIT_ITERATIONS);
+  stream_t *old_out = state->out_stream;
+  stream_t *out = buffer_stream_new ();
+  ramsey_t *job = seed->clone (seed);
+  bool limited = 0;
+  dc_list *dlist;
+  char *line;
+  int i;
+
+  if (out == NULL || job == NULL)
+    {
+      fprintf (stderr, "Out of memory starting job %d.\n", id);
+      if (out)
+        out->destroy (out);
+      if (job)
+        job->destroy (job);
+      /* Hand it back rather than lose it */
+      fprintf (d->out, "split %d\n", id);
+      fflush (d->out);
+      return;
+    }
+
+  for (dlist = state->dumps; dlist; dlist = dlist->next)
+    dlist->data->reset (dlist->data);
+  for (dlist = state->targets; dlist; dlist = dlist->next)
+    dlist->data->reset (dlist->data);
+
+  job->empty (job);
+  job->parse (job, text);
+  recursion_reset (job, state);
+  job->r_depth = depth;
+  if (budget > 0 && (job->r_max_iterations == 0 || budget < job->r_max_iterations))
+    {
+      job->r_max_iterations = budget;
+      limited = 1;
+    }
+
+  state->out_stream = out;
+  strategy->run (strategy, job, state);
+  state->out_stream = old_out;
+
+  if (limited && job->r_iterations >= budget)
+    fprintf (d->out, "split %d\n", id);
+  else
+    {
+      while ((line = out->read_line (out)))
+        {
+          line[strcspn (line, "\n")] = 0;
+          fprintf (d->out, "output %s\n", line);
+          free (line);
+        }
+      for (dlist = state->targets, i = 0; dlist; dlist = dlist->next, ++i)
+        {
+          buffer_stream_clear (out);
+          dlist->data->save (dlist->data, out);
+          fprintf (d->out, "target %d %s\n", i, buffer_stream_get_text (out));
+        }
+      for (dlist = state->dumps, i = 0; dlist; dlist = dlist->next, ++i)
+        {
+          buffer_stream_clear (out);
+          dlist->data->save (dlist->data, out);
+          fprintf (d->out, "dump %d %s\n", i, buffer_stream_get_text (out));
+        }
+      fprintf (d->out, "done %d %ld\n", id, job->r_iterations);
+    }
+  fflush (d->out);
+
+  out->destroy (out);
+  job->destroy (job);
+}
+
+static void _be_worker (distribute_t *d, ramsey_t *seed, strategy_t *strategy,
+                        global_data_t *state)
+{
+  int index = d->n_searches++;
+  char *line = NULL;
+  size_t max_line = 0;
+
+  while (!d->finished && !state->kill_now)
+    {
+      int id, depth, off;
+
+      fprintf (d->out, "request %d\n", index);
+      fflush (d->out);
+      if (getline (&line, &max_line, d->in) < 0)
+        {
+          fputs ("Error: lost connection to the coordinator.\n", stderr);
+          d->finished = 1;
+          break;
+        }
+      line[strcspn (line, "\n")] = 0;
+      if (!strcmp (line, "next"))
+        break;
+      if (!strcmp (line, "quit"))
+        d->finished = 1;
+      if (sscanf (line, "job %d %d %n", &id, &depth, &off) == 2)
+        _work (d, seed, strategy, state, id, depth, line + off);
+    }
+  free (line);
+}
+
+distribute_t *distribute_worker_new (const char *path)
+{
+  distribute_t *d = malloc (sizeof *d);
+  struct sockaddr_un addr;
+  int tries;
+
+  if (d == NULL)
+    {
+      fprintf (stderr, "Out of memory creating worker!\n");
+      return NULL;
+    }
+  if (strlen (path) >= sizeof addr.sun_path)
+    {
+      fprintf (stderr, "Error: socket name ``%s'' is too long.\n", path);
+      free (d);
+      return NULL;
+    }
+
+  signal (SIGPIPE, SIG_IGN);
+  memset (&addr, 0, sizeof addr);
+  addr.sun_family = AF_UNIX;
+  strcpy (addr.sun_path, path);
+  d->fd = socket (AF_UNIX, SOCK_STREAM, 0);
+  for (tries = 0; d->fd >= 0 && tries < CONNECT_TRIES; ++tries)
+    {
+      struct timespec wait = { 0, 100000000 };
+      if (connect (d->fd, (struct sockaddr *) &addr, sizeof addr) == 0)
+        break;
+      nanosleep (&wait, NULL);
+    }
+  if (d->fd < 0 || tries == CONNECT_TRIES)
+    {
+      fprintf (stderr, "Error: could not connect to ``%s'': %s.\n", path,
+               strerror (errno));
+      if (d->fd >= 0)
+        close (d->fd);
+      free (d);
+      return NULL;
+    }
+
+  d->coordinator = 0;
+  d->path = NULL;
+  d->n_searches = 0;
+  d->finished = 0;
+  d->client = NULL;
+  d->n_clients = d->max_clients = 0;
+  d->in = fdopen (d->fd, "r");
+  d->out = fdopen (dup (d->fd), "w");
+  if (d->in == NULL || d->out == NULL)
+    {
+      fputs ("Error: could not open connection to the coordinator.\n", stderr);
+      distribute_destroy (d);
+      return NULL;
+    }
+  return d;
+}
+
+/* BOTH */
+void distribute_search (distribute_t *d, ramsey_t *seed, strategy_t *strategy,
+                        global_data_t *state)
+{
+  if (d->coordinator)
+    _coordinate (d, seed, state);
+  else
+    _be_worker (d, seed, strategy, state);
+}
+
+void distribute_destroy (distribute_t *d)
+{
+  int i;
+
+  if (d == NULL)
+    return;
+  if (d->coordinator)
+    {
+      struct pollfd pfd;
+
+      /* Tell workers still connecting that there is nothing left */
+      pfd.fd = d->fd;
+      pfd.events = POLLIN;
+      while (poll (&pfd, 1, 0) > 0 && _accept_client (d))
+        ;
+      for (i = 0; i < d->n_clients; ++i)
+        {
+          _send (d->client[i].fd, "quit\n");
+          close (d->client[i].fd);
+          free (d->client[i].buf);
+          d->client[i].results->destroy (d->client[i].results);
+        }
+      free (d->client);
+      close (d->fd);
+      if (d->path)
+        unlink (d->path);
+    }
+  else
+    {
+      if (d->in)
+        fclose (d->in);
+      else
+        close (d->fd);
+      if (d->out)
+        fclose (d->out);
+    }
+  free (d->path);
+  free (d);
+}
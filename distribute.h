@@ -0,0 +1,73 @@
+/* RamseyScript
+ * Written in 2012 by
+ *   Andrew Poelstra <apoelstra@wpsoftware.net>
+ *
+ * To the extent possible under law, the author(s) have dedicated all
+ * copyright and related and neighboring rights to this software to
+ * the public domain worldwide. This software is distributed without
+ * any warranty.
+ *
+ * You should have received a copy of the CC0 Public Domain Dedication
+ * along with this software.
+ * If not, see <http://creativecommons.org/publicdomain/zero/1.0/>.
+ */
+
+/*! \file distribute.h
+ *  \brief Defines searches shared out between processes.
+ */
+
+#ifndef DISTRIBUTE_H
+#define DISTRIBUTE_H
+
+#include "global.h"
+
+/*! \brief Starts coordinating searches for workers.
+ *
+ *  \param [in] path  The name of the Unix socket to listen on.
+ *
+ *  \return A newly-allocated coordinator, or NULL (after printing an
+ *          error) on failure.
+ */
+distribute_t *distribute_coordinator_new (const char *path);
+
+/*! \brief Connects to a coordinator, to do searches for it.
+ *
+ *  If the socket does not exist yet, this keeps trying for a few
+ *  seconds, so a coordinator and its workers may be started together.
+ *
+ *  \param [in] path  The name of the coordinator's Unix socket.
+ *
+ *  \return A newly-allocated worker, or NULL (after printing an
+ *          error) on failure.
+ */
+distribute_t *distribute_worker_new (const char *path);
+
+/*! \brief Closes the connections of a coordinator or worker and frees it. */
+void distribute_destroy (distribute_t *d);
+
+/*! \brief Does a search, sharing it out between processes.
+ *
+ *  The coordinator and its workers must all run the same script, and
+ *  call this in place of the strategy's run() method for each search.
+ *
+ *  On the coordinator, the seed's tree is walked down split-depth
+ *  levels, running targets and dumps on the way, and each object at
+ *  that depth becomes a job, searched by whichever worker asks first.
+ *  The workers' targets and dumps are merged into the coordinator's,
+ *  and their iterations are added to the seed's r_iterations.
+ *
+ *  On a worker, jobs are asked for and searched with the strategy
+ *  until the coordinator says the search is over. A job which goes
+ *  past split-iterations iterations is handed back, and is split one
+ *  level further by the coordinator.
+ *
+ *  \param [in] d         The coordinator or worker.
+ *  \param [in] seed      The seed, with filters attached and recursion
+ *                        variables set by recursion_reset().
+ *  \param [in] strategy  The strategy to search each job with.
+ *  \param [in] state     The global state of the program.
+ */
+void distribute_search (distribute_t *d, ramsey_t *seed, strategy_t *strategy,
+                        global_data_t *state);
+
+#endif
@@ -23,7 +23,7 @@
 struct _dump_priv {
   data_collector_t parent;
 
-  stream_t *out;
+  stream_t *out;	/* dump-file, or NULL for the script's output */
   int size;
   long int *data;
 };
@@ -59,20 +59,56 @@ static void _dump_output  (const data_collector_t *dc, stream_t *out)
 {
   const struct _dump_priv *priv = (struct _dump_priv *) dc;
   int i;
-  (void) out;
-  priv->out->open (priv->out, STREAM_APPEND);
-  stream_printf (priv->out, "[ %ld", priv->data[1]);
+
+  if (priv->out)
+    {
+      out = priv->out;
+      out->open (out, STREAM_APPEND);
+    }
+  if (out == NULL)
+    return;
+  stream_printf (out, "[ %ld", priv->data[1]);
   for (i = 2; i < priv->size; ++i)
-    stream_printf (priv->out, ", %ld", priv->data[i]);
-  stream_printf (priv->out, " ]\n");
-  priv->out->close (priv->out);
+    stream_printf (out, ", %ld", priv->data[i]);
+  stream_printf (out, " ]\n");
+  if (priv->out)
+    out->close (out);
+}
+
+static void _dump_save (const data_collector_t *dc, stream_t *out)
+{
+  const struct _dump_priv *priv = (struct _dump_priv *) dc;
+  int i;
+  for (i = 0; i <= priv->size; ++i)
+    stream_printf (out, i ? " %ld" : "%ld", priv->data[i]);
+}
+
+static void _dump_merge (data_collector_t *dc, const char *text,
+                         const ramsey_t *proto)
+{
+  struct _dump_priv *priv = (struct _dump_priv *) dc;
+  char *end;
+  int i;
+  (void) proto;
+  for (i = 0; i <= priv->size; ++i)
+    {
+      long count = strtol (text, &end, 10);
+      if (end == text)
+        break;
+      priv->data[i] += count;
+      text = end;
+    }
 }
 
 static void _dump_destroy (data_collector_t *dc)
 {
   struct _dump_priv *priv = (struct _dump_priv *) dc;
   if (dc)
-    free (priv->data);
+    {
+      if (priv->out)
+        priv->out->destroy (priv->out);
+      free (priv->data);
+    }
   free (dc);
 }
 
@@ -92,16 +128,13 @@ void *dump_iters_per_length_new (const setting_list_t *vars)
       return NULL;
     }
   if (dump_file_set == NULL)
-    dump_stream = stdout_stream_new ();
+    dump_stream = NULL;
   else
     {
       dump_stream = file_stream_new (dump_file_set->get_text (dump_file_set));
       if (dump_stream == NULL)
-        {
-          fprintf (stderr, "Warning: could not dump to ``%s''. Using stdout instead.\n",
-                   dump_file_set->get_text (dump_file_set));
-          dump_stream = stdout_stream_new ();
-        }
+        fprintf (stderr, "Warning: could not dump to ``%s''. Using stdout instead.\n",
+                 dump_file_set->get_text (dump_file_set));
     }
   dump_depth = dump_depth_set->get_int_value (dump_depth_set);
 
@@ -110,7 +143,8 @@ void *dump_iters_per_length_new (const setting_list_t *vars)
   rv = (data_collector_t *) priv;
   if (priv == NULL)
     {
-      dump_stream->destroy (dump_stream);
+      if (dump_stream)
+        dump_stream->destroy (dump_stream);
       fprintf (stderr, "Out of memory creating dump!\n");
       return NULL;
     }
@@ -119,15 +153,18 @@ void *dump_iters_per_length_new (const setting_list_t *vars)
   priv->data = malloc ((1 + dump_depth) * sizeof *priv->data);
   if (priv->data == NULL)
     {
-      dump_stream->destroy (dump_stream);
+      if (dump_stream)
+        dump_stream->destroy (dump_stream);
       fprintf (stderr, "Out of memory creating dump!\n");
-      rv->destroy (rv);
+      free (priv);
       return NULL;
     }
 
   /* Actually setup object */
   rv->reset   = _dump_reset;
   rv->output  = _dump_output;
+  rv->save    = _dump_save;
+  rv->merge   = _dump_merge;
   rv->destroy = _dump_destroy;
   rv->get_type = _dump_get_type;
   rv->record   = _dump_record;
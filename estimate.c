@@ -0,0 +1,258 @@
+/* RamseyScript
+ * Written in 2012 by
+ *   Andrew Poelstra <apoelstra@wpsoftware.net>
+ *
+ * To the extent possible under law, the author(s) have dedicated all
+ * copyright and related and neighboring rights to this software to
+ * the public domain worldwide. This software is distributed without
+ * any warranty.
+ *
+ * You should have received a copy of the CC0 Public Domain Dedication
+ * along with this software.
+ * If not, see <http://creativecommons.org/publicdomain/zero/1.0/>.
+ */
+
+/*! \file estimate.c
+ *  \brief Knuth's estimator for the size of a search tree.
+ *
+ *  Each probe walks from the seed down to a leaf, at each level
+ *  counting the children a search would enter and descending into
+ *  one of them chosen uniformly at random. If the branching factors
+ *  along the path are d_0, d_1, ..., then d_0 d_1 ... d_(k-1) is an
+ *  unbiased estimate of the number of nodes at depth k. Averaging
+ *  over many probes gives the tree profile; the spread between
+ *  probes gives the confidence intervals.
+ */
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "global.h"
+#include "estimate.h"
+#include "ramsey/ramsey.h"
+
+/*! \brief Running sums for one estimated quantity. */
+struct _stat {
+  /*! \brief Sum over all probes. */
+  double sum;
+  /*! \brief Sum of squares over all probes. */
+  double sum_sq;
+};
+
+/*! \brief Working data for a run of the estimator. */
+struct _estimate {
+  /*! \brief Estimated iterations at each depth. */
+  struct _stat *depth;
+  /*! \brief Child index chosen at each depth of the current probe. */
+  int *path;
+  /*! \brief Number of depths allocated. */
+  int max_depth;
+  /*! \brief Deepest level any probe has reached, plus one. */
+  int n_depths;
+
+  /*! \brief Children that a search would enter at the current node. */
+  int *children;
+  /*! \brief Number of children allocated. */
+  int max_children;
+
+  /*! \brief Estimated total iterations. */
+  struct _stat total;
+  /*! \brief Estimated total number of children a search would check. */
+  struct _stat checks;
+  /*! \brief Number of children actually checked by the probes. */
+  double n_checked;
+};
+
+static void _stat_add (struct _stat *s, double x)
+{
+  s->sum += x;
+  s->sum_sq += x * x;
+}
+
+/* Mean and 95% confidence interval (normal approximation) */
+static void _stat_get (const struct _stat *s, int n,
+                       double *mean, double *low, double *high)
+{
+  double var = 0;
+
+  *mean = s->sum / n;
+  if (n > 1)
+    var = (s->sum_sq - s->sum * *mean) / (n - 1);
+  if (var < 0)
+    var = 0;
+  *low  = *mean - 1.96 * sqrt (var / n);
+  *high = *mean + 1.96 * sqrt (var / n);
+  if (*low < 0)
+    *low = 0;
+}
+
+/* Make room for `depth' levels; returns 0 on failure */
+static int _estimate_grow (struct _estimate *est, int depth)
+{
+  if (depth >= est->max_depth)
+    {
+      int new_max = 2 * depth + 64;
+      void *new_path  = realloc (est->path, new_max * sizeof *est->path);
+      void *new_depth;
+
+      if (new_path == NULL)
+        return 0;
+      est->path = new_path;
+      new_depth = realloc (est->depth, new_max * sizeof *est->depth);
+      if (new_depth == NULL)
+        return 0;
+      est->depth = new_depth;
+      while (est->max_depth < new_max)
+        {
+          est->depth[est->max_depth].sum = 0;
+          est->depth[est->max_depth].sum_sq = 0;
+          ++est->max_depth;
+        }
+    }
+  return 1;
+}
+
+/* Run a single probe, returning rt to its original state afterward */
+static void _estimate_probe (struct _estimate *est, ramsey_t *rt,
+                             global_data_t *state)
+{
+  double weight = 1;
+  double total = 0;
+  double checks = 0;
+  int depth = 0;
+  bool filter_success = rt->run_filters (rt);
+
+  /* The seed itself is rejected; the tree is empty */
+  if (rt->r_prune_tree && !filter_success)
+    {
+      _stat_add (&est->total, 0);
+      _stat_add (&est->checks, 0);
+      return;
+    }
+
+  while (!state->kill_now && _estimate_grow (est, depth))
+    {
+      int n_children, n_entered = 0;
+      int i;
+
+      /* Record this node */
+      if (filter_success)
+        {
+          _stat_add (&est->depth[depth], weight);
+          total += weight;
+        }
+      if (depth >= est->n_depths)
+        est->n_depths = depth + 1;
+
+      /* Find the children a search would enter (see recursion_preamble) */
+      if (rt->r_max_depth && rt->r_depth + depth + 1 >= rt->r_max_depth)
+        break;
+      n_children = rt->get_n_children (rt);
+      if (n_children > est->max_children)
+        {
+          void *tmp = realloc (est->children, n_children * sizeof *est->children);
+          if (tmp == NULL)
+            break;
+          est->children = tmp;
+          est->max_children = n_children;
+        }
+      for (i = 0; i < n_children; ++i)
+        if (rt->child_append (rt, i))
+          {
+            if (!rt->r_prune_tree || rt->run_filters (rt))
+              est->children[n_entered++] = i;
+            rt->child_deappend (rt, i);
+          }
+      checks += weight * n_children;
+      est->n_checked += n_children;
+
+      if (n_entered == 0)
+        break;
+
+      /* Descend into one of them at random */
+      est->path[depth] = est->children[rng_range (&state->rng, n_entered)];
+      rt->child_append (rt, est->path[depth]);
+      filter_success = rt->run_filters (rt);
+      weight *= n_entered;
+      ++depth;
+    }
+
+  _stat_add (&est->total, total);
+  _stat_add (&est->checks, checks);
+
+  /* Climb back up to the seed */
+  while (depth > 0)
+    {
+      --depth;
+      rt->child_deappend (rt, est->path[depth]);
+    }
+}
+
+static void _estimate_free (struct _estimate *est)
+{
+  free (est->depth);
+  free (est->path);
+  free (est->children);
+}
+
+double estimate_size (ramsey_t *rt, int n_probes, global_data_t *state)
+{
+  struct _estimate est = { NULL, NULL, 0, 0, NULL, 0, { 0, 0 }, { 0, 0 }, 0 };
+  double mean, low, high;
+  int i;
+
+  for (i = 0; i < n_probes && !state->kill_now; ++i)
+    _estimate_probe (&est, rt, state);
+  _estimate_free (&est);
+
+  if (i == 0)
+    return 0;
+  _stat_get (&est.total, i, &mean, &low, &high);
+  return mean;
+}
+
+void estimate_tree (ramsey_t *rt, int n_probes, global_data_t *state)
+{
+  struct _estimate est = { NULL, NULL, 0, 0, NULL, 0, { 0, 0 }, { 0, 0 }, 0 };
+  double mean, low, high;
+  double seconds;
+  clock_t start = clock ();
+  int i;
+
+  for (i = 0; i < n_probes && !state->kill_now; ++i)
+    _estimate_probe (&est, rt, state);
+  seconds = (double) (clock () - start) / CLOCKS_PER_SEC;
+  n_probes = i;
+
+  if (n_probes == 0)
+    {
+      _estimate_free (&est);
+      return;
+    }
+
+  stream_printf (state->out_stream, "Depth\tEst. iterations\t(95%% conf. interval)\n");
+  for (i = 0; i < est.n_depths; ++i)
+    {
+      _stat_get (&est.depth[i], n_probes, &mean, &low, &high);
+      stream_printf (state->out_stream, "%d\t%.4g\t(%.4g - %.4g)\n",
+                     i, mean, low, high);
+    }
+
+  _stat_get (&est.total, n_probes, &mean, &low, &high);
+  stream_printf (state->out_stream, "Est. iterations: %.4g (%.4g - %.4g)\n",
+                 mean, low, high);
+
+  /* A search does the same work per child checked as a probe does */
+  if (seconds > 0 && est.n_checked > 0)
+    {
+      double rate = est.n_checked / seconds;
+      _stat_get (&est.checks, n_probes, &mean, &low, &high);
+      stream_printf (state->out_stream,
+                     "Est. run time: %.4gs (%.4g - %.4g) at %.4g checks/s\n",
+                     mean / rate, low / rate, high / rate, rate);
+    }
+
+  _estimate_free (&est);
+}
@@ -0,0 +1,56 @@
+/* RamseyScript
+ * Written in 2012 by
+ *   Andrew Poelstra <apoelstra@wpsoftware.net>
+ *
+ * To the extent possible under law, the author(s) have dedicated all
+ * copyright and related and neighboring rights to this software to
+ * the public domain worldwide. This software is distributed without
+ * any warranty.
+ *
+ * You should have received a copy of the CC0 Public Domain Dedication
+ * along with this software.
+ * If not, see <http://creativecommons.org/publicdomain/zero/1.0/>.
+ */
+
+/*! \file estimate.h
+ *  \brief Defines the search-tree size estimator.
+ */
+
+#ifndef ESTIMATE_H
+#define ESTIMATE_H
+
+#include "global.h"
+
+/*! \brief Estimates the size of the search tree below a seed.
+ *
+ *  Runs random root-to-leaf probes through the object's search space,
+ *  using its filters and recursion limits exactly as a search would,
+ *  and outputs Knuth's unbiased estimate of the number of iterations
+ *  at each depth and in total, with 95% confidence intervals. The
+ *  probes are also timed, giving an estimate of the search run time.
+ *
+ *  Dumps and targets are not run.
+ *
+ *  \param [in] rt        The seed. Its recursion variables must have
+ *                        been set by recursion_reset(). It is left
+ *                        unchanged on return.
+ *  \param [in] n_probes  The number of probes to run.
+ *  \param [in] state     The global state of the program.
+ */
+void estimate_tree (ramsey_t *rt, int n_probes, global_data_t *state);
+
+/*! \brief Estimates the number of iterations a search from a seed takes.
+ *
+ *  As estimate_tree(), but outputs nothing, returning the mean of the
+ *  probes' estimates instead. The seed's r_depth is taken into account
+ *  when applying max-depth, so that it may lie partway down a tree.
+ *
+ *  \param [in] rt        The seed. It is left unchanged on return.
+ *  \param [in] n_probes  The number of probes to run.
+ *  \param [in] state     The global state of the program.
+ *
+ *  \return The estimated number of iterations, or 0 if no probes ran.
+ */
+double estimate_size (ramsey_t *rt, int n_probes, global_data_t *state);
+
+#endif
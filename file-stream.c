@@ -101,13 +101,14 @@ static char *_file_stream_read_line (stream_t *s)
       char *scan = rv;
       do
         {
-          char *tmp = realloc (rv, (scan - rv) + DEFAULT_READ_LEN);
+          size_t used = scan - rv;
+          char *tmp = realloc (rv, used + DEFAULT_READ_LEN);
           if (tmp == NULL)
             {
               free (rv);
               return NULL;
             }
-          scan = tmp + (scan - rv);
+          scan = tmp + used;
           rv = tmp;
 
           scan[DEFAULT_READ_LEN - 1] = '\n';
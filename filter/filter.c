@@ -123,6 +123,10 @@ filter_t *filter_new_custom (const char *name,
   if (rv != NULL)
     {
       rv->run = run;
+      rv->get_allowed_cells = NULL;
+      rv->get_allowed_values = NULL;
+      rv->explain = NULL;
+      rv->get_constraints = NULL;
       rv->get_symmetry = _filter_get_symmetry;
       rv->get_type = _filter_custom_get_type;
       rv->supports = _filter_custom_supports;
@@ -134,6 +138,21 @@ filter_t *filter_new_custom (const char *name,
   return rv;
 }
 
+unsigned long filter_get_allowed_values (const filter_t *f, const ramsey_t *rt,
+                                         const int *values, int n_values)
+{
+  unsigned long rv = CELL_MASK_ALL (n_values);
+  int i;
+
+  if (f->get_allowed_values)
+    return f->get_allowed_values (f, rt, values, n_values);
+  if (f->get_allowed_cells)
+    for (i = 0; i < n_values && i < CELL_MASK_BITS; ++i)
+      if (!(f->get_allowed_cells (f, rt, values[i]) & 1))
+        rv &= ~(1UL << i);
+  return rv;
+}
+
 filter_t *filter_new_generic ()
 {
   filter_t *rv = malloc (sizeof *rv);
@@ -144,6 +163,10 @@ filter_t *filter_new_generic ()
     }
 
   rv->get_symmetry = _filter_get_symmetry;
+  rv->get_allowed_cells = NULL;
+  rv->get_allowed_values = NULL;
+  rv->explain = NULL;
+  rv->get_constraints = NULL;
   rv->clone   = _filter_clone;
   rv->destroy = _filter_destroy;
   return rv;
@@ -55,6 +55,52 @@ struct _filter_t {
    *  Returns 1 if the object is okay, 0 if it's not.
    */
   bool (*run)      (const filter_t *, const ramsey_t *);
+  /*! \brief Returns a mask of the cells of a ramsey object into which a
+   *         value could be added without failing the filter.
+   *
+   *  This may be NULL if the filter cannot predict its result. See the
+   *  get_allowed_cells() method of ramsey_t for the meaning of the mask.
+   */
+  unsigned long (*get_allowed_cells) (const filter_t *, const ramsey_t *, int value);
+  /*! \brief Returns a mask of which of several values could be appended
+   *         to a ramsey object without failing the filter.
+   *
+   *  This may be NULL, in which case get_allowed_cells() is used for each
+   *  value in turn (if it is available). See the get_allowed_values()
+   *  method of ramsey_t for the meaning of the mask.
+   */
+  unsigned long (*get_allowed_values) (const filter_t *, const ramsey_t *,
+                                       const int *values, int n_values);
+  /*! \brief Explains why a value could not be added to a cell of a ramsey
+   *         object without failing the filter.
+   *
+   *  Stores the values already in the object which, together with the new
+   *  value, violate the filter, and returns how many there are. Where there
+   *  are several violations, the one whose latest-added value was added
+   *  earliest is reported. Returns -1 if the filter would accept the value,
+   *  or if the explanation would need more than max_values values.
+   *
+   *  The reported values must violate the filter whatever else is in the
+   *  object, so filters which look at, e.g., the last value of each cell
+   *  cannot explain themselves this way.
+   *
+   *  This may be NULL if the filter cannot explain itself.
+   */
+  int (*explain) (const filter_t *, const ramsey_t *, int value, int cell,
+                  int *values, int max_values);
+  /*! \brief Lists the constraints the filter places on colorings of [1, n],
+   *         so they can be handed to other solvers.
+   *
+   *  Calls emit once for each set of values which may not be colored
+   *  with the given cells (one per value), or, if cells is NULL, which
+   *  may not all have the same color.
+   *
+   *  This may be NULL if the filter's constraints cannot be listed.
+   */
+  void (*get_constraints) (const filter_t *, int n, int n_colors,
+                           void (*emit) (void *data, const int *values,
+                                         const int *cells, int n_values),
+                           void *data);
 
   /*! \brief Whether the filter affects to all colors the same way (for colorings). */
   bool (*get_symmetry) (const filter_t *);
@@ -87,6 +133,16 @@ filter_t *filter_new (const char *data, const setting_list_t *vars);
 filter_t *filter_new_custom (const char *name,
                              bool (*run) (const filter_t *f, const ramsey_t *));
 
+/*! \brief Determine which of several values could be appended to an object.
+ *
+ * This calls the filter's get_allowed_values() method, falling back to
+ * get_allowed_cells() on each value if the former is not available.
+ *
+ * \return A mask with bit i set if values[i] might pass the filter.
+ */
+unsigned long filter_get_allowed_values (const filter_t *f, const ramsey_t *rt,
+                                         const int *values, int n_values);
+
 /*! \brief Create a blank filter.
  *
  * This is used by other filters, and wraps up some of the boilerplate
@@ -72,6 +72,62 @@ static bool cheap_check_gap_set (const filter_t *f, const ramsey_t *rt)
   return (len < 2 || gaps->find_value (gaps, data[len - 1] - data[len - 2]));
 }
 
+/* Whether value may follow the last element of seq, given the gap set gaps */
+static bool _gap_allowed (const ramsey_t *seq, const ramsey_t *gaps, int value)
+{
+  const int *data = seq->get_priv_data_const (seq);
+  int len = seq->get_length (seq);
+
+  return (len < 1 || gaps->find_value (gaps, value - data[len - 1]));
+}
+
+static unsigned long allowed_cells_gap_set (const filter_t *f, const ramsey_t *rt,
+                                            int value)
+{
+  struct _priv *priv = (struct _priv *) f;
+  const ramsey_t **gap_cells = NULL;
+  int n_gap_cells = 0;
+  unsigned long rv = 0;
+
+  assert (f != NULL);
+  assert (rt != NULL);
+
+  if (priv->gap_set->type == TYPE_COLORING)
+    {
+      gap_cells = (const ramsey_t **) priv->gap_set->get_priv_data_const (priv->gap_set);
+      n_gap_cells = priv->gap_set->get_n_cells (priv->gap_set);
+    }
+
+  if (rt->type == TYPE_COLORING)
+    {
+      const ramsey_t **cells = (const ramsey_t **) rt->get_priv_data_const (rt);
+      int n_cells = rt->get_n_cells (rt);
+      int i;
+
+      if (n_cells > CELL_MASK_BITS)
+        n_cells = CELL_MASK_BITS;
+      for (i = 0; i < n_cells; ++i)
+        {
+          const ramsey_t *gaps = priv->gap_set;
+          if (gap_cells != NULL)
+            {
+              if (i >= n_gap_cells)
+                {
+                  rv |= 1UL << i;
+                  continue;
+                }
+              gaps = gap_cells[i];
+            }
+          if (_gap_allowed (cells[i], gaps, value))
+            rv |= 1UL << i;
+        }
+    }
+  else
+    rv = _gap_allowed (rt, gap_cells ? gap_cells[0] : priv->gap_set, value);
+
+  return rv;
+}
+
 /* end ACTUAL FILTER CODE */
 static const char *_filter_get_type (const filter_t *flt)
 {
@@ -166,6 +222,10 @@ void *filter_gap_set_new (const setting_list_t *vars)
   rv->supports = _filter_supports;
   rv->set_mode = _filter_set_mode;
   rv->run  = cheap_check_gap_set;
+  rv->get_allowed_cells = allowed_cells_gap_set;
+  rv->get_allowed_values = NULL;
+  rv->explain = NULL;
+  rv->get_constraints = NULL;
   return priv;
 }
 
@@ -53,6 +53,67 @@ static bool cheap_check_3_ap (const filter_t *f, const ramsey_t *rt)
   return 1;
 }
 
+static unsigned long allowed_cells_3_ap (const filter_t *f, const ramsey_t *rt,
+                                         int value)
+{
+  int len = rt->get_length (rt);
+  const int *val = rt->get_priv_data_const (rt);
+  int i, j;
+
+  assert (val != NULL);
+  (void) f;
+
+  for (i = 0; i < len; ++i)
+    for (j = i + 1; j < len; ++j)
+      if (2 * val[j] == val[i] + value)
+        return 0;
+  return 1;
+}
+
+static int explain_3_ap (const filter_t *f, const ramsey_t *rt, int value,
+                         int cell, int *values, int max_values)
+{
+  int len = rt->get_length (rt);
+  const int *val = rt->get_priv_data_const (rt);
+  int i, j;
+
+  assert (val != NULL);
+  (void) f;
+  (void) cell;
+
+  if (max_values < 2)
+    return -1;
+  /* Find the 3-AP whose later member was added first */
+  for (j = 1; j < len; ++j)
+    for (i = 0; i < j; ++i)
+      if (2 * val[j] == val[i] + value)
+        {
+          values[0] = val[i];
+          values[1] = val[j];
+          return 2;
+        }
+  return -1;
+}
+
+static void constraints_3_ap (const filter_t *f, int n, int n_colors,
+                              void (*emit) (void *, const int *, const int *, int),
+                              void *data)
+{
+  int ap[3];
+  int gap;
+
+  (void) f;
+  (void) n_colors;
+
+  for (ap[0] = 1; ap[0] + 2 <= n; ++ap[0])
+    for (gap = 1; ap[0] + 2 * gap <= n; ++gap)
+      {
+        ap[1] = ap[0] + gap;
+        ap[2] = ap[1] + gap;
+        emit (data, ap, NULL, 3);
+      }
+}
+
 /* end ACTUAL FILTER CODE */
 static const char *_filter_get_type (const filter_t *flt)
 {
@@ -89,6 +150,9 @@ void *filter_3_ap_new (const setting_list_t *vars)
   rv->supports = _filter_supports;
   rv->set_mode = _filter_set_mode;
   rv->run  = cheap_check_3_ap;
+  rv->get_allowed_cells = allowed_cells_3_ap;
+  rv->explain = explain_3_ap;
+  rv->get_constraints = constraints_3_ap;
   return rv;
 }
 
@@ -42,6 +42,42 @@ static bool cheap_check_additive_square (const filter_t *f, const ramsey_t *rt)
   return 1;
 }
 
+/* Appending v creates an additive square of half-length i exactly when
+ * v is the difference between the sum of the i values before the last
+ * i - 1 values, and the sum of those last i - 1 values. So all
+ * candidates can be checked at once with running sums. */
+static unsigned long allowed_values_additive_square (const filter_t *f,
+                                                     const ramsey_t *rt,
+                                                     const int *values,
+                                                     int n_values)
+{
+  int  len = rt->get_length (rt);
+  const int *val = rt->get_priv_data_const (rt);
+  unsigned long rv = CELL_MASK_ALL (n_values);
+  int i, k, sum1, sum2;
+
+  (void) f;
+
+  if (len == 0)
+    return rv;
+
+  /* sum1 covers val[len - i + 1 .. len - 1], sum2 val[len - 2i + 1 .. len - i] */
+  sum1 = 0;
+  sum2 = val[len - 1];
+  for (i = 1; 2 * i <= len + 1 && rv; ++i)
+    {
+      for (k = 0; k < n_values && k < CELL_MASK_BITS; ++k)
+        if (values[k] == sum2 - sum1)
+          rv &= ~(1UL << k);
+
+      if (2 * (i + 1) > len + 1)
+        break;
+      sum1 += val[len - i];
+      sum2 += val[len - 2 * i] + val[len - 2 * i - 1] - val[len - i];
+    }
+  return rv;
+}
+
 static const char *_filter_get_type (const filter_t *flt)
 {
   (void) flt;
@@ -74,6 +110,7 @@ void *filter_additive_square_new (const setting_list_t *vars)
   rv->supports = _filter_supports;
   rv->set_mode = _filter_set_mode;
   rv->run  = cheap_check_additive_square;
+  rv->get_allowed_values = allowed_values_additive_square;
 
   return rv;
 }
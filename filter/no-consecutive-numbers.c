@@ -48,6 +48,22 @@ static bool cheap_check_consecutive (const filter_t *f, const ramsey_t *rt)
   return 1;
 }
 
+static void constraints_consecutive (const filter_t *f, int n, int n_colors,
+                                     void (*emit) (void *, const int *, const int *, int),
+                                     void *data)
+{
+  int pair[2];
+
+  (void) f;
+  (void) n_colors;
+
+  for (pair[0] = 1; pair[0] < n; ++pair[0])
+    {
+      pair[1] = pair[0] + 1;
+      emit (data, pair, NULL, 2);
+    }
+}
+
 static const char *_filter_get_type (const filter_t *flt)
 {
   (void) flt;
@@ -82,6 +98,7 @@ void *filter_consecutive_new (const setting_list_t *vars)
   rv->supports = _filter_supports;
   rv->set_mode = _filter_set_mode;
   rv->run  = cheap_check_consecutive;
+  rv->get_constraints = constraints_consecutive;
 
   return rv;
 }
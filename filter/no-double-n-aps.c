@@ -88,6 +88,12 @@ static const char *_filter_get_type (const filter_t *flt)
   return priv->name;
 }
 
+static bool _filter_get_symmetry (const filter_t *flt)
+{
+  (void) flt;
+  return 1;
+}
+
 static bool _filter_supports (const filter_t *flt, e_ramsey_type type)
 {
   (void) flt;
@@ -144,9 +150,14 @@ void *filter_double_n_ap_new (const setting_list_t *vars)
       rv->destroy  = _filter_destroy;
       rv->clone    = _filter_clone;
       rv->get_type = _filter_get_type;
+      rv->get_symmetry = _filter_get_symmetry;
       rv->supports = _filter_supports;
       rv->set_mode = _filter_set_mode;
       rv->run  = cheap_check_double_n_ap;
+      rv->get_allowed_cells = NULL;
+      rv->get_allowed_values = NULL;
+      rv->explain = NULL;
+      rv->get_constraints = NULL;
       return rv;
     }
 }
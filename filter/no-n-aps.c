@@ -76,21 +76,78 @@ static bool check_n_ap (const filter_t *flt, const ramsey_t *rt)
   return !found;
 }
 
+/* Checks whether appending value to val[0..len) would complete an n-AP */
+static bool _completes_n_ap (const struct _priv *priv, const int *val, int len,
+                             int value)
+{
+  int i, gap;
+  int min, max, max_gap = 0;
+  bool found = 0;
+
+  min = max = value;
+  for (i = 0; i < len; ++i)
+    {
+      if (val[i] < min)
+        min = val[i];
+      if (val[i] > max)
+        max = val[i];
+    }
+  max_gap = (max - min + 1) / (priv->ap_length - 1) + 1;
+
+  for (gap = -max_gap; gap <= max_gap && !found; ++gap)
+    found = _check_recurse (val, len, value - gap, gap, priv->ap_length - 1);
+
+  return found;
+}
+
 static bool cheap_check_n_ap (const filter_t *flt, const ramsey_t *rt)
 {
   const struct _priv *priv = (struct _priv *) flt;
   int len = rt->get_length (rt);
   const int *val = rt->get_priv_data_const (rt);
-  int i, gap;
-  int min, max, max_gap = 0;
-  bool found = 0;
 
   assert (val != NULL);
 
   if (priv->ap_length == 1)
     return (len == 0);
+  if (len == 0)
+    return 1;
 
-  min = max = val[0];
+  return !_completes_n_ap (priv, val, len - 1, val[len - 1]);
+}
+
+static unsigned long allowed_cells_n_ap (const filter_t *flt, const ramsey_t *rt,
+                                         int value)
+{
+  const struct _priv *priv = (struct _priv *) flt;
+  const int *val = rt->get_priv_data_const (rt);
+
+  assert (val != NULL);
+
+  if (priv->ap_length == 1)
+    return 0;
+  return !_completes_n_ap (priv, val, rt->get_length (rt), value);
+}
+
+static int explain_n_ap (const filter_t *flt, const ramsey_t *rt, int value,
+                         int cell, int *values, int max_values)
+{
+  const struct _priv *priv = (struct _priv *) flt;
+  int len = rt->get_length (rt);
+  const int *val = rt->get_priv_data_const (rt);
+  int i, gap, max_gap;
+  int min, max;
+  int best_last = len;
+
+  assert (val != NULL);
+  (void) cell;
+
+  if (priv->ap_length == 1)
+    return 0;
+  if (priv->ap_length - 1 > max_values)
+    return -1;
+
+  min = max = value;
   for (i = 0; i < len; ++i)
     {
       if (val[i] < min)
@@ -100,10 +157,60 @@ static bool cheap_check_n_ap (const filter_t *flt, const ramsey_t *rt)
     }
   max_gap = (max - min + 1) / (priv->ap_length - 1) + 1;
 
-  for (gap = -max_gap; gap <= max_gap && !found; ++gap)
-    found = _check_recurse (val, len, val[len - 1] - gap, gap, priv->ap_length - 1);
+  /* As in _check_recurse, but remember where each member was found, and
+   * keep the AP whose latest member comes earliest */
+  for (gap = -max_gap; gap <= max_gap; ++gap)
+    {
+      int last = -1, end = len, k;
+      if (gap == 0)
+        continue;
+      for (k = 1; k < priv->ap_length; ++k)
+        {
+          for (i = end - 1; i >= 0; --i)
+            if (val[i] == value - k * gap)
+              break;
+          if (i < 0)
+            break;
+          if (k == 1)
+            last = i;
+          end = i;
+        }
+      if (k == priv->ap_length && last < best_last)
+        {
+          best_last = last;
+          for (k = 1; k < priv->ap_length; ++k)
+            values[k - 1] = value - k * gap;
+        }
+    }
 
-  return !found;
+  return best_last < len ? priv->ap_length - 1 : -1;
+}
+
+static void constraints_n_ap (const filter_t *flt, int n, int n_colors,
+                              void (*emit) (void *, const int *, const int *, int),
+                              void *data)
+{
+  const struct _priv *priv = (struct _priv *) flt;
+  int len = priv->ap_length;
+  int *ap = malloc (len * sizeof *ap);
+  int start, gap, i;
+
+  (void) n_colors;
+  if (ap == NULL)
+    return;
+
+  if (len == 1)
+    for (ap[0] = 1; ap[0] <= n; ++ap[0])
+      emit (data, ap, NULL, 1);
+  else
+    for (start = 1; start + len - 1 <= n; ++start)
+      for (gap = 1; start + (len - 1) * gap <= n; ++gap)
+        {
+          for (i = 0; i < len; ++i)
+            ap[i] = start + i * gap;
+          emit (data, ap, NULL, len);
+        }
+  free (ap);
 }
 
 /* end ACTUAL FILTER CODE */
@@ -113,6 +220,12 @@ static const char *_filter_get_type (const filter_t *flt)
   return priv->name;
 }
 
+static bool _filter_get_symmetry (const filter_t *flt)
+{
+  (void) flt;
+  return 1;
+}
+
 static bool _filter_supports (const filter_t *flt, e_ramsey_type type)
 {
   (void) flt;
@@ -169,9 +282,14 @@ void *filter_n_ap_new (const setting_list_t *vars)
       rv->destroy  = _filter_destroy;
       rv->clone    = _filter_clone;
       rv->get_type = _filter_get_type;
+      rv->get_symmetry = _filter_get_symmetry;
       rv->supports = _filter_supports;
       rv->set_mode = _filter_set_mode;
       rv->run  = cheap_check_n_ap;
+      rv->get_allowed_cells = allowed_cells_n_ap;
+      rv->get_allowed_values = NULL;
+      rv->explain = explain_n_ap;
+      rv->get_constraints = constraints_n_ap;
       return rv;
     }
 }
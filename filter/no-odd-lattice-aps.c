@@ -18,47 +18,92 @@
 
 #include "filter.h"
 
-/* No odd-length AP's (on lattices) */
-static bool cheap_check_odd_lattice_ap (const filter_t *f, const ramsey_t *rt)
+/* Checks the lines of wid cells running back from position len of the
+ * lattice, with the cell at len taken to hold new_val; a line of cells
+ * all of one color is an AP. The value at len itself is not read, so
+ * that candidate values may be checked before they are appended. */
+static bool _check_lines (const int *val, int len, int wid, int new_val)
 {
-  int len = rt->get_maximum (rt);
-  int wid = rt->get_n_cells (rt);
   int i;
   int gap;
-  const int *val = rt->get_priv_data_const (rt);
 
-  (void) f;
-
-  /* Only AP's involving the latest addition */
+  /* A single cell is no AP */
+  if (wid < 2)
+    return 1;
 
-  --len;  /* array is zero-indexed, so adjust len */
+  /* Each line reads back to len + (wid - 1)*gap, so stop before that
+   * falls off the start of the lattice. */
 
   /* Start pointing immediately down and right, then two down
    *  one right, three down one right, ... */
-  for (gap = -wid + 1; len + 3*gap > 0; gap -= 4)
-    for (i = 1; i < wid; ++i)
-      {
-        /* A change in color means, no an AP */
-        if (val[len + i*gap] != val[len + (i + 1)*gap])
-          continue;
-        /* NO change in color means, FOUND an AP */
+  for (gap = -wid + 1; len + (wid - 1)*gap >= 0; gap -= 4)
+    {
+      /* A change in color means, no an AP */
+      for (i = 1; i < wid; ++i)
+        if (val[len + i*gap] != new_val)
+          break;
+      /* NO change in color means, FOUND an AP */
+      if (i == wid)
         return 0;
-      }
+    }
   /* Start pointing immediately left, then one down one left,
    *  then two down one left, three down one left, ... */
-  for (gap = -1; len + 3*gap >= 0; gap -= 4)
-    for (i = 1; i < wid; ++i)
-      {
-        /* A change in color means, no an AP */
-        if (val[len + i*gap] != val[len + (i + 1)*gap])
-          continue;
-        /* NO change in color means, FOUND an AP */
+  for (gap = -1; len + (wid - 1)*gap >= 0; gap -= 4)
+    {
+      /* A change in color means, no an AP */
+      for (i = 1; i < wid; ++i)
+        if (val[len + i*gap] != new_val)
+          break;
+      /* NO change in color means, FOUND an AP */
+      if (i == wid)
         return 0;
-      }
+    }
 
   return 1;
 }
 
+/* No odd-length AP's (on lattices) */
+static bool cheap_check_odd_lattice_ap (const filter_t *f, const ramsey_t *rt)
+{
+  const int *val = rt->get_priv_data_const (rt);
+  int len = rt->get_maximum (rt) - 1;
+
+  (void) f;
+
+  /* Only AP's involving the latest addition; the array is zero-indexed,
+   * so that is at get_maximum() - 1 */
+  if (len < 0)
+    return 1;
+  return _check_lines (val, len, rt->get_n_cells (rt), val[len]);
+}
+
+/* Checks each candidate value for the next cell in turn, without
+ * appending it. */
+static unsigned long allowed_values_odd_lattice_ap (const filter_t *f,
+                                                    const ramsey_t *rt,
+                                                    const int *values,
+                                                    int n_values)
+{
+  const int *val;
+  unsigned long rv = 0;
+  int len, wid;
+  int i;
+
+  (void) f;
+
+  /* For other types, the next cell depends on the value appended */
+  if (rt->type != TYPE_LATTICE)
+    return CELL_MASK_ALL (n_values);
+
+  val = rt->get_priv_data_const (rt);
+  len = rt->get_maximum (rt);
+  wid = rt->get_n_cells (rt);
+  for (i = 0; i < n_values && i < CELL_MASK_BITS; ++i)
+    if (_check_lines (val, len, wid, values[i]))
+      rv |= 1UL << i;
+  return rv;
+}
+
 /* end ACTUAL FILTER CODE */
 static const char *_filter_get_type (const filter_t *flt)
 {
@@ -94,6 +139,7 @@ void *filter_odd_lattice_ap_new (const setting_list_t *vars)
   rv->supports = _filter_supports;
   rv->set_mode = _filter_set_mode;
   rv->run  = cheap_check_odd_lattice_ap;
+  rv->get_allowed_values = allowed_values_odd_lattice_ap;
 
   return rv;
 }
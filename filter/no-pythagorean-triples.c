@@ -57,6 +57,34 @@ static bool cheap_check_pythag (const filter_t *f, const ramsey_t *rt)
   return 1;
 }
 
+static void constraints_pythag (const filter_t *f, int n, int n_colors,
+                                void (*emit) (void *, const int *, const int *, int),
+                                void *data)
+{
+  int triple[3];
+
+  (void) f;
+  (void) n_colors;
+
+  for (triple[2] = 1; triple[2] <= n; ++triple[2])
+    {
+      long c2 = (long) triple[2] * triple[2];
+      /* Walk a up and b down, looking for a^2 + b^2 = c^2 with a < b */
+      triple[0] = 1;
+      triple[1] = triple[2] - 1;
+      while (triple[0] < triple[1])
+        {
+          long sum = (long) triple[0] * triple[0] + (long) triple[1] * triple[1];
+          if (sum == c2)
+            emit (data, triple, NULL, 3);
+          if (sum <= c2)
+            ++triple[0];
+          else
+            --triple[1];
+        }
+    }
+}
+
 /* end ACTUAL FILTER CODE */
 static const char *_filter_get_type (const filter_t *flt)
 {
@@ -93,6 +121,7 @@ void *filter_pythag_new (const setting_list_t *vars)
   rv->supports = _filter_supports;
   rv->set_mode = _filter_set_mode;
   rv->run  = cheap_check_pythag;
+  rv->get_constraints = constraints_pythag;
   return rv;
 }
 
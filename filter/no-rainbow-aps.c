@@ -80,18 +80,103 @@ static bool cheap_check_rainbow (const filter_t *f, const ramsey_t *rt)
         else
           /* not a rainbow AP */
           break;
-        /* did we get through the entire AP without seeing a color twice? */
-        if (j == ap_length)
-          {
-            free (count);
-            return 0;
-          }
-     }
+      /* did we get through the entire AP without seeing a color twice? */
+      if (j == ap_length)
+        {
+          free (count);
+          return 0;
+        }
+    }
 
   free (count);
   return 1;
 }
 
+/* Each AP ending at the new position whose other elements all have
+ * distinct colors is missing exactly one color, which is then ruled out
+ * for the new position. Colors are tracked as a bitmask, so all of them
+ * are handled in one pass over the gap sizes. */
+static unsigned long allowed_cells_rainbow (const filter_t *f, const ramsey_t *rt,
+                                            int value)
+{
+  int ap_length  = rt->get_n_cells (rt);
+  int col_length = rt->get_length (rt);
+  const int *col = rt->get_alt_priv_data_const (rt);
+  unsigned long rv = CELL_MASK_ALL (ap_length);
+  int i, j;
+
+  assert (f);
+  assert (rt && rt->type == TYPE_COLORING);
+  (void) value;
+
+  if (ap_length > CELL_MASK_BITS)
+    return rv;
+
+  /* loop i over gap sizes */
+  for (i = 1; col_length + 1 - (ap_length - 1) * i > 0 && rv; ++i)
+    {
+      unsigned long seen = 0;
+      /* loop j over the existing part of the AP */
+      for (j = 1; j < ap_length; ++j)
+        {
+          unsigned long bit = 1UL << col[col_length - j * i];
+          if (seen & bit)
+            break;
+          seen |= bit;
+        }
+      if (j == ap_length)
+        rv &= seen;
+    }
+
+  return rv;
+}
+
+/* Emits ap with every assignment of distinct colors to cells[k..] */
+static void _rainbow_permute (const int *ap, int *cells, int k, int len,
+                              void (*emit) (void *, const int *, const int *, int),
+                              void *data)
+{
+  int i, tmp;
+
+  if (k == len)
+    {
+      emit (data, ap, cells, len);
+      return;
+    }
+  for (i = k; i < len; ++i)
+    {
+      tmp = cells[k]; cells[k] = cells[i]; cells[i] = tmp;
+      _rainbow_permute (ap, cells, k + 1, len, emit, data);
+      tmp = cells[k]; cells[k] = cells[i]; cells[i] = tmp;
+    }
+}
+
+static void constraints_rainbow (const filter_t *f, int n, int n_colors,
+                                 void (*emit) (void *, const int *, const int *, int),
+                                 void *data)
+{
+  int *ap = malloc (n_colors * sizeof *ap);
+  int *cells = malloc (n_colors * sizeof *cells);
+  int start, gap, i;
+
+  (void) f;
+
+  if (ap != NULL && cells != NULL)
+    for (start = 1; start + n_colors - 1 <= n; ++start)
+      for (gap = 1; start + (n_colors - 1) * gap <= n &&
+                    (gap == 1 || n_colors > 1); ++gap)
+        {
+          for (i = 0; i < n_colors; ++i)
+            {
+              ap[i] = start + i * gap;
+              cells[i] = i;
+            }
+          _rainbow_permute (ap, cells, 0, n_colors, emit, data);
+        }
+  free (ap);
+  free (cells);
+}
+
 static const char *_filter_get_type (const filter_t *flt)
 {
   (void) flt;
@@ -125,6 +210,8 @@ void *filter_rainbow_ap_new (const setting_list_t *vars)
   rv->supports = _filter_supports;
   rv->set_mode = _filter_set_mode;
   rv->run  = cheap_check_rainbow;
+  rv->get_allowed_cells = allowed_cells_rainbow;
+  rv->get_constraints = constraints_rainbow;
 
   return rv;
 }
@@ -57,6 +57,28 @@ static bool cheap_check_schur (const filter_t *f, const ramsey_t *rt)
   return 1;
 }
 
+static void constraints_schur (const filter_t *f, int n, int n_colors,
+                               void (*emit) (void *, const int *, const int *, int),
+                               void *data)
+{
+  int sol[3];
+
+  (void) f;
+  (void) n_colors;
+
+  for (sol[0] = 1; 2 * sol[0] <= n; ++sol[0])
+    {
+      /* x + x = 2x */
+      sol[1] = 2 * sol[0];
+      emit (data, sol, NULL, 2);
+      for (sol[1] = sol[0] + 1; sol[0] + sol[1] <= n; ++sol[1])
+        {
+          sol[2] = sol[0] + sol[1];
+          emit (data, sol, NULL, 3);
+        }
+    }
+}
+
 /* end ACTUAL FILTER CODE */
 static const char *_filter_get_type (const filter_t *flt)
 {
@@ -93,6 +115,7 @@ void *filter_schur_new (const setting_list_t *vars)
   rv->supports = _filter_supports;
   rv->set_mode = _filter_set_mode;
   rv->run  = cheap_check_schur;
+  rv->get_constraints = constraints_schur;
   return rv;
 }
 
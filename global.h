@@ -26,8 +26,12 @@ typedef struct _ramsey_t ramsey_t;
 typedef struct _filter_t filter_t;
 /*! \brief Convienence typedef for targets and dumps. */
 typedef struct _data_collector_t data_collector_t;
+/*! \brief Convienence typedef for search strategies. */
+typedef struct _strategy_t strategy_t;
 /*! \brief Convienence typedef for global context. */
 typedef struct _global_data global_data_t;
+/*! \brief Convienence typedef for distributed search coordinators and workers. */
+typedef struct _distribute_t distribute_t;
 /*! \brief C boolean ;) */
 typedef int bool;
 
@@ -49,8 +53,11 @@ typedef enum _e_setting_type {
   TYPE_STRING         /*!< String -- anything else. */
 } e_setting_type;
 
+#include <pthread.h>
+
 #include "dump/dump.h"
 #include "filter/filter.h"
+#include "rng.h"
 #include "setting.h"
 #include "stream.h"
 
@@ -80,6 +87,11 @@ struct _data_collector_t {
   int  (*record)  (data_collector_t *, const ramsey_t *, stream_t *);
   /*! \brief Print collector state. */
   void (*output)  (const data_collector_t *, stream_t *);
+  /*! \brief Write collector state as a single line, for merge(). */
+  void (*save)    (const data_collector_t *, stream_t *);
+  /*! \brief Add in the state another copy of the collector wrote with
+   *         save(), given an empty object of the searched type. */
+  void (*merge)   (data_collector_t *, const char *, const ramsey_t *);
   /*! \brief Destroy collector and release associated resources. */
   void (*destroy) (data_collector_t *);
 };
@@ -117,7 +129,22 @@ struct _global_data {
   /*! \brief If we are reading from stdin, output friendlier messages. */
   bool interactive;
   /*! \brief Hook for 'Stop' command from threads or signals. */
-  bool kill_now;
+  volatile bool kill_now;
+  /*! \brief If not NULL, held while recording objects in the targets
+   *         and dumps, so that another thread may read them. */
+  pthread_mutex_t *record_lock;
+  /*! \brief Iterations of the running search so far, kept up to date
+   *         with record_lock held, so that another thread may read it. */
+  long progress;
+
+  /*! \brief Total iterations of the searches run so far. */
+  long iterations;
+
+  /*! \brief Random number generator for randomized commands. */
+  rng_t rng;
+  /*! \brief Coordinator or worker to share searches with, or NULL to
+   *         search alone. */
+  distribute_t *dist;
 
   /*! \brief Abstraction of stdout. */
   stream_t *out_stream;
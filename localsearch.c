@@ -0,0 +1,400 @@
+/* RamseyScript
+ * Written in 2012 by
+ *   Andrew Poelstra <apoelstra@wpsoftware.net>
+ *
+ * To the extent possible under law, the author(s) have dedicated all
+ * copyright and related and neighboring rights to this software to
+ * the public domain worldwide. This software is distributed without
+ * any warranty.
+ *
+ * You should have received a copy of the CC0 Public Domain Dedication
+ * along with this software.
+ * If not, see <http://creativecommons.org/publicdomain/zero/1.0/>.
+ */
+
+/*! \file localsearch.c
+ *  \brief Stochastic local search for long colorings.
+ *
+ *  Each constraint is a set of literals (v, c), meaning value v has
+ *  color c, which may not all hold at once. For every literal we keep
+ *  the number of constraints containing it whose other literals all
+ *  hold: for the current color of v this counts the violated
+ *  constraints involving v, and for any other color it counts those
+ *  which recoloring v would violate. So the effect of any recoloring
+ *  can be read off in constant time, and updating the counts after a
+ *  recoloring only touches the constraints involving the two literals
+ *  which changed.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "global.h"
+#include "localsearch.h"
+#include "ramsey/ramsey.h"
+#include "recurse.h"
+
+/* Recolorings without n increasing before giving up, if no other
+ * limit is set */
+#define DEFAULT_STALL 10000000L
+
+/*! \brief Working data for a local search. */
+struct _local_search {
+  /*! \brief Length of the colorings being searched. */
+  int n;
+  /*! \brief Number of colors. */
+  int n_colors;
+  /*! \brief Color of each value (indexed from 0). */
+  int *color;
+  /*! \brief Number of values allocated. */
+  int max_n;
+
+  /*! \brief Literals of all constraints; (v, c) is (v - 1) * n_colors + c. */
+  int *lit;
+  /*! \brief Number of literals in all constraints. */
+  long n_lits;
+  /*! \brief Number of literals allocated. */
+  long max_lits;
+  /*! \brief Index in lit of the start of each constraint, and the end. */
+  long *start;
+  /*! \brief Number of constraints. */
+  int n_constraints;
+  /*! \brief Number of constraints allocated. */
+  int max_constraints;
+  /*! \brief Number of literals of each constraint which hold. */
+  int *n_true;
+
+  /*! \brief Index in occ of the constraints containing each literal. */
+  long *occ_start;
+  /*! \brief Constraints containing each literal. */
+  int *occ;
+  /*! \brief For each literal, number of constraints containing it whose
+   *         other literals all hold. */
+  int *viol;
+
+  /*! \brief The violated constraints. */
+  int *violated;
+  /*! \brief Number of violated constraints. */
+  int n_violated;
+  /*! \brief Position of each constraint in violated, or -1. */
+  int *violated_index;
+
+  /*! \brief Set if an allocation failed. */
+  bool failed;
+};
+
+/* Callback for filter_t->get_constraints() */
+static void _ls_emit (void *data, const int *values, const int *cells, int n_values)
+{
+  struct _local_search *ls = data;
+  int n_copies = (cells == NULL) ? ls->n_colors : 1;
+  int i, k;
+
+  if (ls->failed)
+    return;
+  if (ls->n_constraints + n_copies >= ls->max_constraints)
+    {
+      int new_max = 2 * (ls->n_constraints + n_copies);
+      long *tmp = realloc (ls->start, (new_max + 1) * sizeof *tmp);
+      if (tmp == NULL)
+        {
+          ls->failed = 1;
+          return;
+        }
+      ls->start = tmp;
+      ls->max_constraints = new_max;
+    }
+  if (ls->n_lits + n_copies * n_values > ls->max_lits)
+    {
+      long new_max = 2 * (ls->n_lits + n_copies * n_values);
+      int *tmp = realloc (ls->lit, new_max * sizeof *tmp);
+      if (tmp == NULL)
+        {
+          ls->failed = 1;
+          return;
+        }
+      ls->lit = tmp;
+      ls->max_lits = new_max;
+    }
+
+  /* Monochromatic constraints are added once for each color */
+  for (k = 0; k < n_copies; ++k)
+    {
+      ls->start[ls->n_constraints++] = ls->n_lits;
+      for (i = 0; i < n_values; ++i)
+        ls->lit[ls->n_lits++] = (values[i] - 1) * ls->n_colors +
+                                (cells ? cells[i] : k);
+    }
+  ls->start[ls->n_constraints] = ls->n_lits;
+}
+
+static bool _ls_holds (const struct _local_search *ls, int lit)
+{
+  return ls->color[lit / ls->n_colors] == lit % ls->n_colors;
+}
+
+static void _ls_set_violated (struct _local_search *ls, int con, bool violated)
+{
+  if (violated && ls->violated_index[con] < 0)
+    {
+      ls->violated_index[con] = ls->n_violated;
+      ls->violated[ls->n_violated++] = con;
+    }
+  else if (!violated && ls->violated_index[con] >= 0)
+    {
+      int last = ls->violated[--ls->n_violated];
+      ls->violated[ls->violated_index[con]] = last;
+      ls->violated_index[last] = ls->violated_index[con];
+      ls->violated_index[con] = -1;
+    }
+}
+
+static void _ls_free_constraints (struct _local_search *ls)
+{
+  free (ls->lit);
+  free (ls->start);
+  free (ls->n_true);
+  free (ls->occ_start);
+  free (ls->occ);
+  free (ls->viol);
+  free (ls->violated);
+  free (ls->violated_index);
+  ls->lit = NULL;
+  ls->start = ls->occ_start = NULL;
+  ls->n_true = ls->occ = ls->viol = NULL;
+  ls->violated = ls->violated_index = NULL;
+  ls->n_lits = ls->max_lits = 0;
+  ls->n_constraints = ls->max_constraints = 0;
+  ls->n_violated = 0;
+}
+
+/* Generate the constraints for the current length and work out all
+ * counts for the current coloring */
+static int _ls_build (struct _local_search *ls, const filter_list *filters)
+{
+  const filter_list *flist;
+  int n_literals = ls->n * ls->n_colors;
+  int i, con;
+  long j;
+
+  _ls_free_constraints (ls);
+  for (flist = filters; flist; flist = flist->next)
+    flist->data->get_constraints (flist->data, ls->n, ls->n_colors, _ls_emit, ls);
+  if (ls->failed)
+    return 0;
+
+  ls->n_true = malloc (ls->n_constraints * sizeof *ls->n_true);
+  ls->violated = malloc (ls->n_constraints * sizeof *ls->violated);
+  ls->violated_index = malloc (ls->n_constraints * sizeof *ls->violated_index);
+  ls->occ_start = calloc (n_literals + 1, sizeof *ls->occ_start);
+  ls->occ = malloc (ls->n_lits * sizeof *ls->occ);
+  ls->viol = calloc (n_literals, sizeof *ls->viol);
+  if ((ls->n_constraints > 0 && (ls->n_true == NULL || ls->violated == NULL ||
+       ls->violated_index == NULL || ls->occ == NULL)) ||
+      ls->occ_start == NULL || ls->viol == NULL)
+    {
+      ls->failed = 1;
+      return 0;
+    }
+
+  /* Occurrence lists */
+  for (j = 0; j < ls->n_lits; ++j)
+    ++ls->occ_start[ls->lit[j] + 1];
+  for (i = 0; i < n_literals; ++i)
+    ls->occ_start[i + 1] += ls->occ_start[i];
+  for (con = 0; con < ls->n_constraints; ++con)
+    for (j = ls->start[con]; j < ls->start[con + 1]; ++j)
+      ls->occ[ls->occ_start[ls->lit[j]]++] = con;
+  /* (That moved each list start to the next one; shift back) */
+  for (i = n_literals; i > 0; --i)
+    ls->occ_start[i] = ls->occ_start[i - 1];
+  ls->occ_start[0] = 0;
+
+  /* Counts */
+  for (con = 0; con < ls->n_constraints; ++con)
+    {
+      int size = ls->start[con + 1] - ls->start[con];
+
+      ls->n_true[con] = 0;
+      ls->violated_index[con] = -1;
+      for (j = ls->start[con]; j < ls->start[con + 1]; ++j)
+        ls->n_true[con] += _ls_holds (ls, ls->lit[j]);
+      for (j = ls->start[con]; j < ls->start[con + 1]; ++j)
+        if (ls->n_true[con] - _ls_holds (ls, ls->lit[j]) == size - 1)
+          ++ls->viol[ls->lit[j]];
+      _ls_set_violated (ls, con, ls->n_true[con] == size);
+    }
+  return 1;
+}
+
+/* Make the literal lit hold (if on) or stop holding (if not), updating
+ * the counts. The color array must be updated separately. */
+static void _ls_update (struct _local_search *ls, int lit, bool on)
+{
+  long i, j;
+
+  for (i = ls->occ_start[lit]; i < ls->occ_start[lit + 1]; ++i)
+    {
+      int con = ls->occ[i];
+      int size = ls->start[con + 1] - ls->start[con];
+      /* Literals other than lit in con whose other literals all held
+       * (before) or will all hold (after) have this many others holding */
+      int threshold = on ? size - 2 : size - 1;
+
+      for (j = ls->start[con]; j < ls->start[con + 1]; ++j)
+        {
+          int other = ls->lit[j];
+          if (other != lit &&
+              ls->n_true[con] - _ls_holds (ls, other) == threshold)
+            ls->viol[other] += on ? 1 : -1;
+        }
+      ls->n_true[con] += on ? 1 : -1;
+      _ls_set_violated (ls, con, ls->n_true[con] == size);
+    }
+}
+
+static void _ls_recolor (struct _local_search *ls, int v, int c)
+{
+  int old_lit = v * ls->n_colors + ls->color[v];
+
+  _ls_update (ls, old_lit, 0);
+  ls->color[v] = -1;
+  _ls_update (ls, v * ls->n_colors + c, 1);
+  ls->color[v] = c;
+}
+
+/* Pick a violated constraint and recolor one of its values */
+static void _ls_step (struct _local_search *ls, int noise, rng_t *rng)
+{
+  int con = ls->violated[rng_range (rng, ls->n_violated)];
+  long first = ls->start[con];
+  int size = ls->start[con + 1] - first;
+  int best_v = -1, best_c = -1, best_delta = 0, n_best = 0;
+  long j;
+
+  if (rng_range (rng, 100) < noise)
+    {
+      best_v = ls->lit[first + rng_range (rng, size)] / ls->n_colors;
+      best_c = rng_range (rng, ls->n_colors - 1);
+      if (best_c >= ls->color[best_v])
+        ++best_c;
+    }
+  else
+    for (j = first; j < first + size; ++j)
+      {
+        int v = ls->lit[j] / ls->n_colors;
+        int c;
+        for (c = 0; c < ls->n_colors; ++c)
+          if (c != ls->color[v])
+            {
+              int delta = ls->viol[v * ls->n_colors + c] - ls->viol[ls->lit[j]];
+              /* Break ties uniformly at random */
+              if (n_best == 0 || delta < best_delta)
+                n_best = 0;
+              if (n_best == 0 || delta == best_delta)
+                {
+                  if (rng_range (rng, ++n_best) == 0)
+                    {
+                      best_v = v;
+                      best_c = c;
+                    }
+                  best_delta = delta;
+                }
+            }
+      }
+  _ls_recolor (ls, best_v, best_c);
+}
+
+/* PUBLIC INTERFACE */
+long local_search (ramsey_t *rt, int n, global_data_t *state)
+{
+  const setting_t *noise_set = SETTING ("local_search_noise");
+  const filter_list *flist;
+  struct _local_search ls = { 0 };
+  long max_flips = rt->r_max_iterations;
+  long stall_after = rt->r_stall_after;
+  long max_run_time = rt->r_max_run_time;
+  int noise = noise_set ? noise_set->get_int_value (noise_set) : 0;
+  long flips = 0, last_growth = 0;
+  int i;
+
+  for (flist = state->filters; flist; flist = flist->next)
+    if (flist->data->get_constraints == NULL)
+      {
+        fprintf (stderr, "Error: filter ``%s'' cannot be used for local search.\n",
+                 flist->data->get_type (flist->data));
+        return -1;
+      }
+  if (stall_after == 0 && max_flips == 0 && max_run_time == 0)
+    stall_after = DEFAULT_STALL;
+
+  /* Targets and dumps are run on rt directly, so lift its limits */
+  rt->r_max_iterations = rt->r_stall_after = rt->r_max_run_time = 0;
+  rt->r_max_depth = 0;
+
+  ls.n = n;
+  ls.n_colors = rt->get_n_cells (rt);
+  ls.max_n = n;
+  ls.color = malloc (n * sizeof *ls.color);
+  if (ls.n_colors < 2)
+    {
+      fprintf (stderr, "Error: local search needs at least two colors.\n");
+      free (ls.color);
+      return -1;
+    }
+  if (ls.color != NULL)
+    for (i = 0; i < n; ++i)
+      ls.color[i] = rng_range (&state->rng, ls.n_colors);
+
+  if (ls.color == NULL || !_ls_build (&ls, state->filters))
+    ls.failed = 1;
+
+  while (!ls.failed && !state->kill_now)
+    {
+      if (ls.n_violated == 0)
+        {
+          /* Success; record it and go one longer */
+          rt->empty (rt);
+          for (i = 0; i < ls.n; ++i)
+            rt->cell_append (rt, i + 1, ls.color[i]);
+          recursion_preamble (rt, state);
+          recursion_postamble (rt);
+
+          if (ls.n == ls.max_n)
+            {
+              int *tmp = realloc (ls.color, 2 * ls.max_n * sizeof *tmp);
+              if (tmp == NULL)
+                {
+                  ls.failed = 1;
+                  break;
+                }
+              ls.color = tmp;
+              ls.max_n *= 2;
+            }
+          ls.color[ls.n++] = rng_range (&state->rng, ls.n_colors);
+          if (!_ls_build (&ls, state->filters))
+            break;
+          last_growth = flips;
+        }
+      else
+        {
+          _ls_step (&ls, noise, &state->rng);
+          ++flips;
+        }
+
+      if (max_flips && flips >= max_flips)
+        break;
+      if (stall_after && flips - last_growth >= stall_after)
+        break;
+      if (max_run_time && flips % 1000 == 0 &&
+          time (NULL) - rt->r_start_time >= max_run_time)
+        break;
+    }
+
+  if (ls.failed)
+    fprintf (stderr, "Error: out of memory in local search.\n");
+  _ls_free_constraints (&ls);
+  free (ls.color);
+  return flips;
+}
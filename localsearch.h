@@ -0,0 +1,49 @@
+/* RamseyScript
+ * Written in 2012 by
+ *   Andrew Poelstra <apoelstra@wpsoftware.net>
+ *
+ * To the extent possible under law, the author(s) have dedicated all
+ * copyright and related and neighboring rights to this software to
+ * the public domain worldwide. This software is distributed without
+ * any warranty.
+ *
+ * You should have received a copy of the CC0 Public Domain Dedication
+ * along with this software.
+ * If not, see <http://creativecommons.org/publicdomain/zero/1.0/>.
+ */
+
+/*! \file localsearch.h
+ *  \brief Defines stochastic local search for long colorings.
+ */
+
+#ifndef LOCALSEARCH_H
+#define LOCALSEARCH_H
+
+#include "global.h"
+
+/*! \brief Looks for colorings of [1, n] by local search, growing n on success.
+ *
+ *  Starting from a random coloring of [1, n], repeatedly picks a
+ *  violated constraint of the filters (as listed by their
+ *  get_constraints() hooks) and recolors one of its values, usually
+ *  the recoloring which leaves fewest constraints violated. Whenever
+ *  no constraint is violated, the coloring is run through the targets
+ *  and dumps, n is increased by one and the search continues.
+ *
+ *  The search stops after max-iterations recolorings, max-run-time
+ *  seconds, or stall-after recolorings without n increasing, as taken
+ *  from the recursion variables of rt.
+ *
+ *  \param [in] rt     An empty coloring with the filters applied. Its
+ *                     recursion variables must have been set by
+ *                     recursion_reset(). On return it holds the longest
+ *                     coloring found, or is empty if none was.
+ *  \param [in] n      The length to start at.
+ *  \param [in] state  The global state of the program.
+ *
+ *  \return The number of recolorings done, or -1 if the filters cannot
+ *          be used for local search.
+ */
+long local_search (ramsey_t *rt, int n, global_data_t *state);
+
+#endif
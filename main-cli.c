@@ -13,19 +13,150 @@
  */
 
 
-#include <time.h>
+#define _POSIX_C_SOURCE 200809L
+
+#include <pthread.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 
 #include "global.h"
+#include "buffer-stream.h"
+#include "distribute.h"
 #include "file-stream.h"
 #include "process.h"
 
-struct _global_data global;
+/*! \brief Scripts shared out between the threads of -j. */
+struct _script_pool {
+  /*! \brief Guards next, and stdout. */
+  pthread_mutex_t lock;
+  /*! \brief The scripts, NULL-terminated. */
+  char **script;
+  /*! \brief Index of the next script to run. */
+  int next;
+};
+
+/* Run one script, with its own state, writing to the given stream */
+static void _run_script (const char *path, stream_t *out, distribute_t *dist,
+                         bool worker)
+{
+  struct _global_data *defs = set_defaults (file_stream_new (path), out,
+                                            stderr_stream_new ());
+  defs->dist = dist;
+  /* Workers report to the coordinator, not the screen */
+  if (worker)
+    defs->quiet = 1;
+  if (!defs->in_stream->open (defs->in_stream, STREAM_READ))
+    fprintf (stderr, "Failed to open script ``%s''\n", path);
+  else
+    process (defs);
+  defs->in_stream->destroy (defs->in_stream);
+  defs->err_stream->destroy (defs->err_stream);
+  free_defaults (defs);
+}
+
+static void *_pool_main (void *arg)
+{
+  struct _script_pool *pool = arg;
+
+  while (1)
+    {
+      const char *path;
+      stream_t *out;
+
+      pthread_mutex_lock (&pool->lock);
+      path = pool->script[pool->next];
+      if (path)
+        ++pool->next;
+      pthread_mutex_unlock (&pool->lock);
+      if (path == NULL)
+        break;
+
+      /* Output is held back until the script is done, then written
+       * out in one piece, so scripts' output never interleaves */
+      out = buffer_stream_new ();
+      if (out == NULL)
+        {
+          fprintf (stderr, "Out of memory running script ``%s''\n", path);
+          continue;
+        }
+      _run_script (path, out, NULL, 0);
+      pthread_mutex_lock (&pool->lock);
+      fputs (buffer_stream_get_text (out), stdout);
+      fflush (stdout);
+      pthread_mutex_unlock (&pool->lock);
+      out->destroy (out);
+    }
+  return NULL;
+}
+
+/* Run scripts on n_threads threads at once */
+static int _run_pool (char **script, int n_threads)
+{
+  struct _script_pool pool;
+  pthread_t *thread = malloc (n_threads * sizeof *thread);
+  int n_started = 0;
+  int i;
+
+  if (thread == NULL)
+    {
+      fputs ("Out of memory starting threads.\n", stderr);
+      return EXIT_FAILURE;
+    }
+  pthread_mutex_init (&pool.lock, NULL);
+  pool.script = script;
+  pool.next = 0;
+
+  for (i = 0; i < n_threads; ++i)
+    if (pthread_create (&thread[n_started], NULL, _pool_main, &pool) == 0)
+      ++n_started;
+  /* If no thread could be started, run the scripts here */
+  if (n_started == 0)
+    _pool_main (&pool);
+  for (i = 0; i < n_started; ++i)
+    pthread_join (thread[i], NULL);
+
+  pthread_mutex_destroy (&pool.lock);
+  free (thread);
+  return 0;
+}
 
 int main (int argc, char *argv[])
 {
-  srand (time (NULL));
+  distribute_t *dist = NULL;
+  int first_script = 1;
+
+  /* -j <threads> */
+  if (argc >= 2 && !strcmp (argv[1], "-j"))
+    {
+      int n_threads = argc >= 3 ? atoi (argv[2]) : 0;
+      if (argc < 4 || n_threads < 1)
+        {
+          fprintf (stderr, "Usage: %s -j <threads> <script> [script ...]\n",
+                   argv[0]);
+          return EXIT_FAILURE;
+        }
+      return _run_pool (argv + 3, n_threads);
+    }
+
+  /* --coordinator <socket> or --worker <socket> */
+  if (argc >= 3 && (!strcmp (argv[1], "--coordinator") ||
+                    !strcmp (argv[1], "--worker")))
+    {
+      if (argc < 4)
+        {
+          fprintf (stderr, "Usage: %s %s <socket> <script> [script ...]\n",
+                   argv[0], argv[1]);
+          return EXIT_FAILURE;
+        }
+      if (!strcmp (argv[1], "--coordinator"))
+        dist = distribute_coordinator_new (argv[2]);
+      else
+        dist = distribute_worker_new (argv[2]);
+      if (dist == NULL)
+        return EXIT_FAILURE;
+      first_script = 3;
+    }
 
   if (argc < 2)
     { 
@@ -40,25 +171,24 @@ int main (int argc, char *argv[])
       puts ("Interactive mode.");
 
       process (defs);
+      defs->in_stream->destroy (defs->in_stream);
+      defs->out_stream->destroy (defs->out_stream);
+      defs->err_stream->destroy (defs->err_stream);
+      free_defaults (defs);
     }
   else
     {
       int i;
-      for (i = 1; argv[i]; ++i)
+      for (i = first_script; argv[i]; ++i)
         {
-          struct _global_data *defs = set_defaults (file_stream_new (argv[i]),
-                                                    stdout_stream_new (),
-                                                    stderr_stream_new ());
-          if (!defs->in_stream->open (defs->in_stream, STREAM_READ))
-            fprintf (stderr, "Failed to open script ``%s''\n", argv[i]);
-          else
-            process (defs);
-          defs->in_stream->destroy (defs->in_stream);
-          defs->out_stream->destroy (defs->out_stream);
-          defs->err_stream->destroy (defs->err_stream);
+          stream_t *out = stdout_stream_new ();
+          _run_script (argv[i], out, dist,
+                       dist && !strcmp (argv[1], "--worker"));
+          out->destroy (out);
         }
     }
 
+  distribute_destroy (dist);
   return 0;
 }
 
@@ -0,0 +1,522 @@
+/* RamseyScript
+ * Written in 2012 by
+ *   Andrew Poelstra <apoelstra@wpsoftware.net>
+ *
+ * To the extent possible under law, the author(s) have dedicated all
+ * copyright and related and neighboring rights to this software to
+ * the public domain worldwide. This software is distributed without
+ * any warranty.
+ *
+ * You should have received a copy of the CC0 Public Domain Dedication
+ * along with this software.
+ * If not, see <http://creativecommons.org/publicdomain/zero/1.0/>.
+ */
+
+/*! \file manifest.c
+ *  \brief Job manifests, for resuming split-up searches.
+ *
+ *  A manifest is a log of text lines, only ever appended to:
+ *
+ *    job <id> <depth> <space> <seed>      a job, numbered from 0
+ *    running <id>                         the job was started
+ *    stopped <id> <iterations>            it was interrupted
+ *    result <id> target <i> <saved state> (for each target)
+ *    result <id> dump <i> <saved state>   (for each dump)
+ *    done <id> <iterations>               it was finished
+ *
+ *  The latest record of a job gives its state. A job which was started
+ *  but never stopped or done belonged to a run which died, and is run
+ *  again. The results and "done" of a job are appended by a single
+ *  write, and a job only counts as done once its "done" line has been
+ *  read, so a write torn by a crash leaves the job unfinished rather
+ *  than wrong. Lines with no newline at the end are likewise ignored.
+ *
+ *  Each resumption first rewrites the manifest with only the latest
+ *  records of each job, so the log stays about one line per job plus
+ *  its results, however often it is resumed.
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "global.h"
+#include "buffer-stream.h"
+#include "manifest.h"
+#include "recurse.h"
+#include "ramsey/ramsey.h"
+#include "strategy/strategy.h"
+
+/*! \brief First line of every manifest. */
+#define MANIFEST_HEADER	"# RamseyScript job manifest\n"
+
+/*! \brief State of a job. */
+enum e_job_state {
+  JOB_PENDING,
+  JOB_RUNNING,
+  JOB_DONE
+};
+
+/*! \brief A job read from a manifest. */
+struct _job {
+  /*! \brief Depth of the seed in the whole search. */
+  int depth;
+  /*! \brief The space to search, as given to ``search''. */
+  char *space;
+  /*! \brief The seed, as printed. */
+  char *seed;
+  /*! \brief Whether it is waiting, was started, or is done. */
+  enum e_job_state state;
+  /*! \brief Iterations when done, or when last interrupted. */
+  long iterations;
+  /*! \brief The "result" records of the job, or NULL. */
+  char *results;
+};
+
+/*! \brief A manifest being written. */
+struct _manifest_t {
+  /*! \brief The name of the manifest. */
+  char *path;
+  /*! \brief The name it is written under until committed. */
+  char *tmp_path;
+  /*! \brief The file being written. */
+  FILE *fh;
+  /*! \brief Number of jobs written so far. */
+  int n_jobs;
+};
+
+/* WRITING */
+manifest_t *manifest_new (const char *path)
+{
+  manifest_t *m = malloc (sizeof *m);
+
+  if (m == NULL)
+    {
+      fputs ("Error: out of memory writing manifest.\n", stderr);
+      return NULL;
+    }
+  m->path = malloc (strlen (path) + 1);
+  m->tmp_path = malloc (strlen (path) + sizeof ".tmp");
+  m->fh = NULL;
+  m->n_jobs = 0;
+  if (m->path == NULL || m->tmp_path == NULL)
+    {
+      fputs ("Error: out of memory writing manifest.\n", stderr);
+      free (m->path);
+      free (m->tmp_path);
+      free (m);
+      return NULL;
+    }
+  strcpy (m->path, path);
+  sprintf (m->tmp_path, "%s.tmp", path);
+
+  m->fh = fopen (m->tmp_path, "w");
+  if (m->fh == NULL)
+    {
+      fprintf (stderr, "Error: could not write ``%s'': %s.\n", m->tmp_path,
+               strerror (errno));
+      free (m->path);
+      free (m->tmp_path);
+      free (m);
+      return NULL;
+    }
+  fputs (MANIFEST_HEADER, m->fh);
+  return m;
+}
+
+int manifest_add_job (manifest_t *m, const ramsey_t *rt)
+{
+  stream_t *text = buffer_stream_new ();
+
+  if (text == NULL)
+    return 0;
+  rt->print (rt, text);
+  fprintf (m->fh, "job %d %d %ss %s\n", m->n_jobs++, rt->r_depth,
+           rt->get_type (rt), buffer_stream_get_text (text));
+  text->destroy (text);
+  return 1;
+}
+
+int manifest_commit (manifest_t *m)
+{
+  int rv = 1;
+
+  /* Make sure the new manifest is on disk before it replaces the old */
+  if (fflush (m->fh) != 0 || fsync (fileno (m->fh)) != 0)
+    rv = 0;
+  if (fclose (m->fh) != 0)
+    rv = 0;
+  if (rv && rename (m->tmp_path, m->path) != 0)
+    rv = 0;
+  if (!rv)
+    {
+      fprintf (stderr, "Error: could not write ``%s'': %s.\n", m->path,
+               strerror (errno));
+      remove (m->tmp_path);
+    }
+
+  free (m->path);
+  free (m->tmp_path);
+  free (m);
+  return rv;
+}
+
+/* Append text to an open manifest, as a single write, and sync it */
+static int _append (int fd, const char *text)
+{
+  size_t len = strlen (text);
+
+  while (len > 0)
+    {
+      ssize_t n = write (fd, text, len);
+      if (n < 0 && errno == EINTR)
+        continue;
+      if (n <= 0)
+        return 0;
+      text += n;
+      len -= n;
+    }
+  return fsync (fd) == 0;
+}
+
+/* READING */
+static void _free_jobs (struct _job *job, int n_jobs)
+{
+  int i;
+
+  for (i = 0; i < n_jobs; ++i)
+    {
+      free (job[i].space);
+      free (job[i].seed);
+      free (job[i].results);
+    }
+  free (job);
+}
+
+/* Append a line to a job's results */
+static int _add_result (struct _job *job, const char *line)
+{
+  size_t old_len = job->results ? strlen (job->results) : 0;
+  char *tmp = realloc (job->results, old_len + strlen (line) + 2);
+
+  if (tmp == NULL)
+    return 0;
+  job->results = tmp;
+  sprintf (job->results + old_len, "%s\n", line);
+  return 1;
+}
+
+/* Add a job from its "job" record; returns 0 on failure */
+static int _add_job (struct _job **job, int *n_jobs, int *max_jobs,
+                     int depth, const char *space, const char *seed)
+{
+  struct _job *new_job;
+
+  if (*n_jobs == *max_jobs)
+    {
+      int new_max = 2 * *max_jobs + 64;
+      void *tmp = realloc (*job, new_max * sizeof **job);
+      if (tmp == NULL)
+        return 0;
+      *job = tmp;
+      *max_jobs = new_max;
+    }
+  new_job = &(*job)[*n_jobs];
+  new_job->depth = depth;
+  new_job->space = malloc (strlen (space) + 1);
+  new_job->seed  = malloc (strlen (seed) + 1);
+  new_job->state = JOB_PENDING;
+  new_job->iterations = 0;
+  new_job->results = NULL;
+  if (new_job->space == NULL || new_job->seed == NULL)
+    {
+      free (new_job->space);
+      free (new_job->seed);
+      return 0;
+    }
+  strcpy (new_job->space, space);
+  strcpy (new_job->seed, seed);
+  ++*n_jobs;
+  return 1;
+}
+
+/* Read the latest state of every job; returns 0 on failure */
+static int _read_jobs (const char *path, struct _job **job, int *n_jobs)
+{
+  FILE *fh = fopen (path, "r");
+  char *line = NULL;
+  size_t max_line = 0;
+  int max_jobs = 0;
+  int rv = 1;
+
+  *job = NULL;
+  *n_jobs = 0;
+  if (fh == NULL)
+    {
+      fprintf (stderr, "Error: could not read manifest ``%s'': %s.\n", path,
+               strerror (errno));
+      return 0;
+    }
+
+  while (rv && getline (&line, &max_line, fh) > 0)
+    {
+      char space[64];
+      int id, depth, off = 0;
+      long iterations;
+      size_t len = strlen (line);
+
+      /* A torn write */
+      if (line[len - 1] != '\n')
+        break;
+      line[len - 1] = 0;
+
+      if (sscanf (line, "job %d %d %63s %n", &id, &depth, space, &off) == 3
+          && off > 0)
+        {
+          if (id == *n_jobs)
+            rv = _add_job (job, n_jobs, &max_jobs, depth, space, line + off);
+        }
+      else if (sscanf (line, "running %d", &id) == 1)
+        {
+          if (id >= 0 && id < *n_jobs)
+            {
+              (*job)[id].state = JOB_RUNNING;
+              free ((*job)[id].results);
+              (*job)[id].results = NULL;
+            }
+        }
+      else if (sscanf (line, "stopped %d %ld", &id, &iterations) == 2)
+        {
+          if (id >= 0 && id < *n_jobs)
+            {
+              (*job)[id].state = JOB_PENDING;
+              (*job)[id].iterations = iterations;
+            }
+        }
+      else if (sscanf (line, "result %d", &id) == 1)
+        {
+          if (id >= 0 && id < *n_jobs)
+            rv = _add_result (&(*job)[id], line);
+        }
+      else if (sscanf (line, "done %d %ld", &id, &iterations) == 2)
+        {
+          if (id >= 0 && id < *n_jobs)
+            {
+              (*job)[id].state = JOB_DONE;
+              (*job)[id].iterations = iterations;
+            }
+        }
+    }
+  free (line);
+  fclose (fh);
+
+  if (!rv)
+    {
+      fprintf (stderr, "Error: out of memory reading manifest ``%s''.\n", path);
+      _free_jobs (*job, *n_jobs);
+      *job = NULL;
+      *n_jobs = 0;
+    }
+  return rv;
+}
+
+/* Rewrite the manifest with only the latest record of each job */
+static int _compact (const char *path, struct _job *job, int n_jobs)
+{
+  manifest_t *m = manifest_new (path);
+  int i;
+
+  if (m == NULL)
+    return 0;
+  for (i = 0; i < n_jobs; ++i)
+    {
+      fprintf (m->fh, "job %d %d %s %s\n", i, job[i].depth, job[i].space,
+               job[i].seed);
+      if (job[i].state == JOB_DONE)
+        fprintf (m->fh, "%sdone %d %ld\n", job[i].results ? job[i].results : "",
+                 i, job[i].iterations);
+      else
+        {
+          /* The run which started it has died */
+          job[i].state = JOB_PENDING;
+          free (job[i].results);
+          job[i].results = NULL;
+          if (job[i].iterations > 0)
+            fprintf (m->fh, "stopped %d %ld\n", i, job[i].iterations);
+        }
+    }
+  return manifest_commit (m);
+}
+
+/* RUNNING */
+static void _run_job (int fd, int id, struct _job *job, strategy_t *strategy,
+                      global_data_t *state)
+{
+  ramsey_t *seed = ramsey_new (job->space, state->settings);
+  stream_t *text = buffer_stream_new ();
+  stream_t *saved = buffer_stream_new ();
+  filter_list *flist;
+  dc_list *dlist;
+  char record[64];
+  int i;
+
+  if (seed == NULL || text == NULL || saved == NULL)
+    {
+      fprintf (stderr, "Error: could not start job %d.\n", id);
+      if (seed)
+        seed->destroy (seed);
+      if (text)
+        text->destroy (text);
+      if (saved)
+        saved->destroy (saved);
+      return;
+    }
+
+  for (flist = state->filters; flist; flist = flist->next)
+    seed->add_filter (seed, flist->data->clone (flist->data));
+  seed->parse (seed, job->seed);
+  for (dlist = state->dumps; dlist; dlist = dlist->next)
+    dlist->data->reset (dlist->data);
+  for (dlist = state->targets; dlist; dlist = dlist->next)
+    dlist->data->reset (dlist->data);
+
+  sprintf (record, "running %d\n", id);
+  if (!_append (fd, record))
+    fprintf (stderr, "Error: could not update manifest: %s.\n", strerror (errno));
+
+  recursion_reset (seed, state);
+  seed->r_depth = job->depth;
+  strategy->run (strategy, seed, state);
+  job->iterations = seed->r_iterations;
+
+  if (state->kill_now)
+    {
+      sprintf (record, "stopped %d %ld\n", id, job->iterations);
+      if (!_append (fd, record))
+        fprintf (stderr, "Error: could not update manifest: %s.\n", strerror (errno));
+    }
+  else
+    {
+      for (dlist = state->targets, i = 0; dlist; dlist = dlist->next, ++i)
+        {
+          buffer_stream_clear (saved);
+          dlist->data->save (dlist->data, saved);
+          stream_printf (text, "result %d target %d %s\n", id, i,
+                         buffer_stream_get_text (saved));
+        }
+      for (dlist = state->dumps, i = 0; dlist; dlist = dlist->next, ++i)
+        {
+          buffer_stream_clear (saved);
+          dlist->data->save (dlist->data, saved);
+          stream_printf (text, "result %d dump %d %s\n", id, i,
+                         buffer_stream_get_text (saved));
+        }
+      job->results = malloc (strlen (buffer_stream_get_text (text)) + 1);
+      if (job->results != NULL)
+        strcpy (job->results, buffer_stream_get_text (text));
+
+      /* Results and "done" go in one write, so are never torn apart */
+      stream_printf (text, "done %d %ld\n", id, job->iterations);
+      if (job->results == NULL || !_append (fd, buffer_stream_get_text (text)))
+        fprintf (stderr, "Error: could not update manifest: %s.\n", strerror (errno));
+      else
+        job->state = JOB_DONE;
+    }
+
+  saved->destroy (saved);
+  text->destroy (text);
+  seed->destroy (seed);
+}
+
+/* Merge the results of a done job into the targets and dumps */
+static void _merge_results (const char *results, const ramsey_t *proto,
+                            global_data_t *state)
+{
+  while (results && *results)
+    {
+      const char *end = strchr (results, '\n');
+      size_t len = end ? (size_t) (end - results) : strlen (results);
+      char *line = malloc (len + 1);
+      dc_list *dlist = NULL;
+      int index = 0, off = 0;
+
+      if (line == NULL)
+        return;
+      memcpy (line, results, len);
+      line[len] = 0;
+      if (sscanf (line, "result %*d target %d %n", &index, &off) == 1)
+        dlist = state->targets;
+      else if (sscanf (line, "result %*d dump %d %n", &index, &off) == 1)
+        dlist = state->dumps;
+
+      while (dlist && index-- > 0)
+        dlist = dlist->next;
+      if (dlist)
+        dlist->data->merge (dlist->data, line + off, proto);
+      free (line);
+
+      results += len;
+      if (*results)
+        ++results;
+    }
+}
+
+long manifest_resume (const char *path, strategy_t *strategy,
+                      global_data_t *state)
+{
+  struct _job *job;
+  ramsey_t *proto = NULL;
+  dc_list *dlist;
+  long iterations = 0;
+  int n_jobs, n_done, i, fd;
+
+  if (!_read_jobs (path, &job, &n_jobs))
+    return -1;
+  if (!_compact (path, job, n_jobs))
+    {
+      _free_jobs (job, n_jobs);
+      return -1;
+    }
+
+  fd = open (path, O_WRONLY | O_APPEND);
+  if (fd < 0)
+    {
+      fprintf (stderr, "Error: could not write manifest ``%s'': %s.\n", path,
+               strerror (errno));
+      _free_jobs (job, n_jobs);
+      return -1;
+    }
+  for (i = 0; i < n_jobs && !state->kill_now; ++i)
+    if (job[i].state != JOB_DONE)
+      _run_job (fd, i, &job[i], strategy, state);
+  close (fd);
+
+  /* Gather up the results of every job, from this run or earlier ones */
+  for (dlist = state->dumps; dlist; dlist = dlist->next)
+    dlist->data->reset (dlist->data);
+  for (dlist = state->targets; dlist; dlist = dlist->next)
+    dlist->data->reset (dlist->data);
+  for (i = 0, n_done = 0; i < n_jobs; ++i)
+    if (job[i].state == JOB_DONE)
+      {
+        ++n_done;
+        iterations += job[i].iterations;
+        if (proto == NULL)
+          proto = ramsey_new (job[i].space, state->settings);
+        if (proto != NULL)
+          _merge_results (job[i].results, proto, state);
+      }
+
+  if (!state->quiet)
+    stream_printf (state->out_stream, "Jobs done: %d of %d\n", n_done, n_jobs);
+
+  if (proto != NULL)
+    proto->destroy (proto);
+  _free_jobs (job, n_jobs);
+  return iterations;
+}
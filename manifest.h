@@ -0,0 +1,77 @@
+/* RamseyScript
+ * Written in 2012 by
+ *   Andrew Poelstra <apoelstra@wpsoftware.net>
+ *
+ * To the extent possible under law, the author(s) have dedicated all
+ * copyright and related and neighboring rights to this software to
+ * the public domain worldwide. This software is distributed without
+ * any warranty.
+ *
+ * You should have received a copy of the CC0 Public Domain Dedication
+ * along with this software.
+ * If not, see <http://creativecommons.org/publicdomain/zero/1.0/>.
+ */
+
+/*! \file manifest.h
+ *  \brief Defines job manifests, for resuming split-up searches.
+ */
+
+#ifndef MANIFEST_H
+#define MANIFEST_H
+
+#include "global.h"
+
+/*! \brief Opaque type of a manifest being written. */
+typedef struct _manifest_t manifest_t;
+
+/*! \brief Starts writing a new manifest.
+ *
+ *  Nothing is visible under the given name until manifest_commit(),
+ *  so a manifest which is interrupted while being written does not
+ *  replace the old one.
+ *
+ *  \param [in] path  The name of the manifest file.
+ *
+ *  \return A newly-allocated manifest, or NULL (after printing an
+ *          error) on failure.
+ */
+manifest_t *manifest_new (const char *path);
+
+/*! \brief Adds a pending job to a manifest.
+ *
+ *  \param [in] m   The manifest.
+ *  \param [in] rt  The seed of the job. Its r_depth, the depth of the
+ *                  seed in the whole search, is recorded with it.
+ *
+ *  \return 1 on success, 0 on failure.
+ */
+int manifest_add_job (manifest_t *m, const ramsey_t *rt);
+
+/*! \brief Finishes writing a manifest, replacing any old one, and frees it.
+ *
+ *  \return 1 on success, 0 (after printing an error) on failure.
+ */
+int manifest_commit (manifest_t *m);
+
+/*! \brief Searches the unfinished jobs of a manifest.
+ *
+ *  Each job which is not recorded as done is searched with the given
+ *  strategy, as if by ``search'' with its seed, except that max-depth
+ *  counts from the root of the whole search. As each job starts, and
+ *  again as it is done, a record is appended to the manifest, so that
+ *  if the program dies only the jobs then running need to be redone.
+ *
+ *  On return the targets and dumps hold the merged results of every
+ *  done job, including those done by earlier runs.
+ *
+ *  \param [in] path      The name of the manifest file.
+ *  \param [in] strategy  The strategy to search each job with.
+ *  \param [in] state     The global state of the program.
+ *
+ *  \return The total iterations of every done job, or -1 (after
+ *          printing an error) if the manifest could not be read.
+ */
+long manifest_resume (const char *path, strategy_t *strategy,
+                      global_data_t *state);
+
+#endif
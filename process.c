@@ -13,6 +13,8 @@
  */
 
 
+#define _POSIX_C_SOURCE 200809L
+
 #include <time.h>
 #include <ctype.h>
 #include <stdio.h>
@@ -21,13 +23,24 @@
 #include <strings.h>
 
 #include "global.h"
+#include "async.h"
+#include "batch.h"
+#include "cnf.h"
+#include "distribute.h"
 #include "dump/dump.h"
+#include "cube.h"
+#include "estimate.h"
 #include "file-stream.h"
+#include "localsearch.h"
+#include "manifest.h"
 #include "filter/filter.h"
 #include "process.h"
 #include "recurse.h"
 #include "ramsey/ramsey.h"
+#include "sat.h"
 #include "setting.h"
+#include "strategy/strategy.h"
+#include "sweep.h"
 #include "target/target.h"
 
 #define strmatch(s, r) (!strcmp ((s), (r)))
@@ -43,12 +56,20 @@ struct _global_data *set_defaults (stream_t *in, stream_t *out, stream_t *err)
       NEW_SET ("n_colors",       "3");
       NEW_SET ("random_length",  "10");
       NEW_SET ("dump_depth",     "400");
+      NEW_SET ("estimate_probes", "1000");
+      NEW_SET ("split_cubes",    "64");
+      NEW_SET ("local_search_noise", "30");
 #undef NEW_SET
       rv->filters  = NULL;
       rv->dumps    = NULL;
       rv->kill_now = 0;
       rv->interactive = 0;
       rv->quiet    = 0;
+      rv->dist     = NULL;
+      rv->record_lock = NULL;
+      rv->progress = 0;
+      rv->iterations = 0;
+      rng_seed (&rv->rng, time (NULL));
 
       rv->in_stream  = in;
       rv->out_stream = out;
@@ -64,8 +85,153 @@ struct _global_data *set_defaults (stream_t *in, stream_t *out, stream_t *err)
   return rv;
 }
 
+void free_defaults (struct _global_data *state)
+{
+  filter_list *flist = state->filters;
+
+  while (flist)
+    {
+      filter_list *tmp = flist;
+      flist = flist->next;
+      tmp->data->destroy (tmp->data);
+      free (tmp);
+    }
+  free_collectors (state->dumps);
+  free_collectors (state->targets);
+  state->settings->destroy (state->settings);
+  free (state);
+}
+
+struct _global_data *copy_defaults (struct _global_data *state, stream_t *in,
+                                    stream_t *out, stream_t *err)
+{
+  struct _global_data *rv = malloc (sizeof *rv);
+  if (rv)
+    {
+      const filter_list *flist;
+      filter_list **tail = &rv->filters;
+
+      memcpy (rv, state, sizeof *rv);
+      rv->settings = state->settings->clone (state->settings);
+      for (flist = state->filters; flist; flist = flist->next)
+        {
+          *tail = malloc (sizeof **tail);
+          if (*tail == NULL)
+            break;
+          (*tail)->data = flist->data->clone (flist->data);
+          tail = &(*tail)->next;
+        }
+      *tail = NULL;
+      rv->targets  = copy_collectors (state->targets, target_new, rv->settings);
+      rv->dumps    = copy_collectors (state->dumps, dump_new, rv->settings);
+      rv->kill_now = 0;
+      rv->interactive = 0;
+      rv->dist     = NULL;
+      rv->record_lock = NULL;
+      rv->progress = 0;
+      rv->iterations = 0;
+      rng_seed (&rv->rng, (unsigned long) rng_next (&state->rng));
+
+      rv->in_stream  = in;
+      rv->out_stream = out;
+      rv->err_stream = err;
+    }
+  return rv;
+}
+
+/* Make a fresh collector of each type in a list, in the same order */
+dc_list *copy_collectors (const dc_list *src,
+                          data_collector_t *(*construct) (const char *, const setting_list_t *),
+                          const setting_list_t *vars)
+{
+  dc_list *rv;
+  char name[64];
+  int i;
+
+  if (src == NULL)
+    return NULL;
+  rv = malloc (sizeof *rv);
+  if (rv == NULL)
+    return NULL;
+
+  /* The types are given with '-' where the constructors expect '_' */
+  strncpy (name, src->data->get_type (src->data), sizeof name - 1);
+  name[sizeof name - 1] = 0;
+  for (i = 0; name[i]; ++i)
+    if (name[i] == '-')
+      name[i] = '_';
+
+  rv->data = construct (name, vars);
+  rv->next = copy_collectors (src->next, construct, vars);
+  return rv;
+}
+
+void free_collectors (dc_list *list)
+{
+  while (list)
+    {
+      dc_list *next = list->next;
+      if (list->data)
+        list->data->destroy (list->data);
+      free (list);
+      list = next;
+    }
+}
+
+/* Output the results of a search, and free its seed and strategy */
+static void _search_done (ramsey_t *seed, strategy_t *strategy, time_t start,
+                          global_data_t *state)
+{
+  dc_list *dlist;
+
+  state->iterations += seed->r_iterations;
+  if (!state->quiet)
+    {
+      for (dlist = state->targets; dlist; dlist = dlist->next)
+        dlist->data->output (dlist->data, state->out_stream);
+      for (dlist = state->dumps; dlist; dlist = dlist->next)
+        dlist->data->output (dlist->data, state->out_stream);
+
+      stream_printf (state->out_stream, "Time taken: %ds. Iterations: %ld\n#### Done. ####\n\n",
+                     (int) (time (NULL) - start), seed->r_iterations);
+    }
+  strategy->destroy (strategy);
+  seed->destroy (seed);
+}
+
+/* As _search_done, for a search in the background, which may finish
+ * after the prompt has been output */
+static void _background_done (ramsey_t *seed, strategy_t *strategy,
+                              time_t start, global_data_t *state,
+                              bool at_prompt)
+{
+  if (at_prompt)
+    stream_printf (state->out_stream, "\n");
+  _search_done (seed, strategy, start, state);
+  if (at_prompt)
+    {
+      printf ("ramsey> ");
+      fflush (stdout);
+    }
+}
+
+/* Whether a command leaves a search running in the background alone */
+static int _is_background_command (const char *tok, const char *rest)
+{
+  if (strmatch (tok, "set"))
+    {
+      rest += strspn (rest, " \t");
+      return !strncmp (rest, "max_run_time", 12) && isspace (rest[12]);
+    }
+  return strmatch (tok, "status") || strmatch (tok, "best") ||
+         strmatch (tok, "stop") || strmatch (tok, "help") ||
+         strmatch (tok, "quit") || strmatch (tok, "exit");
+}
+
 void process (struct _global_data *state)
 {
+  async_search_t *background = NULL;
+  async_search_t *held;
   char *buf;
   int i;
 
@@ -77,7 +243,7 @@ void process (struct _global_data *state)
     }
   while ((buf = state->in_stream->read_line (state->in_stream)))
     {
-      char *tok;
+      char *tok, *save;
       /* Convert all - signs to _ so lispers can feel at home */
       for (i = 0; buf[i]; ++i)
         if (buf[i] == '-')
@@ -85,7 +251,26 @@ void process (struct _global_data *state)
         else if (isalpha (buf[i]))
           buf[i] = tolower (buf[i]);
 
-      tok = strtok (buf, " \t\n");
+      tok = strtok_r (buf, " \t\n", &save);
+
+      /* A search in the background keeps running while commands which
+       * leave it alone are run; others wait for it to finish */
+      if (background && !async_search_running (background))
+        {
+          async_search_destroy (background);
+          background = NULL;
+        }
+      if (background && tok && *tok != '#' && !_is_background_command (tok, save))
+        {
+          stream_printf (state->out_stream, "Waiting for the search to finish.\n");
+          async_search_destroy (background);
+          background = NULL;
+        }
+      /* Keep the results of a search which finishes meanwhile out of
+       * this command's output and the prompt */
+      held = background;
+      if (held)
+        async_search_hold_output (held);
 
       /* skip comments and blank lines */
       if (tok == NULL || *tok == '#')
@@ -95,23 +280,25 @@ void process (struct _global_data *state)
       /* set <variable> <value> */
       else if (strmatch (tok, "set"))
         {
-          const char *name = strtok (NULL, " #\t\n");
-          const char *text = strtok (NULL, "#\n");
+          const char *name = strtok_r (NULL, " #\t\n", &save);
+          const char *text = strtok_r (NULL, "#\n", &save);
           setting_t *new_set = setting_new (name, text);
           if (state->settings->add_setting (state->settings, new_set))
             {
               if (state->interactive)
                 new_set->print (new_set, state->out_stream);
+              if (background && strmatch (name, "max_run_time"))
+                async_search_set_max_run_time (background, new_set->get_int_value (new_set));
             }
           else if (name == NULL)
-            printf ("Usage: set <variable> <value>\n");
+            stream_printf (state->out_stream, "Usage: set <variable> <value>\n");
           else
             fprintf (stderr, "Failed to add setting ``%s''.\n", name);
         }
       /* get <variable> */
       else if (strmatch (tok, "get"))
         {
-          tok = strtok (NULL, " #\t\n");
+          tok = strtok_r (NULL, " #\t\n", &save);
           if (tok && *tok)
             {
               const setting_t *set = SETTING (tok);
@@ -126,9 +313,9 @@ void process (struct _global_data *state)
       /* unset <variable> */
       else if (strmatch (tok, "unset"))
         {
-          const char *name = strtok (NULL, " #\t\n");
+          const char *name = strtok_r (NULL, " #\t\n", &save);
           if (name == NULL)
-            printf ("Usage: unset <variable>\n");
+            stream_printf (state->out_stream, "Usage: unset <variable>\n");
           else if (state->settings->remove_setting (state->settings, name))
             {
               if (state->interactive)
@@ -138,7 +325,7 @@ void process (struct _global_data *state)
       /* filter <no-double-3-aps|no-additive-squares> */
       else if (strmatch (tok, "filter"))
         {
-          tok = strtok (NULL, " #\t\n");
+          tok = strtok_r (NULL, " #\t\n", &save);
           /* Delete all filters */
           if ((tok != NULL) && strmatch (tok, "clear"))
             {
@@ -178,7 +365,7 @@ void process (struct _global_data *state)
       /* dump <iterations-per-length> */
       else if (strmatch (tok, "dump"))
         {
-          tok = strtok (NULL, " #\t\n");
+          tok = strtok_r (NULL, " #\t\n", &save);
           /* Delete all dumps */
           if (tok != NULL && strmatch (tok, "clear"))
             {
@@ -218,7 +405,7 @@ void process (struct _global_data *state)
       /* target <max-length> */
       else if (strmatch (tok, "target"))
         {
-          tok = strtok (NULL, " #\t\n");
+          tok = strtok_r (NULL, " #\t\n", &save);
           /* Delete all target */
           if (tok != NULL && strmatch (tok, "clear"))
             {
@@ -259,13 +446,21 @@ void process (struct _global_data *state)
       else if (strmatch (tok, "search"))
         {
           ramsey_t *seed = NULL;
+          strategy_t *strategy = NULL;
+          const setting_t *strategy_set = SETTING ("strategy");
 
-          tok = strtok (NULL, " #\t\n");
+          tok = strtok_r (NULL, " #\t\n", &save);
           if (tok)
             seed = ramsey_new (tok, state->settings);
 
           if (seed == NULL)
             ramsey_usage (state->out_stream);
+          else if ((strategy = strategy_new (strategy_set ? strategy_set->get_text (strategy_set) : "dfs",
+                                             state->settings)) == NULL)
+            {
+              strategy_usage (state->out_stream);
+              seed->destroy (seed);
+            }
           else
             {
               filter_list *flist;
@@ -277,8 +472,13 @@ void process (struct _global_data *state)
               const setting_t *alphabet_set  = SETTING ("alphabet");
               const setting_t *gap_set_set   = SETTING ("gap_set");
               const setting_t *rand_len_set  = SETTING ("random_length");
+              const setting_t *rand_seed_set = SETTING ("random_seed");
+              const char *seed_file = NULL;
               time_t start = time (NULL);
 
+              if (rand_seed_set)
+                rng_seed (&state->rng, rand_seed_set->get_int_value (rand_seed_set));
+
               /* Apply filters */
               for (flist = state->filters; flist; flist = flist->next)
                 seed->add_filter (seed, flist->data->clone (flist->data));
@@ -289,11 +489,13 @@ void process (struct _global_data *state)
                 dlist->data->reset (dlist->data);
 
               /* Parse seed */
-              tok = strtok (NULL, "\n");
+              tok = strtok_r (NULL, "\n", &save);
               if (tok && *tok == '[')
                 seed->parse (seed, tok);
               else if (tok && strmatch (tok, "random"))
-                seed->randomize (seed, rand_len_set->get_int_value (rand_len_set));
+                seed->randomize (seed, rand_len_set->get_int_value (rand_len_set), &state->rng);
+              else if (tok && *tok == '@')
+                seed_file = strtok_r (tok + 1, " #\t", &save);
 
               /* Output header */
               if (!state->quiet)
@@ -312,6 +514,12 @@ void process (struct _global_data *state)
                   if (max_depth_set)
                     stream_printf (state->out_stream, "  Max. depth: \t%ld\n",
                                    max_depth_set->get_int_value (max_depth_set));
+                  if (strategy_set || SETTING ("restart_strategy"))
+                    stream_printf (state->out_stream, "  Strategy: \t%s\n",
+                                   strategy->get_type (strategy));
+                  if (SETTING ("shard"))
+                    stream_printf (state->out_stream, "  Shard: \t%s\n",
+                                   SETTING ("shard")->get_text (SETTING ("shard")));
                   if (alphabet_set && alphabet_set->type == TYPE_RAMSEY)
                     {
                       const ramsey_t *alphabet = alphabet_set->get_ramsey_value (alphabet_set);
@@ -335,16 +543,179 @@ void process (struct _global_data *state)
                     stream_printf (state->out_stream, "%s ", dlist->data->get_type (dlist->data));
                   stream_printf (state->out_stream, "\n");
                     
+                  if (seed_file)
+                    stream_printf (state->out_stream, "  Seeds: \t%s\n", seed_file);
+                  else
+                    {
+                      stream_printf (state->out_stream, "  Seed:\t\t");
+                      seed->print (seed, state->out_stream);
+                      stream_printf (state->out_stream, "\n");
+                    }
+                }
+
+              /* Do recursion */
+              recursion_reset (seed, state);
+              if (seed_file)
+                {
+                  long iterations = batch_search (seed, strategy_set ? strategy_set->get_text (strategy_set) : "dfs",
+                                                  seed_file, state);
+                  seed->r_iterations = iterations > 0 ? iterations : 0;
+                }
+              else if (state->dist)
+                distribute_search (state->dist, seed, strategy, state);
+              /* In interactive mode, search in the background, leaving
+               * the prompt free for ``status'', ``best'' and ``stop'' */
+              else if (state->interactive)
+                {
+                  stream_printf (state->out_stream, "Searching in the background. "
+                                 "Type ``status'', ``best'' or ``stop''.\n");
+                  background = async_search_start (seed, strategy, start,
+                                                   _background_done, state);
+                  if (background == NULL)
+                    strategy->run (strategy, seed, state);
+                }
+              else
+                strategy->run (strategy, seed, state);
+
+              /* Output dump and target data, and cleanup */
+              if (background == NULL)
+                _search_done (seed, strategy, start, state);
+            }
+        }
+      /* estimate <space> [seed] */
+      else if (strmatch (tok, "estimate"))
+        {
+          ramsey_t *seed = NULL;
+
+          tok = strtok_r (NULL, " #\t\n", &save);
+          if (tok)
+            seed = ramsey_new (tok, state->settings);
+
+          if (seed == NULL)
+            ramsey_usage (state->out_stream);
+          else
+            {
+              filter_list *flist;
+              const setting_t *n_probes_set = SETTING ("estimate_probes");
+              const setting_t *rand_seed_set = SETTING ("random_seed");
+              const setting_t *rand_len_set  = SETTING ("random_length");
+              const setting_t *max_depth_set = SETTING ("max_depth");
+              int n_probes = n_probes_set ? n_probes_set->get_int_value (n_probes_set) : 0;
+              time_t start = time (NULL);
+
+              if (rand_seed_set)
+                rng_seed (&state->rng, rand_seed_set->get_int_value (rand_seed_set));
+
+              /* Apply filters */
+              for (flist = state->filters; flist; flist = flist->next)
+                seed->add_filter (seed, flist->data->clone (flist->data));
+
+              /* Parse seed */
+              tok = strtok_r (NULL, "\n", &save);
+              if (tok && *tok == '[')
+                seed->parse (seed, tok);
+              else if (tok && strmatch (tok, "random"))
+                seed->randomize (seed, rand_len_set->get_int_value (rand_len_set), &state->rng);
+
+              /* Output header */
+              if (!state->quiet)
+                {
+                  stream_printf (state->out_stream, "#### Estimating %s search ####\n",
+                                 seed->get_type (seed));
+                  stream_printf (state->out_stream, "  Probes: \t%d\n", n_probes);
+                  if (max_depth_set)
+                    stream_printf (state->out_stream, "  Max. depth: \t%ld\n",
+                                   max_depth_set->get_int_value (max_depth_set));
+                  stream_printf (state->out_stream, "  Filters: \t");
+                  for (flist = state->filters; flist; flist = flist->next)
+                    stream_printf (state->out_stream, "%s ", flist->data->get_type (flist->data));
+                  stream_printf (state->out_stream, "\n");
                   stream_printf (state->out_stream, "  Seed:\t\t");
                   seed->print (seed, state->out_stream);
                   stream_printf (state->out_stream, "\n");
                 }
 
-              /* Do recursion */
+              /* Do probes */
               recursion_reset (seed, state);
-              seed->recurse (seed, state);
+              estimate_tree (seed, n_probes, state);
 
-              /* Output dump and target data */
+              if (!state->quiet)
+                stream_printf (state->out_stream, "Time taken: %ds.\n#### Done. ####\n\n",
+                               (int) (time (NULL) - start));
+              /* Cleanup */
+              seed->destroy (seed);
+            }
+        }
+      /* split <space> [seed] */
+      else if (strmatch (tok, "split"))
+        {
+          ramsey_t *seed = NULL;
+
+          tok = strtok_r (NULL, " #\t\n", &save);
+          if (tok)
+            seed = ramsey_new (tok, state->settings);
+
+          if (seed == NULL)
+            ramsey_usage (state->out_stream);
+          else
+            {
+              filter_list *flist;
+              dc_list     *dlist;
+              const setting_t *n_cubes_set  = SETTING ("split_cubes");
+              const setting_t *n_probes_set = SETTING ("estimate_probes");
+              const setting_t *rand_seed_set = SETTING ("random_seed");
+              const setting_t *rand_len_set  = SETTING ("random_length");
+              const setting_t *manifest_set  = SETTING ("manifest_file");
+              int n_cubes  = n_cubes_set ? n_cubes_set->get_int_value (n_cubes_set) : 0;
+              int n_probes = n_probes_set ? n_probes_set->get_int_value (n_probes_set) : 0;
+              manifest_t *manifest = NULL;
+              time_t start = time (NULL);
+              long iterations;
+
+              if (rand_seed_set)
+                rng_seed (&state->rng, rand_seed_set->get_int_value (rand_seed_set));
+
+              /* Apply filters */
+              for (flist = state->filters; flist; flist = flist->next)
+                seed->add_filter (seed, flist->data->clone (flist->data));
+
+              /* Parse seed */
+              tok = strtok_r (NULL, "\n", &save);
+              if (tok && *tok == '[')
+                seed->parse (seed, tok);
+              else if (tok && strmatch (tok, "random"))
+                seed->randomize (seed, rand_len_set->get_int_value (rand_len_set), &state->rng);
+
+              /* Reset data collectors */
+              for (dlist = state->targets; dlist; dlist = dlist->next)
+                dlist->data->reset (dlist->data);
+              for (dlist = state->dumps; dlist; dlist = dlist->next)
+                dlist->data->reset (dlist->data);
+
+              /* Output header */
+              if (!state->quiet)
+                {
+                  stream_printf (state->out_stream, "#### Splitting %s search ####\n",
+                                 seed->get_type (seed));
+                  stream_printf (state->out_stream, "  Cubes: \t%d\n", n_cubes);
+                  stream_printf (state->out_stream, "  Probes: \t%d\n", n_probes);
+                  if (manifest_set)
+                    stream_printf (state->out_stream, "  Manifest: \t%s\n",
+                                   manifest_set->get_text (manifest_set));
+                  stream_printf (state->out_stream, "  Seed:\t\t");
+                  seed->print (seed, state->out_stream);
+                  stream_printf (state->out_stream, "\n");
+                }
+
+              /* Do split */
+              if (manifest_set)
+                manifest = manifest_new (manifest_set->get_text (manifest_set));
+              recursion_reset (seed, state);
+              iterations = cube_split (seed, n_cubes, n_probes, manifest, state);
+              if (manifest)
+                manifest_commit (manifest);
+
+              /* Output */
               if (!state->quiet)
                 {
                   for (dlist = state->targets; dlist; dlist = dlist->next)
@@ -353,12 +724,354 @@ void process (struct _global_data *state)
                     dlist->data->output (dlist->data, state->out_stream);
 
                   stream_printf (state->out_stream, "Time taken: %ds. Iterations: %ld\n#### Done. ####\n\n",
-                                 (int) (time (NULL) - start), seed->r_iterations);
+                                 (int) (time (NULL) - start), iterations);
                 }
               /* Cleanup */
               seed->destroy (seed);
             }
         }
+      /* resume-manifest <file> */
+      else if (strmatch (tok, "resume_manifest"))
+        {
+          strategy_t *strategy = NULL;
+          const setting_t *strategy_set = SETTING ("strategy");
+
+          tok = strtok_r (NULL, " #\t\n", &save);
+          if (tok == NULL)
+            stream_printf (state->out_stream, "Usage: resume-manifest <file>\n");
+          else if ((strategy = strategy_new (strategy_set ? strategy_set->get_text (strategy_set) : "dfs",
+                                             state->settings)) == NULL)
+            strategy_usage (state->out_stream);
+          else
+            {
+              filter_list *flist;
+              dc_list     *dlist;
+              const setting_t *rand_seed_set = SETTING ("random_seed");
+              time_t start = time (NULL);
+              long iterations;
+
+              if (rand_seed_set)
+                rng_seed (&state->rng, rand_seed_set->get_int_value (rand_seed_set));
+
+              /* Output header */
+              if (!state->quiet)
+                {
+                  stream_printf (state->out_stream, "#### Resuming manifest search ####\n");
+                  stream_printf (state->out_stream, "  Manifest: \t%s\n", tok);
+                  if (strategy_set || SETTING ("restart_strategy"))
+                    stream_printf (state->out_stream, "  Strategy: \t%s\n",
+                                   strategy->get_type (strategy));
+                  stream_printf (state->out_stream, "  Targets: \t");
+                  for (dlist = state->targets; dlist; dlist = dlist->next)
+                    stream_printf (state->out_stream, "%s ", dlist->data->get_type (dlist->data));
+                  stream_printf (state->out_stream, "\n");
+                  stream_printf (state->out_stream, "  Filters: \t");
+                  for (flist = state->filters; flist; flist = flist->next)
+                    stream_printf (state->out_stream, "%s ", flist->data->get_type (flist->data));
+                  stream_printf (state->out_stream, "\n");
+                  stream_printf (state->out_stream, "  Dump data: \t");
+                  for (dlist = state->dumps; dlist; dlist = dlist->next)
+                    stream_printf (state->out_stream, "%s ", dlist->data->get_type (dlist->data));
+                  stream_printf (state->out_stream, "\n");
+                }
+
+              /* Do jobs */
+              iterations = manifest_resume (tok, strategy, state);
+
+              /* Output dump and target data */
+              if (!state->quiet && iterations >= 0)
+                {
+                  for (dlist = state->targets; dlist; dlist = dlist->next)
+                    dlist->data->output (dlist->data, state->out_stream);
+                  for (dlist = state->dumps; dlist; dlist = dlist->next)
+                    dlist->data->output (dlist->data, state->out_stream);
+
+                  stream_printf (state->out_stream, "Time taken: %ds. Iterations: %ld\n#### Done. ####\n\n",
+                                 (int) (time (NULL) - start), iterations);
+                }
+              /* Cleanup */
+              strategy->destroy (strategy);
+            }
+        }
+      /* sweep <variable> <value> [value ...] { <commands> } */
+      else if (strmatch (tok, "sweep"))
+        {
+          const char *name = strtok_r (NULL, " #\t\n", &save);
+          const char *values = strtok_r (NULL, "#\n", &save);
+
+          if (name == NULL || values == NULL || sweep_run (name, values, state) < 0)
+            stream_printf (state->out_stream,
+                           "Usage: sweep <variable> <value> [value ...] {\n"
+                           "         <commands>\n"
+                           "       }\n");
+        }
+      /* local-search <space> <N> */
+      else if (strmatch (tok, "local_search"))
+        {
+          ramsey_t *seed = NULL;
+          const char *len_text;
+
+          tok = strtok_r (NULL, " #\t\n", &save);
+          len_text = strtok_r (NULL, " #\t\n", &save);
+          if (tok && len_text)
+            seed = ramsey_new (tok, state->settings);
+
+          if (seed == NULL)
+            fprintf (stderr, "Usage: local-search <space> <N>\n");
+          else if (seed->type != TYPE_COLORING)
+            fprintf (stderr, "Error: local search only works on colorings.\n");
+          else if (SETTING ("base_sequence"))
+            fprintf (stderr, "Error: cannot do local search on colorings of a base-sequence.\n");
+          else if (atoi (len_text) < 1)
+            fprintf (stderr, "Error: length must be positive.\n");
+          else
+            {
+              filter_list *flist;
+              dc_list     *dlist;
+              const setting_t *noise_set = SETTING ("local_search_noise");
+              const setting_t *rand_seed_set = SETTING ("random_seed");
+              time_t start = time (NULL);
+              long flips;
+
+              if (rand_seed_set)
+                rng_seed (&state->rng, rand_seed_set->get_int_value (rand_seed_set));
+
+              /* Apply filters */
+              for (flist = state->filters; flist; flist = flist->next)
+                seed->add_filter (seed, flist->data->clone (flist->data));
+              /* Reset dump data */
+              for (dlist = state->dumps; dlist; dlist = dlist->next)
+                dlist->data->reset (dlist->data);
+              for (dlist = state->targets; dlist; dlist = dlist->next)
+                dlist->data->reset (dlist->data);
+
+              /* Output header */
+              if (!state->quiet)
+                {
+                  stream_printf (state->out_stream, "#### Starting %s local search ####\n",
+                                 seed->get_type (seed));
+                  stream_printf (state->out_stream, "  Length: \t%s\n", len_text);
+                  if (noise_set)
+                    stream_printf (state->out_stream, "  Noise: \t%ld%%\n",
+                                   noise_set->get_int_value (noise_set));
+                  stream_printf (state->out_stream, "  Targets: \t");
+                  for (dlist = state->targets; dlist; dlist = dlist->next)
+                    stream_printf (state->out_stream, "%s ", dlist->data->get_type (dlist->data));
+                  stream_printf (state->out_stream, "\n");
+                  stream_printf (state->out_stream, "  Filters: \t");
+                  for (flist = state->filters; flist; flist = flist->next)
+                    stream_printf (state->out_stream, "%s ", flist->data->get_type (flist->data));
+                  stream_printf (state->out_stream, "\n");
+                }
+
+              recursion_reset (seed, state);
+              flips = local_search (seed, atoi (len_text), state);
+
+              /* Output dump and target data */
+              if (!state->quiet && flips >= 0)
+                {
+                  for (dlist = state->targets; dlist; dlist = dlist->next)
+                    dlist->data->output (dlist->data, state->out_stream);
+                  for (dlist = state->dumps; dlist; dlist = dlist->next)
+                    dlist->data->output (dlist->data, state->out_stream);
+
+                  stream_printf (state->out_stream, "Time taken: %ds. Recolorings: %ld\n#### Done. ####\n\n",
+                                 (int) (time (NULL) - start), flips);
+                }
+            }
+          if (seed)
+            seed->destroy (seed);
+        }
+      /* export-cnf <space> <N> <file> */
+      else if (strmatch (tok, "export_cnf"))
+        {
+          ramsey_t *proto = NULL;
+          const char *len_text;
+          const char *filename;
+
+          tok = strtok_r (NULL, " #\t\n", &save);
+          len_text = strtok_r (NULL, " #\t\n", &save);
+          filename = strtok_r (NULL, " #\t\n", &save);
+          if (tok && len_text && filename)
+            proto = ramsey_new (tok, state->settings);
+
+          if (proto == NULL)
+            fprintf (stderr, "Usage: export-cnf <space> <N> <file>\n");
+          else if (proto->type != TYPE_COLORING)
+            fprintf (stderr, "Error: only colorings can be exported to CNF.\n");
+          else if (SETTING ("base_sequence"))
+            fprintf (stderr, "Error: cannot export colorings of a base-sequence to CNF.\n");
+          else
+            {
+              const setting_t *break_sym_set = SETTING ("cnf_break_symmetry");
+              stream_t *out = file_stream_new (filename);
+              int n = atoi (len_text);
+
+              if (out == NULL || !out->open (out, STREAM_WRITE))
+                fprintf (stderr, "Error: could not write to ``%s''.\n", filename);
+              else if (cnf_export (out, state->filters, n, proto->get_n_cells (proto),
+                                   break_sym_set && break_sym_set->get_int_value (break_sym_set))
+                       && !state->quiet)
+                stream_printf (state->out_stream, "Wrote CNF for %d-colorings of [1, %d] to ``%s''.\n",
+                               proto->get_n_cells (proto), n, filename);
+              if (out)
+                out->destroy (out);
+            }
+          if (proto)
+            proto->destroy (proto);
+        }
+      /* import-model <file> */
+      else if (strmatch (tok, "import_model"))
+        {
+          const char *filename = strtok_r (NULL, " #\t\n", &save);
+          ramsey_t *seed = NULL;
+          stream_t *in = NULL;
+
+          if (filename == NULL)
+            fprintf (stderr, "Usage: import-model <file>\n");
+          else if ((in = file_stream_new (filename)) == NULL ||
+                   !in->open (in, STREAM_READ))
+            fprintf (stderr, "Error: could not read ``%s''.\n", filename);
+          else if ((seed = ramsey_new ("colorings", state->settings)) != NULL)
+            {
+              filter_list *flist;
+              int *colors;
+              int n;
+
+              colors = cnf_read_model (in, seed->get_n_cells (seed), &n);
+              if (colors == NULL)
+                fprintf (stderr, "Error: no model in ``%s''.\n", filename);
+              else
+                {
+                  /* Apply filters */
+                  for (flist = state->filters; flist; flist = flist->next)
+                    seed->add_filter (seed, flist->data->clone (flist->data));
+                  /* The model arrives whole, so check all of it */
+                  seed->full_filters (seed);
+
+                  for (i = 0; i < n; ++i)
+                    if (colors[i] < 0)
+                      {
+                        fprintf (stderr, "Warning: model gives no color for %d.\n", i + 1);
+                        break;
+                      }
+                    else
+                      seed->cell_append (seed, i + 1, colors[i]);
+
+                  if (!state->quiet)
+                    {
+                      stream_printf (state->out_stream, "Imported model (%s filters): ",
+                                     seed->run_filters (seed) ? "passes" : "FAILS");
+                      seed->print (seed, state->out_stream);
+                      stream_printf (state->out_stream, "\n");
+                    }
+
+                  /* Run targets and dumps, as for ``process'' */
+                  recursion_preamble (seed, state);
+                  free (colors);
+                }
+            }
+          if (seed)
+            seed->destroy (seed);
+          if (in)
+            in->destroy (in);
+        }
+      /* solve <space> <N> */
+      else if (strmatch (tok, "solve"))
+        {
+          ramsey_t *seed = NULL;
+          const char *len_text;
+
+          tok = strtok_r (NULL, " #\t\n", &save);
+          len_text = strtok_r (NULL, " #\t\n", &save);
+          if (tok && len_text)
+            seed = ramsey_new (tok, state->settings);
+
+          if (seed == NULL)
+            fprintf (stderr, "Usage: solve <space> <N>\n");
+          else if (seed->type != TYPE_COLORING)
+            fprintf (stderr, "Error: only colorings can be solved.\n");
+          else if (SETTING ("base_sequence"))
+            fprintf (stderr, "Error: cannot solve colorings of a base-sequence.\n");
+          else
+            {
+              const setting_t *max_run_time_set = SETTING ("max_run_time");
+              int n = atoi (len_text);
+              int n_colors = seed->get_n_cells (seed);
+              time_t start = time (NULL);
+              time_t deadline = 0;
+              sat_solver_t *solver = NULL;
+              filter_list *flist;
+              long n_clauses = -1;
+              int result = -1;
+
+              if (max_run_time_set && max_run_time_set->get_int_value (max_run_time_set) > 0)
+                deadline = start + max_run_time_set->get_int_value (max_run_time_set);
+
+              if (n < 1)
+                fprintf (stderr, "Error: length must be positive.\n");
+              else if ((solver = sat_new (n * n_colors)) == NULL)
+                fprintf (stderr, "Error: out of memory creating solver.\n");
+              else
+                n_clauses = cnf_load (solver, state->filters, n, n_colors, 1);
+
+              if (n_clauses >= 0)
+                {
+                  if (!state->quiet)
+                    {
+                      stream_printf (state->out_stream, "#### Solving %d-colorings of [1, %d] ####\n",
+                                     n_colors, n);
+                      stream_printf (state->out_stream, "  Clauses: \t%ld\n", n_clauses);
+                      stream_printf (state->out_stream, "  Filters: \t");
+                      for (flist = state->filters; flist; flist = flist->next)
+                        stream_printf (state->out_stream, "%s ", flist->data->get_type (flist->data));
+                      stream_printf (state->out_stream, "\n");
+                    }
+
+                  result = sat_solve (solver, deadline, &state->kill_now);
+
+                  if (result == 1)
+                    {
+                      int v, c;
+
+                      /* Apply filters */
+                      for (flist = state->filters; flist; flist = flist->next)
+                        seed->add_filter (seed, flist->data->clone (flist->data));
+
+                      for (v = 1; v <= n; ++v)
+                        for (c = 0; c < n_colors; ++c)
+                          if (sat_get_value (solver, (v - 1) * n_colors + c + 1))
+                            {
+                              seed->cell_append (seed, v, c);
+                              break;
+                            }
+
+                      if (!state->quiet)
+                        {
+                          stream_printf (state->out_stream, "Satisfiable: ");
+                          seed->print (seed, state->out_stream);
+                          stream_printf (state->out_stream, "\n");
+                        }
+                      /* Run targets and dumps, as for ``process'' */
+                      recursion_preamble (seed, state);
+                    }
+
+                  if (!state->quiet)
+                    {
+                      if (result == 0)
+                        stream_printf (state->out_stream, "Unsatisfiable: no such coloring of [1, %d].\n", n);
+                      else if (result < 0)
+                        stream_printf (state->out_stream, "Gave up.\n");
+                      sat_print_stats (solver, state->out_stream);
+                      stream_printf (state->out_stream, "Time taken: %ds.\n#### Done. ####\n\n",
+                                     (int) (time (NULL) - start));
+                    }
+                }
+              sat_destroy (solver);
+            }
+          if (seed)
+            seed->destroy (seed);
+        }
       /* Manual recursion */
       else if (strmatch (tok, "reset"))
         {
@@ -372,7 +1085,7 @@ void process (struct _global_data *state)
         {
           ramsey_t *seed = NULL;
 
-          tok = strtok (NULL, " #\t\n");
+          tok = strtok_r (NULL, " #\t\n", &save);
           if (tok)
             seed = ramsey_new (tok, state->settings);
 
@@ -389,11 +1102,11 @@ void process (struct _global_data *state)
               /* Do -not- reset dump data */
 
               /* Parse "seed" */
-              tok = strtok (NULL, "\n");
+              tok = strtok_r (NULL, "\n", &save);
               if (tok && *tok == '[')
                 seed->parse (seed, tok);
               else if (tok && strmatch (tok, "random"))
-                seed->randomize (seed, rand_len_set->get_int_value (rand_len_set));
+                seed->randomize (seed, rand_len_set->get_int_value (rand_len_set), &state->rng);
 
               /* "Recurse" */
               recursion_preamble (seed, state);
@@ -402,6 +1115,81 @@ void process (struct _global_data *state)
               seed->destroy (seed);
             }
         }
+      /* process-file <space> <file> */
+      else if (strmatch (tok, "process_file"))
+        {
+          ramsey_t *proto = NULL;
+
+          tok = strtok_r (NULL, " #\t\n", &save);
+          if (tok)
+            proto = ramsey_new (tok, state->settings);
+
+          if (proto == NULL)
+            ramsey_usage (state->out_stream);
+          else if ((tok = strtok_r (NULL, " #\t\n", &save)) == NULL)
+            {
+              stream_printf (state->out_stream, "Usage: process-file <space> <file>\n");
+              proto->destroy (proto);
+            }
+          else
+            {
+              filter_list *flist;
+              long n_objects, n_passed;
+
+              /* Apply filters */
+              for (flist = state->filters; flist; flist = flist->next)
+                proto->add_filter (proto, flist->data->clone (flist->data));
+              /* Objects are read whole, not built up value by value,
+               * so the filters must check all of them */
+              proto->full_filters (proto);
+              /* Do -not- reset dump data */
+
+              n_objects = batch_process_file (proto, tok, state, &n_passed);
+              if (n_objects >= 0 && !state->quiet)
+                stream_printf (state->out_stream, "Processed %ld objects, of which %ld passed.\n",
+                               n_objects, n_passed);
+
+              /* Cleanup */
+              proto->destroy (proto);
+            }
+        }
+      /* Background search commands */
+      else if (strmatch (tok, "status"))
+        {
+          if (background)
+            async_search_status (background, state->out_stream);
+          else
+            stream_printf (state->out_stream, "No search is running.\n");
+        }
+      else if (strmatch (tok, "best"))
+        {
+          dc_list *dlist;
+          if (background)
+            async_search_best (background, state->out_stream);
+          else
+            for (dlist = state->targets; dlist; dlist = dlist->next)
+              dlist->data->output (dlist->data, state->out_stream);
+        }
+      else if (strmatch (tok, "stop"))
+        {
+          if (background)
+            {
+              async_search_release_output (held);
+              held = NULL;
+              async_search_stop (background);
+              async_search_destroy (background);
+              background = NULL;
+              /* The results are output as the search finishes, unless quiet */
+              if (state->quiet)
+                {
+                  dc_list *dlist;
+                  for (dlist = state->targets; dlist; dlist = dlist->next)
+                    dlist->data->output (dlist->data, state->out_stream);
+                }
+            }
+          else
+            stream_printf (state->out_stream, "No search is running.\n");
+        }
       else if (strmatch (tok, "state"))
         {
           dc_list *dlist;
@@ -420,7 +1208,7 @@ void process (struct _global_data *state)
         }
       else if (strmatch (tok, "echo"))
         {
-          tok = strtok (NULL, "\n");
+          tok = strtok_r (NULL, "\n", &save);
           stream_printf (state->out_stream, "%s\n", tok);
         }
       else if (strmatch (tok, "help"))
@@ -433,19 +1221,42 @@ void process (struct _global_data *state)
           "    dump: set a data dump\n"
           "  filter: set a filter\n"
           "  search: recursively explore Ramsey objects\n"
+          "estimate: predict the size of a search\n"
+          "   split: split a search into pieces of similar size\n"
+          "resume-manifest: search the unfinished pieces of a split\n"
+          "   sweep: run commands once for each of several values of a variable\n"
           "  target: set a target\n"
           "\n"
           "   reset: reset all targets, dumps and filters\n"
           " process: run targets, dumps and filters on a given object\n"
+          "process-file: the same, on every object in a file\n"
           "   state: output state of dumps and targets\n"
           "\n"
+          "  status: show the progress of a search running in the background\n"
+          "    best: output the targets of a search running in the background\n"
+          "    stop: stop a search running in the background\n"
+          "\n"
+          "  export-cnf: write a coloring problem for a SAT solver\n"
+          "import-model: process a SAT solver's solution\n"
+          "       solve: decide a coloring problem with the built-in solver\n"
+          "local-search: look for long colorings by recoloring\n"
+          "\n"
           "   quiet: supress metadata output.\n"
           "    echo: output some text.\n"
           "    help: display this message.\n"
           "    quit: exit the program.\n"
         );
       else if (strmatch (tok, "quit") || strmatch (tok, "exit"))
-        return;
+        {
+          if (background)
+            {
+              async_search_release_output (held);
+              async_search_stop (background);
+              async_search_destroy (background);
+            }
+          free (buf);
+          return;
+        }
       else if (state->interactive)
         fprintf (stderr, "Unrecognized command ``%s''. Type 'help' for help, or\n"
                          "see the README file for a full language specification.\n", tok);
@@ -453,11 +1264,23 @@ void process (struct _global_data *state)
         fprintf (stderr, "Unrecognized command ``%s''.\n", tok);
 
       free (buf);
+      /* Likewise for a search the command has just started */
+      if (held == NULL && background)
+        {
+          held = background;
+          async_search_hold_output (held);
+        }
       if (state->interactive)
         {
           printf ("ramsey> ");
           fflush (stdout);
         }
+      if (held)
+        async_search_release_output (held);
     }
+
+  /* At the end of input, let a background search finish */
+  if (background)
+    async_search_destroy (background);
 }
 
@@ -19,6 +19,7 @@
 #ifndef PROCESS_H
 #define PROCESS_H
 
+#include "global.h"
 #include "stream.h"
 
 /*! \brief Sets default variables before a script run.
@@ -31,6 +32,52 @@
  */
 struct _global_data *set_defaults (stream_t *in, stream_t *out, stream_t *err);
 
+/*! \brief Frees a global_data struct made by set_defaults().
+ *
+ *  The variables, filters, targets and dumps are freed; the streams
+ *  and any coordinator or worker are left to the caller.
+ *
+ *  \param [in] state  The global state to free.
+ */
+void free_defaults (struct _global_data *state);
+
+/*! \brief Makes a global_data struct with copies of another's state.
+ *
+ *  The copy has its own copies of the variables and filters, fresh
+ *  targets and dumps of the same types, and a random number generator
+ *  seeded from the original's. It is not interactive, and searches
+ *  alone.
+ *
+ *  \param [in] state  The global state to copy.
+ *  \param [in] in     The input stream to use.
+ *  \param [in] out    The output stream to use.
+ *  \param [in] err    The error stream to use.
+ *
+ *  \return A newly-allocated global_data struct, to be freed with
+ *          free_defaults(), or NULL on failure.
+ */
+struct _global_data *copy_defaults (struct _global_data *state, stream_t *in,
+                                    stream_t *out, stream_t *err);
+
+/*! \brief Makes a fresh data collector of each type in a list.
+ *
+ *  \param [in] src        The list to copy.
+ *  \param [in] construct  target_new or dump_new, as appropriate.
+ *  \param [in] vars       The variables to construct the collectors with.
+ *
+ *  \return A new list, in the same order, to be freed with
+ *          free_collectors(). Collectors which could not be made are NULL.
+ */
+dc_list *copy_collectors (const dc_list *src,
+                          data_collector_t *(*construct) (const char *, const setting_list_t *),
+                          const setting_list_t *vars);
+
+/*! \brief Destroys a list of data collectors.
+ *
+ *  \param [in] list  The list to destroy.
+ */
+void free_collectors (dc_list *list);
+
 /*! \brief Reads and runs a script from the global state's input stream.
  *
  *  \param [in] state  The global state of the program.
@@ -28,12 +28,16 @@
 
 #include "ramsey.h"
 #include "coloring.h"
+#include "../child-order.h"
+#include "nogood-store.h"
 #include "sequence.h"
 
 /*! \brief Default allocation size for colorings. */
 #define DEFAULT_MAX_INTLIST	400
 /*! \brief Default number of filters. */
 #define DEFAULT_MAX_FILTERS	20
+/*! \brief Maximum number of values in a filter's explanation. */
+#define MAX_EXPLAIN	64
 
 /*! \brief Private data for the coloring type. */
 struct _coloring {
@@ -66,6 +70,18 @@ struct _coloring {
   int n_cells;
   /*! \brief Base sequence, or NULL if we are just using consecutive numbers */
   ramsey_t *base_sequence;
+  /*! \brief Whether to backjump over irrelevant positions when the next
+   *         number fits in no color (see _coloring_find_conflict). */
+  bool backjump;
+  /*! \brief Maximum number of nogoods to learn, or 0 not to learn any. */
+  int max_nogoods;
+  /*! \brief Nogoods learned so far, or NULL if none have been. */
+  nogood_store_t *nogoods;
+  /*! \brief Order in which the recursion tries colors. */
+  child_order_t order;
+  /*! \brief Whether the last value was checked against the filters'
+   *         masks already, so that run_filters need not check it again. */
+  bool prechecked;
 
   /*! \brief Representation of coloring as a word on the alphabet [0,(r-1)],
    *         where r is the number of colors. */
@@ -106,6 +122,8 @@ static int _coloring_run_filters (const ramsey_t *rt)
   int i;
   assert (rt && rt->type == TYPE_COLORING);
 
+  if (c->prechecked)
+    return 1;
   for (i = 0; i < c->n_filters; ++i)
     if (!c->filter[i]->run (c->filter[i], rt))
       return 0;
@@ -117,12 +135,88 @@ static int _coloring_run_filters (const ramsey_t *rt)
   return 1;
 }
 
-static int _coloring_add_filter (ramsey_t *rt, filter_t *f)
+static int _coloring_full_filters (ramsey_t *rt)
 {
   struct _coloring *c = (struct _coloring *) rt;
+  int i, rv = 1;
+  assert (rt && rt->type == TYPE_COLORING);
+
+  c->prechecked = 0;
+  for (i = 0; i < c->n_filters; ++i)
+    rv &= c->filter[i]->set_mode (c->filter[i], MODE_FULL);
+
+  for (i = 0; i < c->n_cells; ++i)
+    rv &= c->sequence[i]->full_filters (c->sequence[i]);
+
+  return rv;
+}
+
+/* Whether get_allowed_cells() gives exactly the verdict that run_filters
+ * would give after a cell append (cf. sequence_mask_is_exact) */
+static bool _coloring_mask_is_exact (const struct _coloring *c)
+{
+  int i;
+
+  if (c->n_cells > CELL_MASK_BITS)
+    return 0;
+  for (i = 0; i < c->n_filters; ++i)
+    if (c->filter[i]->get_allowed_cells == NULL ||
+        c->filter[i]->mode != MODE_LAST_ONLY)
+      return 0;
+  for (i = 0; i < c->n_cells; ++i)
+    if (!sequence_mask_is_exact (c->sequence[i]))
+      return 0;
+  return 1;
+}
+
+static unsigned long _coloring_get_allowed_cells (const ramsey_t *rt, int value)
+{
+  const struct _coloring *c = (struct _coloring *) rt;
+  unsigned long rv = ~0UL;
+  int i;
   assert (rt && rt->type == TYPE_COLORING);
 
+  for (i = 0; i < c->n_filters && rv; ++i)
+    if (c->filter[i]->get_allowed_cells)
+      rv &= c->filter[i]->get_allowed_cells (c->filter[i], rt, value);
+
+  for (i = 0; i < c->n_cells && i < CELL_MASK_BITS; ++i)
+    if ((rv & (1UL << i)) &&
+        !c->sequence[i]->get_allowed_cells (c->sequence[i], value))
+      rv &= ~(1UL << i);
+
+  return rv;
+}
 
+static unsigned long _coloring_get_allowed_values (const ramsey_t *rt,
+                                                   const int *values, int n_values)
+{
+  (void) rt;
+  (void) values;
+  return CELL_MASK_ALL (n_values);
+}
+
+static int _coloring_explain (const ramsey_t *rt, int value, int cell,
+                              int *values, int max_values)
+{
+  const struct _coloring *c = (struct _coloring *) rt;
+  int i, rv = -1;
+  assert (rt && rt->type == TYPE_COLORING);
+
+  for (i = 0; i < c->n_filters && rv < 0; ++i)
+    if (c->filter[i]->explain)
+      rv = c->filter[i]->explain (c->filter[i], rt, value, cell, values, max_values);
+  if (rv < 0)
+    rv = c->sequence[cell]->explain (c->sequence[cell], value, 0, values, max_values);
+  return rv;
+}
+
+static int _coloring_add_filter (ramsey_t *rt, filter_t *f)
+{
+  struct _coloring *c = (struct _coloring *) rt;
+  assert (rt && rt->type == TYPE_COLORING);
+
+  c->prechecked = 0;
   if (f->supports (f, TYPE_COLORING))
     {
       if (c->n_filters == c->max_filters)
@@ -158,21 +252,92 @@ static int _coloring_add_filter (ramsey_t *rt, filter_t *f)
 }
 
 /* RECURSION */
-static void _coloring_real_recurse (ramsey_t *rt, int max_value, global_data_t *state)
+
+/* Returns the position (counting from 1) of a value in the coloring,
+ * or -1 if it is not there. */
+static int _coloring_value_position (const struct _coloring *c, int value)
+{
+  const int *base_sequence_values;
+  int i;
+
+  if (c->base_sequence == NULL)
+    return value;
+
+  base_sequence_values = c->base_sequence->get_priv_data_const (c->base_sequence);
+  for (i = c->n_int_list - 1; i >= 0; --i)
+    if (base_sequence_values[i] == value)
+      return i + 1;
+  return -1;
+}
+
+/* When value fits in no color, finds a set of positions to blame for
+ * this; that is, every color would still be ruled out if all other
+ * positions were recolored. These are stored in positions, and their
+ * number is returned, or -1 if some color cannot be explained.
+ *
+ * Only the colors of positions up to and including the latest of these
+ * need to change to get further than value, so the search may jump
+ * straight back to it (Gaschnig's backjumping). Also, the positions
+ * with their current colors can be learned as a nogood. */
+static int _coloring_find_conflict (struct _coloring *c, int value,
+                                    int *positions, int max_positions)
+{
+  const ramsey_t *rt = (const ramsey_t *) c;
+  int conflict[MAX_EXPLAIN];
+  int n_positions = 0;
+  int i, j, k;
+
+  for (i = 0; i < c->n_cells; ++i)
+    {
+      int n = rt->explain (rt, value, i, conflict, MAX_EXPLAIN);
+      if (n >= 0)
+        {
+          for (j = 0; j < n; ++j)
+            if ((conflict[j] = _coloring_value_position (c, conflict[j])) < 0)
+              return -1;
+        }
+      else if (c->nogoods != NULL)
+        n = nogood_store_find (c->nogoods, c->n_int_list + 1, i, c->int_list,
+                               conflict, MAX_EXPLAIN);
+      if (n < 0)
+        return -1;
+
+      for (j = 0; j < n; ++j)
+        {
+          for (k = 0; k < n_positions; ++k)
+            if (positions[k] == conflict[j])
+              break;
+          if (k == n_positions)
+            {
+              if (n_positions == max_positions)
+                return -1;
+              positions[n_positions++] = conflict[j];
+            }
+        }
+    }
+  return n_positions;
+}
+
+/* Returns -1, or the position to backjump to (see _coloring_find_conflict) */
+static int _coloring_real_recurse (ramsey_t *rt, int max_value, global_data_t *state)
 {
   struct _coloring *c = (struct _coloring *) rt;
   const int *base_sequence_values;
+  unsigned long allowed = ~0UL;
+  int jump = -1;
   int next_val;
-  int i;
+  int first_empty = c->n_cells;
+  bool ordered, exact;
+  int i, k;
 
   assert (rt && rt->type == TYPE_COLORING);
   assert (state != NULL);
 
   if (c->base_sequence != NULL &&
       rt->get_length (rt) > c->base_sequence->get_length (c->base_sequence))
-    return;
+    return -1;
   if (!recursion_preamble (rt, state))
-    return;
+    return -1;
 
   if (c->base_sequence != NULL)
     {
@@ -182,19 +347,73 @@ static void _coloring_real_recurse (ramsey_t *rt, int max_value, global_data_t *
   else
     next_val = max_value + 1;
 
-  for (i = 0; i < c->n_cells; ++i)
+  /* Skip colors that the filters would reject anyway */
+  if (rt->r_prune_tree)
+    allowed = rt->get_allowed_cells (rt, next_val);
+  /* ...or that would lead to a dead end we have seen before */
+  if (rt->r_prune_tree && c->nogoods != NULL)
+    for (i = 0; i < c->n_cells && i < CELL_MASK_BITS; ++i)
+      if ((allowed & (1UL << i)) &&
+          nogood_store_find (c->nogoods, max_value + 1, i, c->int_list, NULL, 0) >= 0)
+        allowed &= ~(1UL << i);
+
+  /* Dead end; see what is to blame */
+  if ((c->backjump || c->max_nogoods > 0) && rt->r_prune_tree &&
+      c->n_cells <= CELL_MASK_BITS && (allowed & CELL_MASK_ALL (c->n_cells)) == 0)
+    {
+      int conflict[MAX_EXPLAIN];
+      int n = _coloring_find_conflict (c, next_val, conflict, MAX_EXPLAIN);
+
+      if (n > 0 && c->max_nogoods > 0)
+        {
+          if (c->nogoods == NULL)
+            c->nogoods = nogood_store_new (c->n_cells, c->max_nogoods);
+          if (c->nogoods != NULL)
+            nogood_store_add (c->nogoods, conflict, c->int_list, n);
+        }
+      if (n >= 0 && c->backjump)
+        for (i = 0, jump = 0; i < n; ++i)
+          if (conflict[i] > jump)
+            jump = conflict[i];
+    }
+
+  /* Only bother with one empty cell, since by symmetry they'll
+   * all behave the same. */
+  if (c->has_symmetry)
+    for (i = 0; i < first_empty; ++i)
+      if (c->sequence[i]->get_length (c->sequence[i]) == 0)
+        first_empty = i;
+
+  ordered = c->order.how != ORDER_NATURAL && jump < 0 &&
+            child_order_begin (&c->order, rt, state, max_value, c->n_cells);
+  exact = rt->r_prune_tree && _coloring_mask_is_exact (c);
+  for (k = 0; k < c->n_cells && jump < 0; ++k)
     {
-      _coloring_cell_append ((ramsey_t *) c, next_val, i);
-      _coloring_real_recurse (rt, max_value + 1, state);
-      _coloring_cell_deappend ((ramsey_t *) c, i);
-
-      /* Only bother with one empty cell, since by symmetry they'll
-       *  all behave the same. */
-      if (c->has_symmetry && c->sequence[i]->get_length (c->sequence[i]) == 0)
-        break;
+      i = ordered ? child_order_at (&c->order, max_value, k) : k;
+      if (i > first_empty)
+        continue;
+
+      if (i >= CELL_MASK_BITS || (allowed & (1UL << i)))
+        {
+          long stall_index = rt->r_stall_index;
+
+          _coloring_cell_append ((ramsey_t *) c, next_val, i);
+          /* Don't make the child's preamble filter it a second time */
+          c->prechecked = exact;
+          jump = _coloring_real_recurse (rt, max_value + 1, state);
+          _coloring_cell_deappend ((ramsey_t *) c, i);
+
+          if (ordered && rt->r_stall_index != stall_index)
+            child_order_succeed (&c->order, max_value, i);
+          /* Only positions up to the culprit matter; if that is the
+           * one we just colored, carry on with its next color. */
+          if (jump > max_value)
+            jump = -1;
+        }
     }
 
   recursion_postamble (rt);
+  return jump;
 }
 
 static void _coloring_recurse (ramsey_t *rt, global_data_t *state)
@@ -202,6 +421,63 @@ static void _coloring_recurse (ramsey_t *rt, global_data_t *state)
   _coloring_real_recurse (rt, rt->get_length (rt), state);
 }
 
+static int _coloring_get_n_children (ramsey_t *rt)
+{
+  struct _coloring *c = (struct _coloring *) rt;
+  assert (rt && rt->type == TYPE_COLORING);
+
+  if (c->base_sequence != NULL &&
+      rt->get_length (rt) >= c->base_sequence->get_length (c->base_sequence))
+    return 0;
+  return c->n_cells;
+}
+
+static int _coloring_child_append (ramsey_t *rt, int index)
+{
+  struct _coloring *c = (struct _coloring *) rt;
+  int next_val;
+  int i;
+  assert (rt && rt->type == TYPE_COLORING);
+
+  /* As in _coloring_real_recurse, only use the first empty cell */
+  if (c->has_symmetry)
+    for (i = 0; i < index; ++i)
+      if (c->sequence[i]->get_length (c->sequence[i]) == 0)
+        return 0;
+
+  if (c->base_sequence != NULL)
+    {
+      const int *base_sequence_values = c->base_sequence->get_priv_data_const (c->base_sequence);
+      next_val = base_sequence_values[rt->get_length (rt)];
+    }
+  else
+    next_val = rt->get_length (rt) + 1;
+
+  /* Skip colors that the filters would reject anyway */
+  if (rt->r_prune_tree && index < CELL_MASK_BITS)
+    {
+      for (i = 0; i < c->n_filters; ++i)
+        if (c->filter[i]->get_allowed_cells &&
+            !(c->filter[i]->get_allowed_cells (c->filter[i], rt, next_val) &
+              (1UL << index)))
+          return 0;
+      if (!c->sequence[index]->get_allowed_cells (c->sequence[index], next_val))
+        return 0;
+    }
+
+  if (!_coloring_cell_append (rt, next_val, index))
+    return 0;
+  /* As in _coloring_real_recurse, spare the preamble a second check */
+  c->prechecked = rt->r_prune_tree && _coloring_mask_is_exact (c);
+  return 1;
+}
+
+static void _coloring_child_deappend (ramsey_t *rt, int index)
+{
+  assert (rt && rt->type == TYPE_COLORING);
+  _coloring_cell_deappend (rt, index);
+}
+
 /* PRINT / PARSE */
 
 static const char *_coloring_parse (ramsey_t *rt, const char *data)
@@ -216,6 +492,7 @@ static const char *_coloring_parse (ramsey_t *rt, const char *data)
     ++data;
   if (*data == '[')
     ++data;
+  c->prechecked = 0;
   for (i = 0; i < c->n_cells; ++i)
     data = c->sequence[i]->parse (c->sequence[i], data);
 
@@ -266,7 +543,7 @@ static void _coloring_print (const ramsey_t *rt, stream_t *out)
   out->write (out, "]");
 }
 
-static void _coloring_randomize (ramsey_t *rt, int n)
+static void _coloring_randomize (ramsey_t *rt, int n, rng_t *rng)
 {
   struct _coloring *c = (struct _coloring *) rt;
   bool success = 0;
@@ -279,7 +556,7 @@ static void _coloring_randomize (ramsey_t *rt, int n)
       success = 1;
       for (i = 1; success && i <= n; ++i)
         {
-          rt->cell_append (rt, i, rand () % c->n_cells);
+          rt->cell_append (rt, i, rng_range (rng, c->n_cells));
           success &= rt->run_filters (rt);
         }
     }
@@ -301,6 +578,8 @@ static int _coloring_get_n_cells (const ramsey_t *rt)
 static void *_coloring_get_priv_data (ramsey_t *rt)
 {
   assert (rt && rt->type == TYPE_COLORING);
+  /* The caller may change the cells behind our back */
+  ((struct _coloring *) rt)->prechecked = 0;
   return ((struct _coloring *) rt)->sequence;
 }
 
@@ -323,6 +602,7 @@ static int _coloring_cell_append (ramsey_t *rt, int value, int cell)
   ramsey_t *seq;
   assert (rt && rt->type == TYPE_COLORING);
 
+  c->prechecked = 0;
   seq = c->sequence[cell];
   if (seq->append (seq, value))
     {
@@ -355,6 +635,7 @@ static int _coloring_cell_deappend (ramsey_t *rt, int cell)
   struct _coloring *c = (struct _coloring *) rt;
   ramsey_t *seq = c->sequence[cell];
   assert (rt && rt->type == TYPE_COLORING);
+  c->prechecked = 0;
   if (seq->deappend (seq))
     {
       --c->n_int_list;
@@ -381,6 +662,7 @@ static void _coloring_empty (ramsey_t *rt)
   for (i = 0; i < c->n_cells; ++i)
     c->sequence[i]->empty (c->sequence[i]);
   c->n_int_list = 0;
+  c->prechecked = 0;
 }
 
 static void _coloring_reset (ramsey_t *rt)
@@ -393,6 +675,10 @@ static void _coloring_reset (ramsey_t *rt)
   for (i = 0; i < c->n_cells; ++i)
     c->sequence[i]->reset (c->sequence[i]);
   c->n_int_list = 0;
+  c->prechecked = 0;
+  /* Nogoods were learned from the filters, which are now gone */
+  nogood_store_destroy (c->nogoods);
+  c->nogoods = NULL;
   recursion_init (rt);
 }
 
@@ -417,6 +703,8 @@ static ramsey_t *_coloring_clone (const ramsey_t *rt)
     c->base_sequence = old_c->base_sequence->clone (old_c->base_sequence);
   else
     c->base_sequence = NULL;
+  c->nogoods = NULL;
+  child_order_init (&c->order, old_c->order.how);
 
   memcpy (c->int_list, old_c->int_list, c->max_int_list * sizeof *c->int_list);
   for (i = 0; i < c->n_filters; ++i)
@@ -436,6 +724,8 @@ static void _coloring_destroy (ramsey_t *rt)
 
   if (c->base_sequence)
     c->base_sequence->destroy (c->base_sequence);
+  nogood_store_destroy (c->nogoods);
+  child_order_clear (&c->order);
   for (i = 0; i < c->n_cells; ++i)
     c->sequence[i]->destroy (c->sequence[i]);
   for (i = 0; i < c->n_filters; ++i)
@@ -467,6 +757,9 @@ void *coloring_new_direct (int n_colors, const ramsey_t *base_sequence)
   rv->destroy = _coloring_destroy;
   rv->randomize = _coloring_randomize;
   rv->recurse = _coloring_recurse;
+  rv->get_n_children = _coloring_get_n_children;
+  rv->child_append   = _coloring_child_append;
+  rv->child_deappend = _coloring_child_deappend;
   recursion_init (rv);
 
   rv->find_value  = _coloring_find_value;
@@ -483,6 +776,10 @@ void *coloring_new_direct (int n_colors, const ramsey_t *base_sequence)
 
   rv->add_filter  = _coloring_add_filter;
   rv->run_filters = _coloring_run_filters;
+  rv->full_filters = _coloring_full_filters;
+  rv->get_allowed_cells = _coloring_get_allowed_cells;
+  rv->get_allowed_values = _coloring_get_allowed_values;
+  rv->explain = _coloring_explain;
 
   c->n_filters = 0;
   c->max_filters = DEFAULT_MAX_FILTERS;
@@ -493,6 +790,11 @@ void *coloring_new_direct (int n_colors, const ramsey_t *base_sequence)
   c->int_list = malloc (c->max_int_list * sizeof *c->int_list);
 
   c->has_symmetry = 1;
+  c->backjump = 0;
+  c->max_nogoods = 0;
+  c->nogoods = NULL;
+  child_order_init (&c->order, ORDER_NATURAL);
+  c->prechecked = 0;
   c->n_cells = n_colors;
   if (base_sequence)
     c->base_sequence = base_sequence->clone (base_sequence);
@@ -521,13 +823,32 @@ void *coloring_new (const setting_list_t *vars)
 {
   const setting_t *n_colors_set = vars->get_setting (vars, "n_colors");
   const setting_t *base_sequence_set = vars->get_setting (vars, "base_sequence");
+  const setting_t *backjump_set = vars->get_setting (vars, "backjump");
+  const setting_t *learn_nogoods_set = vars->get_setting (vars, "learn_nogoods");
+  struct _coloring *rv;
+
   if (n_colors_set == NULL)
     {
       fprintf (stderr, "Error: coloring requires variable ``n_colors'' set.\n");
       return NULL;
     }
-  return coloring_new_direct (n_colors_set->get_int_value (n_colors_set),
-                              base_sequence_set == NULL ? NULL :
-                              base_sequence_set->get_ramsey_value (base_sequence_set));
+  rv = coloring_new_direct (n_colors_set->get_int_value (n_colors_set),
+                            base_sequence_set == NULL ? NULL :
+                            base_sequence_set->get_ramsey_value (base_sequence_set));
+  if (rv != NULL && backjump_set != NULL)
+    rv->backjump = backjump_set->get_int_value (backjump_set);
+  if (rv != NULL && learn_nogoods_set != NULL)
+    rv->max_nogoods = learn_nogoods_set->get_int_value (learn_nogoods_set);
+  if (rv != NULL && !child_order_get (vars, &rv->order.how))
+    {
+      _coloring_destroy ((ramsey_t *) rv);
+      return NULL;
+    }
+  return rv;
 }
 
+const ramsey_t *coloring_get_base_sequence (const ramsey_t *rt)
+{
+  assert (rt && rt->type == TYPE_COLORING);
+  return ((const struct _coloring *) rt)->base_sequence;
+}
@@ -42,4 +42,10 @@ void *coloring_new (const setting_list_t *vars);
  */
 void *coloring_new_direct (int n_colors, const ramsey_t *base_sequence);
 
+/*! \brief Return the sequence a coloring colors.
+ *
+ *  \return The base sequence, or NULL if the coloring colors [1 ...].
+ */
+const ramsey_t *coloring_get_base_sequence (const ramsey_t *rt);
+
 #endif
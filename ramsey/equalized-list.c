@@ -78,6 +78,39 @@ static int _qlist_run_filters (const ramsey_t *rt)
   return 0;
 }
 
+static int _qlist_full_filters (ramsey_t *rt)
+{
+  (void) rt;
+  fputs ("full_filters: unimplemented for equalized list.\n", stderr);
+  return 0;
+}
+
+static unsigned long _qlist_get_allowed_cells (const ramsey_t *rt, int value)
+{
+  (void) rt;
+  (void) value;
+  return ~0UL;
+}
+
+static unsigned long _qlist_get_allowed_values (const ramsey_t *rt,
+                                                const int *values, int n_values)
+{
+  (void) rt;
+  (void) values;
+  return CELL_MASK_ALL (n_values);
+}
+
+static int _qlist_explain (const ramsey_t *rt, int value, int cell,
+                           int *values, int max_values)
+{
+  (void) rt;
+  (void) value;
+  (void) cell;
+  (void) values;
+  (void) max_values;
+  return -1;
+}
+
 static int _qlist_add_filter (ramsey_t *rt, filter_t *f)
 {
   (void) rt;
@@ -94,6 +127,26 @@ static void _qlist_recurse (ramsey_t *rt, global_data_t *state)
   fputs ("recurse: unimplemented for equalized list.\n", stderr);
 }
 
+static int _qlist_get_n_children (ramsey_t *rt)
+{
+  (void) rt;
+  fputs ("get_n_children: unimplemented for equalized list.\n", stderr);
+  return 0;
+}
+
+static int _qlist_child_append (ramsey_t *rt, int index)
+{
+  (void) rt;
+  (void) index;
+  return 0;
+}
+
+static void _qlist_child_deappend (ramsey_t *rt, int index)
+{
+  (void) rt;
+  (void) index;
+}
+
 /* PRINT / PARSE */
 static void _qlist_print (const ramsey_t *rt, stream_t *out)
 {
@@ -168,7 +221,7 @@ static const char *_qlist_parse (ramsey_t *rt, const char *data)
   return data;
 }
 
-static void _qlist_randomize (ramsey_t *rt, int n)
+static void _qlist_randomize (ramsey_t *rt, int n, rng_t *rng)
 {
   ramsey_t *temp = sequence_new_direct ();
   struct _qlist *ql = (struct _qlist *) rt;
@@ -176,7 +229,7 @@ static void _qlist_randomize (ramsey_t *rt, int n)
   assert (rt && rt->type == TYPE_EQUALIZED_LIST);
 
   /* Use a sequence, steal its data */
-  temp->randomize (temp, n);
+  temp->randomize (temp, n, rng);
   _qlist_rob_sequence (ql, temp);
   temp->destroy (temp);
 }
@@ -399,6 +452,9 @@ void *equalized_list_new (const setting_list_t *vars)
   rv->destroy = _qlist_destroy;
   rv->randomize = _qlist_randomize;
   rv->recurse = _qlist_recurse;
+  rv->get_n_children = _qlist_get_n_children;
+  rv->child_append   = _qlist_child_append;
+  rv->child_deappend = _qlist_child_deappend;
 
   rv->find_value  = _qlist_find_value;
   rv->get_length  = _qlist_get_length;
@@ -413,6 +469,10 @@ void *equalized_list_new (const setting_list_t *vars)
 
   rv->add_filter  = _qlist_add_filter;
   rv->run_filters = _qlist_run_filters;
+  rv->full_filters = _qlist_full_filters;
+  rv->get_allowed_cells = _qlist_get_allowed_cells;
+  rv->get_allowed_values = _qlist_get_allowed_values;
+  rv->explain = _qlist_explain;
 
   ql->size = 0;
   ql->max_size = DEFAULT_MAX_LENGTH;
@@ -38,6 +38,9 @@
 #define DEFAULT_MAX_LENGTH	400
 /*! \brief Default number of filters. */
 #define DEFAULT_MAX_FILTERS	20
+/*! \brief Largest number of possible rows (n_colors ^ n_columns) for
+ *         which row-at-a-time recursion will build its tables. */
+#define MAX_ROW_CODES	4096
 
 /*! \brief Private data for the lattice type. */
 struct _lattice {
@@ -61,8 +64,35 @@ struct _lattice {
   int n_columns;
   /*! \brief Number of colors used for the lattice. */
   int n_colors;
+
+  /*! \brief Whether to recurse a whole row at a time (see row-search
+   *         in the README). */
+  int row_search;
+  /*! \brief Table of rows which pass the filters on their own, n_columns
+   *         entries per row, or NULL if the table has not been built. */
+  int *row;
+  /*! \brief Number of rows in the row table. */
+  int n_rows;
+  /*! \brief Maps a row's color code (see _lattice_row_code) to its index
+   *         in the row table, or -1 if the row is not in the table. */
+  int *row_index;
+  /*! \brief For each row in the table, the list of rows which may be
+   *         placed directly above it. */
+  int **row_next;
+  /*! \brief Length of each list in row_next. */
+  int *n_row_next;
+  /*! \brief List of every row in the table, used for the bottom row. */
+  int *row_all;
+  /*! \brief Length of the lattice when it was first extended a row at a
+   *         time, or -1. Everything longer was built a row at a time. */
+  int row_base;
+  /*! \brief Whether the filters passed on the lattice as it stands, so
+   *         that run_filters need not check it again. */
+  bool prechecked;
 };
 
+static void _lattice_free_rows (struct _lattice *lat);
+
 static const char *_lattice_get_type (const ramsey_t *rt)
 {
   assert (rt && rt->type == TYPE_LATTICE);
@@ -84,12 +114,57 @@ static int _lattice_run_filters (const ramsey_t *rt)
 
   assert (rt && rt->type == TYPE_LATTICE);
 
+  if (lat->prechecked)
+    return 1;
   for (i = 0; i < lat->n_filters; ++i)
     if (!lat->filter[i]->run (lat->filter[i], rt))
       return 0;
   return 1;
 }
 
+static int _lattice_full_filters (ramsey_t *rt)
+{
+  struct _lattice *lat = (struct _lattice *) rt;
+  int i, rv = 1;
+
+  assert (rt && rt->type == TYPE_LATTICE);
+
+  lat->prechecked = 0;
+  for (i = 0; i < lat->n_filters; ++i)
+    rv &= lat->filter[i]->set_mode (lat->filter[i], MODE_FULL);
+  return rv;
+}
+
+static unsigned long _lattice_get_allowed_values (const ramsey_t *rt,
+                                                  const int *values, int n_values)
+{
+  const struct _lattice *lat = (struct _lattice *) rt;
+  unsigned long rv = CELL_MASK_ALL (n_values);
+  int i;
+
+  assert (rt && rt->type == TYPE_LATTICE);
+
+  for (i = 0; i < lat->n_filters && rv; ++i)
+    rv &= filter_get_allowed_values (lat->filter[i], rt, values, n_values);
+  return rv;
+}
+
+static unsigned long _lattice_get_allowed_cells (const ramsey_t *rt, int value)
+{
+  return _lattice_get_allowed_values (rt, &value, 1);
+}
+
+static int _lattice_explain (const ramsey_t *rt, int value, int cell,
+                             int *values, int max_values)
+{
+  (void) rt;
+  (void) value;
+  (void) cell;
+  (void) values;
+  (void) max_values;
+  return -1;
+}
+
 static int _lattice_add_filter (ramsey_t *rt, filter_t *f)
 {
   struct _lattice *lat = (struct _lattice *) rt;
@@ -115,30 +190,302 @@ static int _lattice_add_filter (ramsey_t *rt, filter_t *f)
 
   f->set_mode (f, MODE_LAST_ONLY);
   lat->filter[lat->n_filters++] = f;
+  lat->prechecked = 0;
+  /* Any row tables were built for the old filter set */
+  _lattice_free_rows (lat);
+  return 1;
+}
+
+/* ROW TABLES */
+/* Reads the n_columns colors starting at cells as a base-n_colors number */
+static int _lattice_row_code (const struct _lattice *lat, const int *cells)
+{
+  int i, code = 0;
+  for (i = 0; i < lat->n_columns; ++i)
+    code = code * lat->n_colors + (cells[i] - 1);
+  return code;
+}
+
+/* Appends the cells of a row to the lattice, running filters after each
+ * one. Returns the number of cells appended, which is less than n_columns
+ * if some cell failed (the failing cell is left appended). A whole row
+ * leaves the lattice prechecked, since its last cell has been filtered. */
+static int _lattice_row_append (ramsey_t *rt, const int *cells)
+{
+  struct _lattice *lat = (struct _lattice *) rt;
+  int i;
+  for (i = 0; i < lat->n_columns; ++i)
+    {
+      rt->append (rt, cells[i]);
+      if (!rt->run_filters (rt))
+        return i + 1;
+    }
+  lat->prechecked = 1;
+  return lat->n_columns;
+}
+
+static void _lattice_free_rows (struct _lattice *lat)
+{
+  int i;
+  if (lat->row_next)
+    for (i = 0; i < lat->n_rows; ++i)
+      free (lat->row_next[i]);
+  free (lat->row);
+  free (lat->row_index);
+  free (lat->row_next);
+  free (lat->n_row_next);
+  free (lat->row_all);
+  lat->row = NULL;
+  lat->row_index = NULL;
+  lat->row_next = NULL;
+  lat->n_row_next = NULL;
+  lat->row_all = NULL;
+  lat->n_rows = 0;
+  lat->row_base = -1;
+}
+
+/* Builds the table of rows which pass the lattice's filters when they
+ * are the bottom row, and for each such row, the rows which pass when
+ * placed on top of it. Since filters only look backward from the most
+ * recent cell, a row which fails in this small lattice will fail on top
+ * of any taller one, so the search only needs to consider these rows. */
+static int _lattice_build_rows (struct _lattice *lat)
+{
+  ramsey_t *scratch;
+  int n_codes = 1;
+  int i, j, k;
+
+  for (i = 0; i < lat->n_columns; ++i)
+    {
+      n_codes *= lat->n_colors;
+      if (n_codes > MAX_ROW_CODES)
+        {
+          fprintf (stderr, "Warning: too many possible rows (%d colors, %d columns) "
+                           "for row search; searching by cells instead.\n",
+                   lat->n_colors, lat->n_columns);
+          return 0;
+        }
+    }
+
+  scratch = ((ramsey_t *) lat)->clone ((ramsey_t *) lat);
+  lat->row = malloc (n_codes * lat->n_columns * sizeof *lat->row);
+  lat->row_index = malloc (n_codes * sizeof *lat->row_index);
+  lat->row_all = malloc (n_codes * sizeof *lat->row_all);
+  if (scratch == NULL || lat->row == NULL || lat->row_index == NULL ||
+      lat->row_all == NULL)
+    {
+      fprintf (stderr, "Out of memory building lattice row table!\n");
+      if (scratch)
+        scratch->destroy (scratch);
+      _lattice_free_rows (lat);
+      return 0;
+    }
+
+  /* Find rows which are valid on their own */
+  for (i = 0; i < n_codes; ++i)
+    {
+      int *cells = &lat->row[lat->n_rows * lat->n_columns];
+      int code = i;
+      for (j = lat->n_columns - 1; j >= 0; --j)
+        {
+          cells[j] = code % lat->n_colors + 1;
+          code /= lat->n_colors;
+        }
+
+      scratch->empty (scratch);
+      if (_lattice_row_append (scratch, cells) == lat->n_columns)
+        {
+          lat->row_index[i] = lat->n_rows;
+          lat->row_all[lat->n_rows] = lat->n_rows;
+          ++lat->n_rows;
+        }
+      else
+        lat->row_index[i] = -1;
+    }
+
+  /* Find which rows may follow each of them */
+  lat->row_next = calloc (lat->n_rows, sizeof *lat->row_next);
+  lat->n_row_next = calloc (lat->n_rows, sizeof *lat->n_row_next);
+  if (lat->row_next == NULL || lat->n_row_next == NULL)
+    {
+      fprintf (stderr, "Out of memory building lattice row table!\n");
+      scratch->destroy (scratch);
+      _lattice_free_rows (lat);
+      return 0;
+    }
+  for (i = 0; i < lat->n_rows; ++i)
+    {
+      lat->row_next[i] = malloc (lat->n_rows * sizeof *lat->row_next[i]);
+      if (lat->row_next[i] == NULL)
+        {
+          fprintf (stderr, "Out of memory building lattice row table!\n");
+          scratch->destroy (scratch);
+          _lattice_free_rows (lat);
+          return 0;
+        }
+
+      for (k = 0; k < lat->n_rows; ++k)
+        {
+          scratch->empty (scratch);
+          for (j = 0; j < lat->n_columns; ++j)
+            scratch->append (scratch, lat->row[i * lat->n_columns + j]);
+          if (_lattice_row_append (scratch, &lat->row[k * lat->n_columns])
+              == lat->n_columns)
+            lat->row_next[i][lat->n_row_next[i]++] = k;
+        }
+    }
+
+  scratch->destroy (scratch);
   return 1;
 }
 
 /* RECURSION */
+/* Whether the lattice should be extended a whole row at a time, building
+ * the row tables if necessary. Row-at-a-time recursion relies on pruning,
+ * and needs the lattice to be made of whole rows. */
+static int _lattice_use_rows (struct _lattice *lat)
+{
+  if (lat->row_search && lat->parent.r_prune_tree &&
+      lat->top_value % lat->n_columns == 0)
+    {
+      if (lat->row != NULL || _lattice_build_rows (lat))
+        {
+          if (lat->row_base < 0 || lat->top_value < lat->row_base)
+            lat->row_base = lat->top_value;
+          return 1;
+        }
+      lat->row_search = 0;
+    }
+  return 0;
+}
+
+/* Finds the rows which may be placed on top of the lattice. Only rows
+ * compatible with the current top row need to be tried. */
+static int _lattice_row_children (const struct _lattice *lat, const int **next)
+{
+  *next = lat->row_all;
+  if (lat->top_value > 0)
+    {
+      int code = _lattice_row_code (lat, &lat->value[lat->top_value - lat->n_columns]);
+      int idx = lat->row_index[code];
+      if (idx >= 0)
+        {
+          *next = lat->row_next[idx];
+          return lat->n_row_next[idx];
+        }
+    }
+  return lat->n_rows;
+}
+
+static void _lattice_row_recurse (ramsey_t *rt, global_data_t *state)
+{
+  struct _lattice *lat = (struct _lattice *) rt;
+  const int *next;
+  int n_next;
+  int i;
+
+  if (!recursion_preamble (rt, state))
+    return;
+
+  n_next = _lattice_row_children (lat, &next);
+  for (i = 0; i < n_next; ++i)
+    {
+      int n_appended = _lattice_row_append (rt, &lat->row[next[i] * lat->n_columns]);
+      if (n_appended == lat->n_columns)
+        rt->recurse (rt, state);
+      while (n_appended--)
+        rt->deappend (rt);
+    }
+
+  recursion_postamble (rt);
+}
+
 static void _lattice_recurse (ramsey_t *rt, global_data_t *state)
 {
+  unsigned long allowed = ~0UL;
   int i;
   struct _lattice *lat = (struct _lattice *) rt;
 
   assert (rt && rt->type == TYPE_LATTICE);
 
+  if (_lattice_use_rows (lat))
+    {
+      _lattice_row_recurse (rt, state);
+      return;
+    }
+
   if (!recursion_preamble (rt, state))
     return;
 
-  for (i = 1; i <= lat->n_colors; ++i)
+  /* Evaluate every color at once, and skip those the filters reject */
+  if (rt->r_prune_tree && lat->n_colors <= CELL_MASK_BITS)
     {
-      rt->append (rt, i);
-      rt->recurse (rt, state);
-      rt->deappend (rt);
+      int colors[CELL_MASK_BITS];
+      for (i = 0; i < lat->n_colors; ++i)
+        colors[i] = i + 1;
+      allowed = rt->get_allowed_values (rt, colors, lat->n_colors);
     }
 
+  for (i = 1; i <= lat->n_colors; ++i)
+    if (i > CELL_MASK_BITS || (allowed & (1UL << (i - 1))))
+      {
+        rt->append (rt, i);
+        rt->recurse (rt, state);
+        rt->deappend (rt);
+      }
+
   recursion_postamble (rt);
 }
 
+static int _lattice_get_n_children (ramsey_t *rt)
+{
+  struct _lattice *lat = (struct _lattice *) rt;
+  const int *next;
+
+  assert (rt && rt->type == TYPE_LATTICE);
+
+  if (_lattice_use_rows (lat))
+    return _lattice_row_children (lat, &next);
+  return lat->n_colors;
+}
+
+static int _lattice_child_append (ramsey_t *rt, int index)
+{
+  struct _lattice *lat = (struct _lattice *) rt;
+
+  assert (rt && rt->type == TYPE_LATTICE);
+
+  if (_lattice_use_rows (lat))
+    {
+      const int *next;
+      int n_appended;
+
+      _lattice_row_children (lat, &next);
+      n_appended = _lattice_row_append (rt, &lat->row[next[index] * lat->n_columns]);
+      if (n_appended == lat->n_columns)
+        return 1;
+      while (n_appended--)
+        rt->deappend (rt);
+      return 0;
+    }
+  return rt->append (rt, index + 1);
+}
+
+static void _lattice_child_deappend (ramsey_t *rt, int index)
+{
+  struct _lattice *lat = (struct _lattice *) rt;
+  int i;
+
+  (void) index;
+  assert (rt && rt->type == TYPE_LATTICE);
+
+  if (lat->row_base >= 0 && lat->top_value > lat->row_base)
+    for (i = 0; i < lat->n_columns; ++i)
+      rt->deappend (rt);
+  else
+    rt->deappend (rt);
+}
+
 /* PRINT / PARSE */
 static void _lattice_print (const ramsey_t *rt, stream_t *out)
 {
@@ -166,9 +513,10 @@ static const char *_lattice_parse (ramsey_t *rt, const char *data)
   return data;
 }
 
-static void _lattice_randomize (ramsey_t *rt, int n)
+static void _lattice_randomize (ramsey_t *rt, int n, rng_t *rng)
 {
   (void) n;
+  (void) rng;
   fprintf (stderr, "Warning: randomize() unimplemented for ``%s''.\n",
            rt->get_type (rt));
 }
@@ -199,6 +547,8 @@ static void *_lattice_get_priv_data (ramsey_t *rt)
 {
   struct _lattice *lat = (struct _lattice *) rt;
   assert (rt && rt->type == TYPE_LATTICE);
+  /* The caller may change values behind our back */
+  lat->prechecked = 0;
   return lat->value;
 }
 
@@ -224,6 +574,7 @@ static int _lattice_append (ramsey_t *rt, int value)
       lat->value = re;
     }
 
+  lat->prechecked = 0;
   lat->value[lat->top_value++] = value;
   return 1;
 }
@@ -232,6 +583,7 @@ static int _lattice_deappend (ramsey_t *rt)
 {
   struct _lattice *lat = (struct _lattice *) rt;
   assert (rt && rt->type == TYPE_LATTICE);
+  lat->prechecked = 0;
   if (lat->top_value)
     --lat->top_value;
   else
@@ -261,6 +613,7 @@ static void _lattice_empty (ramsey_t *rt)
   struct _lattice *lat = (struct _lattice *) rt;
   assert (rt && rt->type == TYPE_LATTICE);
   lat->top_value = 0;
+  lat->prechecked = 0;
 }
 
 static void _lattice_reset (ramsey_t *rt)
@@ -272,7 +625,9 @@ static void _lattice_reset (ramsey_t *rt)
   for (i = 0; i < lat->n_filters; ++i)
     lat->filter[i]->destroy (lat->filter[i]);
 
+  _lattice_free_rows (lat);
   lat->top_value = 0;
+  lat->prechecked = 0;
   lat->n_filters = 0;
   recursion_init (rt);
 }
@@ -289,10 +644,28 @@ static ramsey_t *_lattice_clone (const ramsey_t *rt)
 
   memcpy (lat, rt, sizeof *lat);
 
+  lat->value  = malloc (lat->max_value * sizeof *lat->value);
   lat->filter = malloc (lat->max_filters * sizeof *lat->filter);
+  if (lat->value == NULL || lat->filter == NULL)
+    {
+      free (lat->value);
+      free (lat->filter);
+      free (lat);
+      return NULL;
+    }
+  memcpy (lat->value, old_lat->value, lat->top_value * sizeof *lat->value);
   for (i = 0; i < lat->n_filters; ++i)
     lat->filter[i] = old_lat->filter[i]->clone (old_lat->filter[i]);
 
+  /* Row tables are rebuilt on demand rather than copied */
+  lat->row = NULL;
+  lat->row_index = NULL;
+  lat->row_next = NULL;
+  lat->n_row_next = NULL;
+  lat->row_all = NULL;
+  lat->n_rows = 0;
+  lat->row_base = -1;
+
   return (ramsey_t *) lat;
 }
 
@@ -305,6 +678,8 @@ static void _lattice_destroy (ramsey_t *rt)
   for (i = 0; i < lat->n_filters; ++i)
     lat->filter[i]->destroy (lat->filter[i]);
 
+  _lattice_free_rows (lat);
+  free (lat->filter);
   free (lat->value);
   free (lat);
 }
@@ -313,6 +688,7 @@ void *lattice_new (const setting_list_t *vars)
 {
   const setting_t *n_colors_set  = vars->get_setting (vars, "n_colors");
   const setting_t *n_columns_set = vars->get_setting (vars, "n_columns");
+  const setting_t *row_search_set = vars->get_setting (vars, "row_search");
   struct _lattice *lat = malloc (sizeof *lat);
   ramsey_t *rv = (ramsey_t *) lat;
 
@@ -345,6 +721,9 @@ void *lattice_new (const setting_list_t *vars)
   rv->destroy = _lattice_destroy;
   rv->randomize = _lattice_randomize;
   rv->recurse = _lattice_recurse;
+  rv->get_n_children = _lattice_get_n_children;
+  rv->child_append   = _lattice_child_append;
+  rv->child_deappend = _lattice_child_deappend;
   recursion_init (rv);
 
   rv->find_value  = _lattice_find_value;
@@ -360,10 +739,23 @@ void *lattice_new (const setting_list_t *vars)
 
   rv->add_filter  = _lattice_add_filter;
   rv->run_filters = _lattice_run_filters;
+  rv->full_filters = _lattice_full_filters;
+  rv->get_allowed_cells = _lattice_get_allowed_cells;
+  rv->get_allowed_values = _lattice_get_allowed_values;
+  rv->explain = _lattice_explain;
 
   lat->n_columns = n_columns_set->get_int_value (n_columns_set);
   lat->n_colors  = n_colors_set->get_int_value (n_colors_set);
+  lat->row_search = row_search_set && row_search_set->get_int_value (row_search_set);
+  lat->row = NULL;
+  lat->row_index = NULL;
+  lat->row_next = NULL;
+  lat->n_row_next = NULL;
+  lat->row_all = NULL;
+  lat->n_rows = 0;
+  lat->row_base = -1;
   lat->top_value = 0;
+  lat->prechecked = 0;
   lat->n_filters = 0;
   lat->max_value = DEFAULT_MAX_LENGTH;
   lat->value = malloc (lat->max_value * sizeof *lat->value);
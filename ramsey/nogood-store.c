@@ -0,0 +1,239 @@
+/* RamseyScript
+ * Written in 2012 by
+ *   Andrew Poelstra <apoelstra@wpsoftware.net>
+ *
+ * To the extent possible under law, the author(s) have dedicated all
+ * copyright and related and neighboring rights to this software to
+ * the public domain worldwide. This software is distributed without
+ * any warranty.
+ *
+ * You should have received a copy of the CC0 Public Domain Dedication
+ * along with this software.
+ * If not, see <http://creativecommons.org/publicdomain/zero/1.0/>.
+ */
+
+/*! \file nogood-store.c
+ *  \brief Implementation of the nogood store.
+ *
+ *  Colorings are built one position at a time, in order, so a nogood
+ *  can only become fully true when its last position is colored. Each
+ *  nogood is therefore indexed (``watched'') by its last position and
+ *  that position's color, and only the nogoods watching a given
+ *  (position, color) pair are checked when it is tried.
+ *
+ *  When the store is full, the nogood to replace is chosen by the
+ *  CLOCK approximation of least-recently-used: a hand sweeps round the
+ *  store, giving nogoods used since its last pass a second chance.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+
+#include "../global.h"
+#include "nogood-store.h"
+
+/*! \brief Default number of nogoods allocated. */
+#define DEFAULT_MAX_NOGOODS	1024
+
+/*! \brief A single learned nogood. */
+struct _nogood {
+  /*! \brief Positions other than the watched one. */
+  int *position;
+  /*! \brief The color each of these positions must have. */
+  int *color;
+  /*! \brief Number of positions other than the watched one. */
+  int length;
+  /*! \brief Index of the watched (position, color) pair in the head list. */
+  int watch;
+  /*! \brief Next nogood with the same watched pair, or -1. */
+  int next;
+  /*! \brief Whether the nogood has been used since the hand last passed. */
+  bool used;
+};
+
+/*! \brief Private data for the nogood store. */
+struct _nogood_store_t {
+  /*! \brief Number of colors in the colorings. */
+  int n_colors;
+
+  /*! \brief The nogoods. */
+  struct _nogood *nogood;
+  /*! \brief Number of nogoods stored. */
+  int n_nogoods;
+  /*! \brief Number of nogoods allocated. */
+  int alloc_nogoods;
+  /*! \brief Maximum number of nogoods to keep. */
+  int max_nogoods;
+  /*! \brief Position of the clock hand. */
+  int hand;
+
+  /*! \brief First nogood watching each (position, color) pair, or -1. */
+  int *head;
+  /*! \brief Number of heads allocated. */
+  int n_heads;
+};
+
+nogood_store_t *nogood_store_new (int n_colors, int max_nogoods)
+{
+  nogood_store_t *rv = malloc (sizeof *rv);
+  if (rv == NULL)
+    return NULL;
+
+  rv->n_colors = n_colors;
+  rv->n_nogoods = 0;
+  rv->alloc_nogoods = 0;
+  rv->max_nogoods = max_nogoods;
+  rv->hand = 0;
+  rv->nogood = NULL;
+  rv->head = NULL;
+  rv->n_heads = 0;
+  return rv;
+}
+
+/* Returns a free nogood slot, evicting an old nogood if necessary */
+static struct _nogood *_nogood_store_get_slot (nogood_store_t *store)
+{
+  struct _nogood *ng;
+  int *link;
+
+  if (store->n_nogoods < store->max_nogoods)
+    {
+      if (store->n_nogoods == store->alloc_nogoods)
+        {
+          int new_alloc = store->alloc_nogoods ? 2 * store->alloc_nogoods
+                                               : DEFAULT_MAX_NOGOODS;
+          void *tmp;
+          if (new_alloc > store->max_nogoods)
+            new_alloc = store->max_nogoods;
+          tmp = realloc (store->nogood, new_alloc * sizeof *store->nogood);
+          if (tmp == NULL)
+            return NULL;
+          store->nogood = tmp;
+          store->alloc_nogoods = new_alloc;
+        }
+      ng = &store->nogood[store->n_nogoods++];
+      ng->position = NULL;
+      return ng;
+    }
+
+  /* Full; sweep the hand round to a nogood that has not been used */
+  while (store->nogood[store->hand].used)
+    {
+      store->nogood[store->hand].used = 0;
+      store->hand = (store->hand + 1) % store->n_nogoods;
+    }
+  ng = &store->nogood[store->hand];
+  store->hand = (store->hand + 1) % store->n_nogoods;
+
+  /* Unlink it from its watch list */
+  for (link = &store->head[ng->watch]; *link != ng - store->nogood;
+       link = &store->nogood[*link].next)
+    assert (*link >= 0);
+  *link = ng->next;
+  return ng;
+}
+
+void nogood_store_add (nogood_store_t *store, const int *positions,
+                       const int *colors, int n)
+{
+  struct _nogood *ng;
+  int last = 0;
+  int watch;
+  int i, j;
+
+  assert (store != NULL);
+  if (n < 1 || store->max_nogoods < 1)
+    return;
+
+  for (i = 1; i < n; ++i)
+    if (positions[i] > positions[last])
+      last = i;
+  watch = positions[last] * store->n_colors + colors[positions[last] - 1];
+
+  if (watch >= store->n_heads)
+    {
+      int new_n = 2 * watch + 1;
+      void *tmp = realloc (store->head, new_n * sizeof *store->head);
+      if (tmp == NULL)
+        return;
+      store->head = tmp;
+      for (i = store->n_heads; i < new_n; ++i)
+        store->head[i] = -1;
+      store->n_heads = new_n;
+    }
+
+  ng = _nogood_store_get_slot (store);
+  if (ng == NULL)
+    return;
+  free (ng->position);
+  ng->position = malloc (2 * n * sizeof *ng->position);
+  if (ng->position == NULL)
+    {
+      /* Leave an empty nogood, which can never be matched */
+      ng->color = NULL;
+      ng->length = -1;
+      ng->used = 0;
+      ng->watch = 0;
+      ng->next = store->head[0];
+      store->head[0] = ng - store->nogood;
+      return;
+    }
+  ng->color = ng->position + n;
+  ng->length = 0;
+  for (i = 0; i < n; ++i)
+    if (i != last)
+      {
+        j = ng->length++;
+        ng->position[j] = positions[i];
+        ng->color[j] = colors[positions[i] - 1];
+      }
+  ng->watch = watch;
+  ng->used = 0;
+  ng->next = store->head[watch];
+  store->head[watch] = ng - store->nogood;
+}
+
+int nogood_store_find (nogood_store_t *store, int position, int color,
+                       const int *colors, int *positions, int max_positions)
+{
+  int watch = position * store->n_colors + color;
+  int i, j;
+
+  assert (store != NULL);
+  if (watch >= store->n_heads)
+    return -1;
+
+  for (i = store->head[watch]; i >= 0; i = store->nogood[i].next)
+    {
+      struct _nogood *ng = &store->nogood[i];
+
+      if (ng->length < 0)
+        continue;
+      for (j = 0; j < ng->length; ++j)
+        if (colors[ng->position[j] - 1] != ng->color[j])
+          break;
+      if (j == ng->length && (positions == NULL || ng->length <= max_positions))
+        {
+          ng->used = 1;
+          if (positions != NULL)
+            memcpy (positions, ng->position, ng->length * sizeof *positions);
+          return ng->length;
+        }
+    }
+  return -1;
+}
+
+void nogood_store_destroy (nogood_store_t *store)
+{
+  int i;
+
+  if (store == NULL)
+    return;
+  for (i = 0; i < store->n_nogoods; ++i)
+    free (store->nogood[i].position);
+  free (store->nogood);
+  free (store->head);
+  free (store);
+}
@@ -0,0 +1,73 @@
+/* RamseyScript
+ * Written in 2012 by
+ *   Andrew Poelstra <apoelstra@wpsoftware.net>
+ *
+ * To the extent possible under law, the author(s) have dedicated all
+ * copyright and related and neighboring rights to this software to
+ * the public domain worldwide. This software is distributed without
+ * any warranty.
+ *
+ * You should have received a copy of the CC0 Public Domain Dedication
+ * along with this software.
+ * If not, see <http://creativecommons.org/publicdomain/zero/1.0/>.
+ */
+
+/*! \file nogood-store.h
+ *  \brief Defines a bounded store of learned nogoods for colorings.
+ *
+ *  A nogood is a set of (position, color) pairs which cannot all hold
+ *  in a coloring that extends any further than where it was learned.
+ *  Colorings learn them at dead ends of the search, and use them to
+ *  skip colors which would only lead back into the same dead end.
+ */
+
+#ifndef NOGOOD_STORE_H
+#define NOGOOD_STORE_H
+
+/*! \brief Convienence typedef for the nogood store. */
+typedef struct _nogood_store_t nogood_store_t;
+
+/*! \brief Create a new, empty nogood store.
+ *
+ *  \param [in] n_colors     The number of colors in the colorings.
+ *  \param [in] max_nogoods  The most nogoods to keep. Once this many
+ *                           have been learned, new ones replace those
+ *                           which have not been used recently.
+ *
+ *  \return A newly allocated store, or NULL on failure.
+ */
+nogood_store_t *nogood_store_new (int n_colors, int max_nogoods);
+
+/*! \brief Add a nogood to the store.
+ *
+ *  \param [in] store      The store.
+ *  \param [in] positions  The positions in the nogood (counting from 1).
+ *  \param [in] colors     The colors of each position, indexed by
+ *                         position - 1.
+ *  \param [in] n          The number of positions.
+ */
+void nogood_store_add (nogood_store_t *store, const int *positions,
+                       const int *colors, int n);
+
+/*! \brief Look for a nogood forbidding a position from having a color.
+ *
+ *  \param [in]  store      The store.
+ *  \param [in]  position   The position about to be colored. All
+ *                          earlier positions must be colored.
+ *  \param [in]  color      The color it is about to get.
+ *  \param [in]  colors     The colors of the earlier positions, indexed
+ *                          by position - 1.
+ *  \param [out] positions  If not NULL, the other positions of the
+ *                          nogood found are stored here.
+ *  \param [in]  max_positions  The space available in positions.
+ *
+ *  \return The number of other positions in the nogood found, or -1 if
+ *          there is none (or positions is too small to hold it).
+ */
+int nogood_store_find (nogood_store_t *store, int position, int color,
+                       const int *colors, int *positions, int max_positions);
+
+/*! \brief Destroy a nogood store and free its resources. */
+void nogood_store_destroy (nogood_store_t *store);
+
+#endif
@@ -44,7 +44,7 @@ static const char *_permutation_get_type (const ramsey_t *rt)
 
 static int _permutation_add_filter (ramsey_t *rt, filter_t *f)
 {
-  if (sequence_prototype()->add_filter (rt, f))
+  if (sequence_add_filter (rt, f))
     {
       f->set_mode (f, MODE_FULL);
       return 1;
@@ -83,6 +83,38 @@ static void _permutation_recurse (ramsey_t *rt, global_data_t *state)
   recursion_postamble (rt);
 }
 
+/* Child i has the new number inserted i places from the end, which is
+ * where the shuffling in _permutation_recurse leaves it. */
+static int _permutation_get_n_children (ramsey_t *rt)
+{
+  assert (rt && rt->type == TYPE_PERMUTATION);
+  return rt->get_length (rt) + 1;
+}
+
+static int _permutation_child_append (ramsey_t *rt, int index)
+{
+  int len = rt->get_length (rt);
+  int *val;
+  assert (rt && rt->type == TYPE_PERMUTATION);
+
+  if (!rt->append (rt, len + 1))
+    return 0;
+  val = rt->get_priv_data (rt);
+  memmove (&val[len - index + 1], &val[len - index], index * sizeof *val);
+  val[len - index] = len + 1;
+  return 1;
+}
+
+static void _permutation_child_deappend (ramsey_t *rt, int index)
+{
+  int len = rt->get_length (rt) - 1;
+  int *val = rt->get_priv_data (rt);
+  assert (rt && rt->type == TYPE_PERMUTATION);
+
+  memmove (&val[len - index], &val[len - index + 1], index * sizeof *val);
+  rt->deappend (rt);
+}
+
 void *permutation_new (const setting_list_t *vars)
 {
   ramsey_t *rv = sequence_new (vars);
@@ -92,6 +124,9 @@ void *permutation_new (const setting_list_t *vars)
       rv->type = TYPE_PERMUTATION;
       rv->get_type = _permutation_get_type;
       rv->recurse  = _permutation_recurse;
+      rv->get_n_children = _permutation_get_n_children;
+      rv->child_append   = _permutation_child_append;
+      rv->child_deappend = _permutation_child_deappend;
       rv->add_filter = _permutation_add_filter;
     }
   return rv;
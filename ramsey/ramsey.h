@@ -19,11 +19,13 @@
 #ifndef RAMSEY_H
 #define RAMSEY_H
 
+#include <limits.h>
 #include <time.h>
 
 #include "../global.h"
 #include "../stream.h"
 #include "../recurse.h"
+#include "../rng.h"
 #include "../setting.h"
 
 /*! \brief The main Ramsey type.
@@ -65,6 +67,17 @@ struct _ramsey_t {
   time_t r_start_time;
   /*! \brief Maximum allowable runtime (in seconds) */
   long r_max_run_time;
+  /*! \brief Number of shards the search is split between (1 for none,
+   *         or 0 if the shard variable is malformed). */
+  int r_n_shards;
+  /*! \brief Which shard this search is, from 0 to r_n_shards - 1. */
+  int r_shard;
+  /*! \brief Depth at which subtrees are shared out between shards. */
+  int r_shard_depth;
+  /*! \brief Whether subtrees go to shards in turn, rather than by hash. */
+  bool r_shard_by_index;
+  /*! \brief Number of objects reached at r_shard_depth so far. */
+  long r_shard_counter;
 
   /* vtable */
   /*! \brief Returns a string describing the object. */
@@ -73,8 +86,9 @@ struct _ramsey_t {
   /*! \brief Populate the object from a stringized description. Returns a
    *         a pointer into the string just past the last character used. */
   const char *(*parse) (ramsey_t *, const char *data);
-  /*! \brief Populate the object randomly, given a target length. */
-  void (*randomize)    (ramsey_t *, int);
+  /*! \brief Populate the object randomly, given a target length and
+   *         the random number generator to use. */
+  void (*randomize)    (ramsey_t *, int, rng_t *);
   /*! \brief Output a text representation of the object to the given stream. */
   void (*print)        (const ramsey_t *, stream_t *);
   /*! \brief Covert the object into a nil object (i.e., empty sequence,
@@ -99,10 +113,23 @@ struct _ramsey_t {
   int (*add_filter)  (ramsey_t *, filter_t *);
   /*! \brief Run all attached filters on the object. Returns 1 for pass, 0 for fail. */
   int (*run_filters) (const ramsey_t *);
+  /*! \brief Switch all attached filters to check the whole object, rather
+   *         than only its last value. Returns 0 if some filter cannot. */
+  int (*full_filters) (ramsey_t *);
 
   /*! \brief Recursively search a space of objects, using the given object
    *         as a seed. */
   void (*recurse)       (ramsey_t *, global_data_t *);
+  /*! \brief Returns the number of children the object has in its search
+   *         space. Together with child_append() and child_deappend(), this
+   *         lets a search be driven without recursing on the C stack. */
+  int (*get_n_children) (ramsey_t *);
+  /*! \brief Turn the object into its given child, exactly as recurse()
+   *         would before recursing on it. Returns 0, leaving the object
+   *         unchanged, if recurse() would skip that child. */
+  int (*child_append)   (ramsey_t *, int index);
+  /*! \brief Undo a successful child_append() of the given child. */
+  void (*child_deappend) (ramsey_t *, int index);
 
   /*! \brief Returns the length of the object. */
   int (*get_length)  (const ramsey_t *);
@@ -122,6 +149,29 @@ struct _ramsey_t {
   /*! \brief Finds a value in the object. Returns the cell in which it
     *        was found, or NULL if the number does not exist. */
   const ramsey_t *(*find_value) (const ramsey_t *, int);
+  /*! \brief Returns a mask of the cells into which a value could be added
+   *         without failing the object's filters. Bit i corresponds to
+   *         cell i; single-cell objects (i.e., sequences) only use bit 0.
+   *
+   *  A cleared bit means the filters would certainly reject the new value,
+   *  while a set bit means they might not. This assumes the object passes
+   *  its filters as it stands, so it is only useful when pruning. */
+  unsigned long (*get_allowed_cells) (const ramsey_t *, int value);
+  /*! \brief Returns a mask of which of several candidate values could be
+   *         appended to the object without failing its filters, bit i
+   *         corresponding to values[i].
+   *
+   *  This evaluates all the children of an append-style recursion at
+   *  once. As with get_allowed_cells(), a cleared bit is a guarantee and
+   *  a set bit is not, and n_values must be at most CELL_MASK_BITS. */
+  unsigned long (*get_allowed_values) (const ramsey_t *, const int *values, int n_values);
+  /*! \brief Explains why a value cannot be added to the given cell of the
+   *         object: stores values already in the object which, with the
+   *         new value, violate one of its filters, and returns how many.
+   *
+   *  Returns -1 if no filter can explain a violation. See the explain()
+   *  method of filter_t. */
+  int (*explain) (const ramsey_t *, int value, int cell, int *values, int max_values);
 
   /*! \brief Returns private data for the object. (Used for filters.)
    * 
@@ -146,6 +196,11 @@ struct _ramsey_t {
   const void *(*get_alt_priv_data_const) (const ramsey_t *);
 };
 
+/*! \brief Number of cells representable in a get_allowed_cells() mask. */
+#define CELL_MASK_BITS	((int) (CHAR_BIT * sizeof (unsigned long)))
+/*! \brief A mask with the low n bits set. */
+#define CELL_MASK_ALL(n)	((n) >= CELL_MASK_BITS ? ~0UL : (1UL << (n)) - 1)
+
 /*! \brief Constructor for a Ramsey object
  *
  *  \param [in] data   The name of the object's type (i.e., "sequence" or "coloring").
@@ -27,12 +27,15 @@
 
 #include "ramsey.h"
 #include "equalized-list.h"
+#include "../child-order.h"
 #include "sequence.h"
 
 /*! \brief Default allocation size for sequences. */
 #define DEFAULT_MAX_LENGTH	400
 /*! \brief Default number of filters. */
 #define DEFAULT_MAX_FILTERS	20
+/*! \brief Largest value range that find_value will build an index over. */
+#define MAX_INDEX_RANGE	65536
 
 /*! \brief Private data for the sequence type. */
 struct _sequence {
@@ -55,8 +58,75 @@ struct _sequence {
 
   /*! Set of allowable gap sizes when sequence is being recursively extended. */
   ramsey_t *gap_set;
+  /*! Alphabet of allowable values when the sequence is a word being
+   *  recursively extended. */
+  ramsey_t *alphabet;
+
+  /*! \brief Number of times each value in [index_min, index_min + index_size)
+   *         occurs in the sequence, or NULL if there is no index. The index
+   *         is built by the first find_value and then kept up to date by
+   *         append and deappend, so set lookups are O(1). */
+  int *index;
+  /*! \brief Smallest value covered by the index. */
+  int index_min;
+  /*! \brief Number of values covered by the index, or -1 if the sequence
+   *         is too spread out to be indexed. */
+  int index_size;
+  /*! \brief When index_size is -1, the length of the shortest prefix of the
+   *         sequence which is too spread out. Appending cannot change that,
+   *         so the index is not retried until deappend cuts into it. */
+  int index_spread_length;
+
+  /*! \brief Order in which the recursion tries gaps. */
+  child_order_t order;
+  /*! \brief Set when the last value was vetted by get_allowed_cells()
+   *         before being appended, so run_filters need not check it again.
+   *         Cleared whenever the sequence changes. */
+  bool prechecked;
 };
 
+static void _sequence_drop_index (struct _sequence *s)
+{
+  free (s->index);
+  s->index = NULL;
+  s->index_size = 0;
+}
+
+static void _sequence_build_index (struct _sequence *s)
+{
+  int i, min, max;
+
+  if (s->length == 0)
+    return;
+
+  min = max = s->value[0];
+  for (i = 1; i < s->length; ++i)
+    {
+      if (s->value[i] < min)
+        min = s->value[i];
+      if (s->value[i] > max)
+        max = s->value[i];
+      /* Leave room to grow, since the index is kept up to date on append */
+      if ((long) max - min >= MAX_INDEX_RANGE / 2)
+        {
+          s->index_size = -1;
+          s->index_spread_length = i + 1;
+          return;
+        }
+    }
+  s->index_min  = min;
+  s->index_size = 2 * (max - min + 1);
+  s->index = calloc (s->index_size, sizeof *s->index);
+  if (s->index == NULL)
+    {
+      s->index_size = -1;
+      s->index_spread_length = s->length;
+      return;
+    }
+  for (i = 0; i < s->length; ++i)
+    ++s->index[s->value[i] - min];
+}
+
 static const char *_sequence_get_type (const ramsey_t *rt)
 {
   assert (rt && rt->type == TYPE_SEQUENCE);
@@ -65,11 +135,20 @@ static const char *_sequence_get_type (const ramsey_t *rt)
 
 static const ramsey_t *_sequence_find_value (const ramsey_t *rt, int value)
 {
-  const struct _sequence *s = (struct _sequence *) rt;
+  struct _sequence *s = (struct _sequence *) rt;
   int i;
   assert (rt && (rt->type == TYPE_SEQUENCE || rt->type == TYPE_WORD ||
                  rt->type == TYPE_PERMUTATION));
 
+  if (s->index == NULL && s->index_size == 0)
+    _sequence_build_index (s);
+  if (s->index != NULL)
+    {
+      if (value < s->index_min || value - s->index_min >= s->index_size)
+        return NULL;
+      return s->index[value - s->index_min] ? rt : NULL;
+    }
+
   for (i = 0; i < s->length; ++i)
     if (s->value[i] == value)
       return rt;
@@ -84,12 +163,82 @@ static int _sequence_run_filters (const ramsey_t *rt)
   assert (rt && (rt->type == TYPE_SEQUENCE || rt->type == TYPE_WORD ||
                  rt->type == TYPE_PERMUTATION));
 
+  if (s->prechecked)
+    return 1;
   for (i = 0; i < s->n_filters; ++i)
     if (!s->filter[i]->run (s->filter[i], rt))
       return 0;
   return 1;
 }
 
+/* Whether get_allowed_cells() gives exactly the verdict that run_filters
+ * would give after an append, so that one may stand in for the other */
+static bool _sequence_mask_is_exact (const struct _sequence *s)
+{
+  int i;
+
+  for (i = 0; i < s->n_filters; ++i)
+    if (s->filter[i]->get_allowed_cells == NULL ||
+        s->filter[i]->mode != MODE_LAST_ONLY)
+      return 0;
+  return 1;
+}
+
+static int _sequence_full_filters (ramsey_t *rt)
+{
+  struct _sequence *s = (struct _sequence *) rt;
+  int i, rv = 1;
+  assert (rt && (rt->type == TYPE_SEQUENCE || rt->type == TYPE_WORD ||
+                 rt->type == TYPE_PERMUTATION));
+
+  s->prechecked = 0;
+  for (i = 0; i < s->n_filters; ++i)
+    rv &= s->filter[i]->set_mode (s->filter[i], MODE_FULL);
+  return rv;
+}
+
+static unsigned long _sequence_get_allowed_cells (const ramsey_t *rt, int value)
+{
+  const struct _sequence *s = (struct _sequence *) rt;
+  int i;
+  assert (rt && (rt->type == TYPE_SEQUENCE || rt->type == TYPE_WORD ||
+                 rt->type == TYPE_PERMUTATION));
+
+  for (i = 0; i < s->n_filters; ++i)
+    if (s->filter[i]->get_allowed_cells &&
+        !s->filter[i]->get_allowed_cells (s->filter[i], rt, value))
+      return 0;
+  return 1;
+}
+
+static unsigned long _sequence_get_allowed_values (const ramsey_t *rt,
+                                                   const int *values, int n_values)
+{
+  const struct _sequence *s = (struct _sequence *) rt;
+  unsigned long rv = CELL_MASK_ALL (n_values);
+  int i;
+  assert (rt && (rt->type == TYPE_SEQUENCE || rt->type == TYPE_WORD ||
+                 rt->type == TYPE_PERMUTATION));
+
+  for (i = 0; i < s->n_filters && rv; ++i)
+    rv &= filter_get_allowed_values (s->filter[i], rt, values, n_values);
+  return rv;
+}
+
+static int _sequence_explain (const ramsey_t *rt, int value, int cell,
+                              int *values, int max_values)
+{
+  const struct _sequence *s = (struct _sequence *) rt;
+  int i, rv = -1;
+  assert (rt && (rt->type == TYPE_SEQUENCE || rt->type == TYPE_WORD ||
+                 rt->type == TYPE_PERMUTATION));
+
+  for (i = 0; i < s->n_filters && rv < 0; ++i)
+    if (s->filter[i]->explain)
+      rv = s->filter[i]->explain (s->filter[i], rt, value, cell, values, max_values);
+  return rv;
+}
+
 static int _sequence_add_filter (ramsey_t *rt, filter_t *f)
 {
   struct _sequence *s = (struct _sequence *) rt;
@@ -121,9 +270,10 @@ static int _sequence_add_filter (ramsey_t *rt, filter_t *f)
 /* RECURSION */
 static void _sequence_recurse (ramsey_t *rt, global_data_t *state)
 {
-  int i;
+  int i, k;
   const int *gap_set;
   int gap_set_len;
+  bool ordered, exact;
   struct _sequence *s = (struct _sequence *) rt;
   assert (rt && (rt->type == TYPE_SEQUENCE || rt->type == TYPE_WORD ||
                  rt->type == TYPE_PERMUTATION));
@@ -139,13 +289,29 @@ static void _sequence_recurse (ramsey_t *rt, global_data_t *state)
 
   gap_set = s->gap_set->get_priv_data_const (s->gap_set);
   gap_set_len = s->gap_set->get_length (s->gap_set);
-  for (i = 0; i < gap_set_len; ++i)
+  ordered = s->order.how != ORDER_NATURAL &&
+            child_order_begin (&s->order, rt, state, s->length, gap_set_len);
+  exact = rt->r_prune_tree && _sequence_mask_is_exact (s);
+  for (k = 0; k < gap_set_len; ++k)
     {
+      i = ordered ? child_order_at (&s->order, s->length, k) : k;
       if (s->gap_set->type == TYPE_EQUALIZED_LIST)
         equalized_list_increment (s->gap_set, i);
-      rt->append (rt, rt->get_maximum (rt) + gap_set[i]);
-      rt->recurse (rt, state);
-      rt->deappend (rt);
+      /* Skip children that the filters would reject anyway */
+      if (!rt->r_prune_tree ||
+          rt->get_allowed_cells (rt, rt->get_maximum (rt) + gap_set[i]))
+        {
+          long stall_index = rt->r_stall_index;
+
+          rt->append (rt, rt->get_maximum (rt) + gap_set[i]);
+          /* Don't make the child's preamble filter it a second time */
+          s->prechecked = exact;
+          rt->recurse (rt, state);
+          rt->deappend (rt);
+
+          if (ordered && rt->r_stall_index != stall_index)
+            child_order_succeed (&s->order, s->length, i);
+        }
       if (s->gap_set->type == TYPE_EQUALIZED_LIST)
         equalized_list_decrement (s->gap_set, i);
     }
@@ -153,6 +319,55 @@ static void _sequence_recurse (ramsey_t *rt, global_data_t *state)
   recursion_postamble (rt);
 }
 
+static int _sequence_get_n_children (ramsey_t *rt)
+{
+  struct _sequence *s = (struct _sequence *) rt;
+  assert (rt && rt->type == TYPE_SEQUENCE);
+
+  if (s->gap_set == NULL)
+    {
+      fputs ("Error: cannot search sequences without a gap set.\n", stderr);
+      return 0;
+    }
+  return s->gap_set->get_length (s->gap_set);
+}
+
+static int _sequence_child_append (ramsey_t *rt, int index)
+{
+  struct _sequence *s = (struct _sequence *) rt;
+  const int *gap_set;
+  int value;
+  assert (rt && rt->type == TYPE_SEQUENCE);
+
+  if (s->gap_set->type == TYPE_EQUALIZED_LIST)
+    equalized_list_increment (s->gap_set, index);
+  gap_set = s->gap_set->get_priv_data_const (s->gap_set);
+  value = rt->get_maximum (rt) + gap_set[index];
+
+  /* Skip children that the filters would reject anyway */
+  if (!rt->r_prune_tree || rt->get_allowed_cells (rt, value))
+    {
+      rt->append (rt, value);
+      /* As in _sequence_recurse, spare the preamble a second check */
+      s->prechecked = rt->r_prune_tree && _sequence_mask_is_exact (s);
+      return 1;
+    }
+
+  if (s->gap_set->type == TYPE_EQUALIZED_LIST)
+    equalized_list_decrement (s->gap_set, index);
+  return 0;
+}
+
+static void _sequence_child_deappend (ramsey_t *rt, int index)
+{
+  struct _sequence *s = (struct _sequence *) rt;
+  assert (rt && rt->type == TYPE_SEQUENCE);
+
+  rt->deappend (rt);
+  if (s->gap_set->type == TYPE_EQUALIZED_LIST)
+    equalized_list_decrement (s->gap_set, index);
+}
+
 /* PRINT / PARSE */
 static void _sequence_print (const ramsey_t *rt, stream_t *out)
 {
@@ -215,9 +430,10 @@ static const char *_sequence_parse (ramsey_t *rt, const char *data)
   return data;
 }
 
-static void _sequence_randomize (ramsey_t *rt, int n)
+static void _sequence_randomize (ramsey_t *rt, int n, rng_t *rng)
 {
   (void) n;
+  (void) rng;
   fprintf (stderr, "Warning: randomize() unimplemented for ``%s''.\n",
            rt->get_type (rt));
 }
@@ -250,6 +466,9 @@ static void *_sequence_get_priv_data (ramsey_t *rt)
   struct _sequence *s = (struct _sequence *) rt;
   assert (rt && (rt->type == TYPE_SEQUENCE || rt->type == TYPE_WORD ||
                  rt->type == TYPE_PERMUTATION));
+  /* The caller may rearrange values behind our back */
+  _sequence_drop_index (s);
+  s->prechecked = 0;
   return s->value;
 }
 
@@ -276,6 +495,15 @@ static int _sequence_append (ramsey_t *rt, int value)
       s->value = tmp;
     }
   s->value[s->length++] = value;
+  s->prechecked = 0;
+
+  if (s->index != NULL)
+    {
+      if (value >= s->index_min && value - s->index_min < s->index_size)
+        ++s->index[value - s->index_min];
+      else
+        _sequence_drop_index (s);
+    }
   return 1;
 }
 
@@ -284,8 +512,15 @@ static int _sequence_deappend (ramsey_t *rt)
   struct _sequence *s = (struct _sequence *) rt;
   assert (rt && (rt->type == TYPE_SEQUENCE || rt->type == TYPE_WORD ||
                  rt->type == TYPE_PERMUTATION));
+  s->prechecked = 0;
   if (s->length)
-    --s->length;
+    {
+      --s->length;
+      if (s->index != NULL)
+        --s->index[s->value[s->length] - s->index_min];
+      else if (s->index_size == -1 && s->length < s->index_spread_length)
+        s->index_size = 0;
+    }
   return 1;
 }
 
@@ -313,6 +548,8 @@ static void _sequence_empty (ramsey_t *rt)
                  rt->type == TYPE_PERMUTATION));
 
   s->length = 0;
+  s->prechecked = 0;
+  _sequence_drop_index (s);
 }
 
 static void _sequence_reset (ramsey_t *rt)
@@ -327,6 +564,7 @@ static void _sequence_reset (ramsey_t *rt)
 
   s->length = 0;
   s->n_filters = 0;
+  _sequence_drop_index (s);
   recursion_init (rt);
 }
 
@@ -341,7 +579,11 @@ static ramsey_t *_sequence_clone (const ramsey_t *rt)
     return NULL;
 
   memcpy (s, rt, sizeof *s);
+  child_order_init (&s->order, old_s->order.how);
 
+  /* The clone builds its own index if it needs one */
+  s->index = NULL;
+  s->index_size = 0;
   s->filter = malloc (s->max_filters * sizeof *s->filter);
   s->value  = malloc (s->max_length * sizeof *s->value);
   if (s->filter == NULL || s->value == NULL)
@@ -360,6 +602,15 @@ static ramsey_t *_sequence_clone (const ramsey_t *rt)
           return NULL;
         }
     }
+  if (old_s->alphabet)
+    {
+      s->alphabet = old_s->alphabet->clone (old_s->alphabet);
+      if (s->alphabet == NULL)
+        {
+          free (s);
+          return NULL;
+        }
+    }
   memcpy (s->value, old_s->value, s->max_length * sizeof *s->value);
   for (i = 0; i < s->n_filters; ++i)
     s->filter[i] = old_s->filter[i]->clone (old_s->filter[i]);
@@ -379,6 +630,10 @@ static void _sequence_destroy (ramsey_t *rt)
 
   if (s->gap_set)
     s->gap_set->destroy (s->gap_set);
+  if (s->alphabet)
+    s->alphabet->destroy (s->alphabet);
+  child_order_clear (&s->order);
+  free (s->index);
   free (s->filter);
   free (s->value);
   free (s);
@@ -406,6 +661,9 @@ void *sequence_new_direct ()
   rv->destroy = _sequence_destroy;
   rv->randomize = _sequence_randomize;
   rv->recurse = _sequence_recurse;
+  rv->get_n_children = _sequence_get_n_children;
+  rv->child_append   = _sequence_child_append;
+  rv->child_deappend = _sequence_child_deappend;
   recursion_init (rv);
 
   rv->find_value  = _sequence_find_value;
@@ -421,8 +679,17 @@ void *sequence_new_direct ()
 
   rv->add_filter  = _sequence_add_filter;
   rv->run_filters = _sequence_run_filters;
+  rv->full_filters = _sequence_full_filters;
+  rv->get_allowed_cells = _sequence_get_allowed_cells;
+  rv->get_allowed_values = _sequence_get_allowed_values;
+  rv->explain = _sequence_explain;
 
   s->gap_set = NULL;
+  s->alphabet = NULL;
+  s->index = NULL;
+  s->index_size = 0;
+  child_order_init (&s->order, ORDER_NATURAL);
+  s->prechecked = 0;
 
   s->length    = 0;
   s->n_filters = 0;
@@ -456,17 +723,53 @@ void *sequence_new (const setting_list_t *vars)
           if (gs->type == TYPE_SEQUENCE || gs->type == TYPE_EQUALIZED_LIST)
             rv->gap_set = gs->clone (gs);
         }
+      if (!child_order_get (vars, &rv->order.how))
+        {
+          _sequence_destroy ((ramsey_t *) rv);
+          return NULL;
+        }
     }
   return rv;
 }
 
-/* PROTOTYPE */
-const ramsey_t *sequence_prototype ()
+/* ALPHABET */
+const ramsey_t *sequence_get_alphabet (const ramsey_t *rt)
 {
-  static ramsey_t *rv;
-  if (rv == NULL)
-    rv = sequence_new_direct ();
-  return rv;
+  const struct _sequence *s = (const struct _sequence *) rt;
+  assert (rt && (rt->type == TYPE_SEQUENCE || rt->type == TYPE_WORD ||
+                 rt->type == TYPE_PERMUTATION));
+  return s->alphabet;
+}
+
+int sequence_set_alphabet (ramsey_t *rt, const ramsey_t *alphabet)
+{
+  struct _sequence *s = (struct _sequence *) rt;
+  ramsey_t *new_alphabet = NULL;
+  assert (rt && (rt->type == TYPE_SEQUENCE || rt->type == TYPE_WORD ||
+                 rt->type == TYPE_PERMUTATION));
+
+  if (alphabet != NULL)
+    {
+      new_alphabet = alphabet->clone (alphabet);
+      if (new_alphabet == NULL)
+        return 0;
+    }
+  if (s->alphabet)
+    s->alphabet->destroy (s->alphabet);
+  s->alphabet = new_alphabet;
+  return 1;
+}
+
+int sequence_add_filter (ramsey_t *rt, filter_t *f)
+{
+  return _sequence_add_filter (rt, f);
+}
+
+int sequence_mask_is_exact (const ramsey_t *rt)
+{
+  assert (rt && (rt->type == TYPE_SEQUENCE || rt->type == TYPE_WORD ||
+                 rt->type == TYPE_PERMUTATION));
+  return _sequence_mask_is_exact ((const struct _sequence *) rt);
 }
 
 
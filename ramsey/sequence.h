@@ -42,14 +42,40 @@ void *sequence_new (const setting_list_t *vars);
  */
 void *sequence_new_direct (void);
 
-/*! \brief Return a singleton prototype of the sequence object.
+/*! \brief Return the alphabet associated with a sequence.
  *
- *  This is used to copy functionality from the sequence object
- *  into other ramsey_t objects, without worrying about their
- *  underlying implementation.
+ *  This is used by words, whose children are formed by appending
+ *  each letter of the alphabet in turn.
  *
- *  \return Sequence prototype.
+ *  \return The alphabet, or NULL if none is set.
  */
-const ramsey_t *sequence_prototype (void);
+const ramsey_t *sequence_get_alphabet (const ramsey_t *rt);
+
+/*! \brief Set the alphabet associated with a sequence.
+ *
+ *  \param [in] rt        The sequence.
+ *  \param [in] alphabet  The alphabet, which will be copied, or NULL
+ *                        to remove it.
+ *
+ *  \return 1 on success, 0 on failure.
+ */
+int sequence_set_alphabet (ramsey_t *rt, const ramsey_t *alphabet);
+
+/*! \brief Attach a filter to a sequence, or an object built on one.
+ *
+ *  This is used by permutations, which are stored as sequences but
+ *  filter differently.
+ *
+ *  \return 1 on success, 0 on failure.
+ */
+int sequence_add_filter (ramsey_t *rt, filter_t *f);
+
+/*! \brief Whether get_allowed_cells() on a sequence decides exactly
+ *         what its filters would decide after an append.
+ *
+ *  This is used by colorings, which may then skip filtering their
+ *  cells again once a child has been checked against the mask.
+ */
+int sequence_mask_is_exact (const ramsey_t *rt);
 
 #endif
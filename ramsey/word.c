@@ -40,35 +40,64 @@ static const char *_word_get_type (const ramsey_t *rt)
 static void _word_real_recurse (ramsey_t *rt, const int *alphabet,
                                 int alphabet_len, global_data_t *state)
 {
+  unsigned long allowed = ~0UL;
   int i;
   if (!recursion_preamble (rt, state))
     return;
 
+  /* Evaluate every letter at once, and skip those the filters reject */
+  if (rt->r_prune_tree && alphabet_len <= CELL_MASK_BITS)
+    allowed = rt->get_allowed_values (rt, alphabet, alphabet_len);
+
   for (i = 0; i < alphabet_len; ++i)
-    {
-      rt->append (rt, alphabet[i]);
-      rt->recurse (rt, state);
-      rt->deappend (rt);
-    }
+    if (i >= CELL_MASK_BITS || (allowed & (1UL << i)))
+      {
+        rt->append (rt, alphabet[i]);
+        rt->recurse (rt, state);
+        rt->deappend (rt);
+      }
   recursion_postamble (rt);
 }
 
 static void _word_recurse (ramsey_t *rt, global_data_t *state)
 {
-  const setting_t *alphabet_set = SETTING ("alphabet");
+  const ramsey_t *alphabet = sequence_get_alphabet (rt);
 
   assert (rt && rt->type == TYPE_WORD);
-  if (alphabet_set == NULL)
+  if (alphabet == NULL)
     fprintf (stderr, "Cannot recurse on words without setting the ``alphabet'' variable!\n");
   else
+    _word_real_recurse (rt, alphabet->get_priv_data_const (alphabet),
+                        alphabet->get_length (alphabet), state);
+}
+
+static int _word_get_n_children (ramsey_t *rt)
+{
+  const ramsey_t *alphabet = sequence_get_alphabet (rt);
+
+  assert (rt && rt->type == TYPE_WORD);
+  if (alphabet == NULL)
     {
-      const ramsey_t *alphabet = alphabet_set->get_ramsey_value (alphabet_set);
-      if (alphabet == NULL || alphabet->type != TYPE_SEQUENCE)
-        fprintf (stderr, "The ``alphabet'' variable must be a sequence!\n");
-      else
-        _word_real_recurse (rt, alphabet->get_priv_data_const (alphabet),
-                            alphabet->get_length (alphabet), state);
+      fprintf (stderr, "Cannot recurse on words without setting the ``alphabet'' variable!\n");
+      return 0;
     }
+  return alphabet->get_length (alphabet);
+}
+
+static int _word_child_append (ramsey_t *rt, int index)
+{
+  const ramsey_t *alphabet = sequence_get_alphabet (rt);
+  const int *letter = alphabet->get_priv_data_const (alphabet);
+
+  assert (rt && rt->type == TYPE_WORD);
+  return rt->append (rt, letter[index]);
+}
+
+static void _word_child_deappend (ramsey_t *rt, int index)
+{
+  (void) index;
+  assert (rt && rt->type == TYPE_WORD);
+  rt->deappend (rt);
 }
 
 /* CONSTRUCTOR */
@@ -78,10 +107,23 @@ void *word_new (const setting_list_t *vars)
 
   if (rv != NULL)
     {
+      const setting_t *alphabet_set = vars->get_setting (vars, "alphabet");
+
       rv->type = TYPE_WORD;
       rv->get_type = _word_get_type;
       rv->recurse  = _word_recurse;
+      rv->get_n_children = _word_get_n_children;
+      rv->child_append   = _word_child_append;
+      rv->child_deappend = _word_child_deappend;
+
+      if (alphabet_set != NULL)
+        {
+          const ramsey_t *alphabet = alphabet_set->get_ramsey_value (alphabet_set);
+          if (alphabet == NULL || alphabet->type != TYPE_SEQUENCE)
+            fprintf (stderr, "The ``alphabet'' variable must be a sequence!\n");
+          else
+            sequence_set_alphabet (rv, alphabet);
+        }
     }
   return rv;
 }
-
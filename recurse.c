@@ -14,21 +14,57 @@
 
 
 #include <stdio.h>
+#include <string.h>
 
 #include "global.h"
+#include "buffer-stream.h"
+#include "child-order.h"
 #include "ramsey/ramsey.h"
 #include "recurse.h"
 
+/* Works out which shard an object at the split depth belongs to */
+static int _shard_of (ramsey_t *rt)
+{
+  unsigned long hash = 2166136261UL;
+  const char *text;
+  stream_t *out;
+
+  if (rt->r_shard_by_index)
+    return rt->r_shard_counter++ % rt->r_n_shards;
+
+  /* FNV-1a over the printed object. (The multiplier of djb2 is
+   * divisible by 3 and 11, which would give some shards nothing.) */
+  out = buffer_stream_new ();
+  if (out == NULL)
+    return rt->r_shard;
+  rt->print (rt, out);
+  for (text = buffer_stream_get_text (out); *text; ++text)
+    hash = ((hash ^ (unsigned char) *text) * 16777619UL) & 0xffffffffUL;
+  out->destroy (out);
+  return hash % rt->r_n_shards;
+}
+
 /* Preamble that doesn't return 0 if filters fail (though it requires
  * the filters to pass to increment recursion counts) */
 int recursion_preamble (ramsey_t *rt, global_data_t *state)
 {
   bool filter_success = rt->run_filters (rt);
+  bool counted = 1;
 
   if (state->kill_now)
     return 0;
   if (rt->r_prune_tree && !filter_success)
     return 0;
+  if (rt->r_n_shards != 1)
+    {
+      if (rt->r_n_shards == 0)
+        return 0;
+      if (rt->r_depth == rt->r_shard_depth && _shard_of (rt) != rt->r_shard)
+        return 0;
+      /* Every shard passes through the objects above the split */
+      if (rt->r_depth < rt->r_shard_depth && rt->r_shard != 0)
+        counted = 0;
+    }
   if (rt->r_max_iterations && rt->r_iterations >= rt->r_max_iterations)
     return 0;
   if (rt->r_max_depth && rt->r_depth >= rt->r_max_depth)
@@ -42,9 +78,11 @@ int recursion_preamble (ramsey_t *rt, global_data_t *state)
 
   ++rt->r_depth;
 
-  if (filter_success)
+  if (filter_success && counted)
     {
       dc_list *dlist;
+      if (state->record_lock)
+        pthread_mutex_lock (state->record_lock);
       for (dlist = state->dumps; dlist; dlist = dlist->next)
         if (dlist->data->record (dlist->data, rt, state->out_stream))
           rt->r_stall_index = rt->r_iterations;
@@ -53,6 +91,9 @@ int recursion_preamble (ramsey_t *rt, global_data_t *state)
           rt->r_stall_index = rt->r_iterations;
 
       ++rt->r_iterations;
+      state->progress = rt->r_iterations;
+      if (state->record_lock)
+        pthread_mutex_unlock (state->record_lock);
     }
   return 1;
 }
@@ -72,10 +113,31 @@ void recursion_init (ramsey_t *rt)
   rt->r_stall_index =
   rt->r_max_depth =
   rt->r_max_run_time =
-  rt->r_prune_tree = 0;
+  rt->r_prune_tree =
+  rt->r_shard =
+  rt->r_shard_depth =
+  rt->r_shard_by_index =
+  rt->r_shard_counter = 0;
+  rt->r_n_shards = 1;
 
 }
 
+/* Whether every shard reaches the objects at the split depth in the same
+ * order. Not so if the order depends on which subtrees were searched, as
+ * each shard skips different ones. */
+static bool _shard_order_is_fixed (global_data_t *state)
+{
+  const setting_t *order_set = SETTING ("child_order");
+  const setting_t *restart_set = SETTING ("restart_strategy");
+
+  if (restart_set && strcmp (restart_set->get_text (restart_set), "none"))
+    return 0;
+  return order_set == NULL ||
+         (strcmp (order_set->get_text (order_set), child_order_name (ORDER_RANDOM)) &&
+          strcmp (order_set->get_text (order_set),
+                  child_order_name (ORDER_MOST_RECENT_SUCCESS)));
+}
+
 void recursion_reset (ramsey_t *rt, global_data_t *state)
 {
   const setting_t *max_iters_set = SETTING ("max_iterations");
@@ -83,6 +145,9 @@ void recursion_reset (ramsey_t *rt, global_data_t *state)
   const setting_t *stall_after_set = SETTING ("stall_after");
   const setting_t *prune_tree_set  = SETTING ("prune_tree");
   const setting_t *max_run_time_set = SETTING ("max_run_time");
+  const setting_t *shard_set = SETTING ("shard");
+  const setting_t *shard_by_set = SETTING ("shard_by");
+  const setting_t *split_depth_set = SETTING ("split_depth");
 
   recursion_init (rt);
 
@@ -97,6 +162,33 @@ void recursion_reset (ramsey_t *rt, global_data_t *state)
   if (max_run_time_set)
     rt->r_max_run_time = max_run_time_set->get_int_value (max_run_time_set);
 
+  if (shard_set)
+    {
+      char extra;
+      if (sscanf (shard_set->get_text (shard_set), "%d/%d %c",
+                  &rt->r_shard, &rt->r_n_shards, &extra) != 2 ||
+          rt->r_shard < 0 || rt->r_shard >= rt->r_n_shards)
+        {
+          fprintf (stderr, "Error: ``shard'' must be i/N, with 0 <= i < N.\n");
+          rt->r_n_shards = 0;
+        }
+      rt->r_shard_depth = split_depth_set ? split_depth_set->get_int_value (split_depth_set)
+                                          : DEFAULT_SPLIT_DEPTH;
+      if (shard_by_set && !strcmp (shard_by_set->get_text (shard_by_set), "index"))
+        {
+          rt->r_shard_by_index = _shard_order_is_fixed (state);
+          if (!rt->r_shard_by_index)
+            fprintf (stderr, "Error: ``shard-by index'' cannot be used with a random "
+                             "or most-recent-success child-order, or a restart-strategy; "
+                             "sharding by hash.\n");
+        }
+      else if (shard_by_set && strcmp (shard_by_set->get_text (shard_by_set), "hash"))
+        {
+          fprintf (stderr, "Error: ``shard-by'' must be hash or index.\n");
+          rt->r_n_shards = 0;
+        }
+    }
+
   rt->r_start_time = time (NULL);
 }
 
@@ -21,11 +21,21 @@
 
 #include "global.h"
 
+/*! \brief Default depth at which searches are split up, between shards
+ *         or (see distribute.h) between processes. */
+#define DEFAULT_SPLIT_DEPTH	4
+
 /*! \brief Recursion checks to run before ramsey_t->recurse().
  *
  *  \param [in] rt    The Ramsey object that is being recursed on.
  *  \param [in] state The global state of the program.
  *
+ *  If the search is sharded (see recursion_reset()), objects at the
+ *  split depth which belong to other shards are stopped at, and
+ *  objects above it are only counted and recorded by shard 0, so
+ *  that the iterations of all shards add up to those of the whole
+ *  search.
+ *
  *  \return 1 if recursion should be done, 0 if it should be stopped.
  */
 int recursion_preamble (ramsey_t *rt, global_data_t *state);
@@ -43,6 +53,9 @@ void recursion_postamble (ramsey_t *rt);
 void recursion_init (ramsey_t *rt);
 
 /*! \brief Set recursion-related variables of a ramsey_t from script variables.
+ *
+ *  If the shard variable is malformed, an error is printed and the
+ *  search will do nothing.
  *
  *  \param [in] rt    The Ramsey object that is being recursed on.
  *  \param [in] state The global state of the program.
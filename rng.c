@@ -0,0 +1,44 @@
+/* RamseyScript
+ * Written in 2012 by
+ *   Andrew Poelstra <apoelstra@wpsoftware.net>
+ *
+ * To the extent possible under law, the author(s) have dedicated all
+ * copyright and related and neighboring rights to this software to
+ * the public domain worldwide. This software is distributed without
+ * any warranty.
+ *
+ * You should have received a copy of the CC0 Public Domain Dedication
+ * along with this software.
+ * If not, see <http://creativecommons.org/publicdomain/zero/1.0/>.
+ */
+
+#include "rng.h"
+
+/*! \file rng.c
+ *  \brief Implementation of the xorshift64* generator.
+ */
+
+void rng_seed (rng_t *rng, unsigned long seed)
+{
+  /* Spread the seed over all 64 bits (splitmix64 finalizer) so that
+   * nearby seeds give unrelated streams; the state must not be 0. */
+  unsigned long long z = (unsigned long long) seed + 0x9E3779B97F4A7C15ULL;
+  z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+  z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+  z ^= z >> 31;
+  rng->state = z ? z : 1;
+}
+
+unsigned long long rng_next (rng_t *rng)
+{
+  rng->state ^= rng->state >> 12;
+  rng->state ^= rng->state << 25;
+  rng->state ^= rng->state >> 27;
+  return rng->state * 0x2545F4914F6CDD1DULL;
+}
+
+int rng_range (rng_t *rng, int n)
+{
+  /* Use the high bits, which are the best-mixed ones */
+  return (int) ((rng_next (rng) >> 33) % (unsigned long long) n);
+}
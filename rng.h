@@ -0,0 +1,48 @@
+/* RamseyScript
+ * Written in 2012 by
+ *   Andrew Poelstra <apoelstra@wpsoftware.net>
+ *
+ * To the extent possible under law, the author(s) have dedicated all
+ * copyright and related and neighboring rights to this software to
+ * the public domain worldwide. This software is distributed without
+ * any warranty.
+ *
+ * You should have received a copy of the CC0 Public Domain Dedication
+ * along with this software.
+ * If not, see <http://creativecommons.org/publicdomain/zero/1.0/>.
+ */
+
+/*! \file rng.h
+ *  \brief Defines a small seedable pseudo-random number generator.
+ *
+ *  Unlike rand(), each generator carries its own state, so a script
+ *  can reproduce a randomized run by fixing its seed.
+ */
+
+#ifndef RNG_H
+#define RNG_H
+
+/*! \brief State of a pseudo-random number generator (xorshift64*). */
+typedef struct _rng_t {
+  /*! \brief Internal state; never zero. */
+  unsigned long long state;
+} rng_t;
+
+/*! \brief Seeds a generator.
+ *
+ *  \param [in] rng   The generator to seed.
+ *  \param [in] seed  The seed. Any value, including 0, is acceptable.
+ */
+void rng_seed (rng_t *rng, unsigned long seed);
+
+/*! \brief Returns the next 64 pseudo-random bits from a generator. */
+unsigned long long rng_next (rng_t *rng);
+
+/*! \brief Returns a pseudo-random integer uniformly in [0, n).
+ *
+ *  \param [in] rng   The generator to use.
+ *  \param [in] n     The (positive) size of the range.
+ */
+int rng_range (rng_t *rng, int n);
+
+#endif
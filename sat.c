@@ -0,0 +1,719 @@
+/* RamseyScript
+ * Written in 2012 by
+ *   Andrew Poelstra <apoelstra@wpsoftware.net>
+ *
+ * To the extent possible under law, the author(s) have dedicated all
+ * copyright and related and neighboring rights to this software to
+ * the public domain worldwide. This software is distributed without
+ * any warranty.
+ *
+ * You should have received a copy of the CC0 Public Domain Dedication
+ * along with this software.
+ * If not, see <http://creativecommons.org/publicdomain/zero/1.0/>.
+ */
+
+/*! \file sat.c
+ *  \brief A small conflict-driven clause-learning SAT solver.
+ *
+ *  Internally variables count from 0 and literal 2v (2v + 1) means
+ *  variable v is true (false). The two watched literals of a clause
+ *  are always lit[0] and lit[1]; for a clause which is the reason for
+ *  an assignment, lit[0] is the literal it implied.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "global.h"
+#include "sat.h"
+
+#define LIT_NEG(l) ((l) ^ 1)
+#define LIT_VAR(l) ((l) >> 1)
+
+#define VAR_DECAY 0.95
+#define CLAUSE_DECAY 0.999
+#define RESTART_UNIT 100
+#define LEARNT_INC 1.1
+#define LEARNT_ADJUST_INC 1.5
+
+/*! \brief A clause, original or learned. */
+struct _clause {
+  /*! \brief Number of literals. */
+  int size;
+  /*! \brief Nonzero if the clause was learned (and may be deleted). */
+  bool learnt;
+  /*! \brief Nonzero if the clause is to be deleted. */
+  bool deleted;
+  /*! \brief How recently the clause took part in conflicts. */
+  double activity;
+  /*! \brief The literals. */
+  int lit[];
+};
+
+/*! \brief A growable list of clauses. */
+struct _clause_list {
+  /*! \brief The clauses. */
+  struct _clause **clause;
+  /*! \brief Number of clauses. */
+  int n;
+  /*! \brief Number of clauses allocated. */
+  int max;
+};
+
+struct _sat_solver_t {
+  /*! \brief Number of variables. */
+  int n_vars;
+  /*! \brief Set if a contradiction has been found among the clauses. */
+  bool unsat;
+  /*! \brief Set if an allocation failed during propagation. */
+  bool out_of_memory;
+
+  /*! \brief Value of each variable: 1, 0, or -1 for unassigned. */
+  signed char *value;
+  /*! \brief Last value of each variable, reused on the next decision. */
+  signed char *phase;
+  /*! \brief Decision level at which each variable was assigned. */
+  int *level;
+  /*! \brief Clause which implied each variable, or NULL. */
+  struct _clause **reason;
+
+  /*! \brief Assigned literals, in order of assignment. */
+  int *trail;
+  /*! \brief Number of assigned literals. */
+  int n_trail;
+  /*! \brief Index into the trail of the first unpropagated literal. */
+  int q_head;
+  /*! \brief Index into the trail where each decision level starts. */
+  int *trail_lim;
+  /*! \brief Current decision level. */
+  int n_levels;
+
+  /*! \brief For each literal, the clauses watching it. */
+  struct _clause_list *watches;
+  /*! \brief The original clauses. */
+  struct _clause_list clauses;
+  /*! \brief The learned clauses. */
+  struct _clause_list learnts;
+  /*! \brief Number of learned clauses to keep before deleting some. */
+  double max_learnts;
+  /*! \brief Conflict count at which to next raise max_learnts. */
+  double next_adjust;
+
+  /*! \brief VSIDS activity of each variable. */
+  double *activity;
+  /*! \brief Amount to bump variable activities by. */
+  double var_inc;
+  /*! \brief Amount to bump clause activities by. */
+  double clause_inc;
+  /*! \brief Unassigned variables, as a heap ordered by activity. */
+  int *heap;
+  /*! \brief Number of variables in the heap. */
+  int n_heap;
+  /*! \brief Position of each variable in the heap, or -1. */
+  int *heap_index;
+
+  /*! \brief Scratch flags for conflict analysis. */
+  bool *seen;
+  /*! \brief Scratch space for a learned clause. */
+  int *learnt;
+
+  /*! \brief Statistics. */
+  long decisions, propagations, conflicts, restarts, n_deleted;
+};
+
+/* Value of a literal: 1, 0 or -1 for unassigned */
+static int _sat_lit_value (const sat_solver_t *s, int lit)
+{
+  int v = s->value[LIT_VAR (lit)];
+  return v < 0 ? -1 : v ^ (lit & 1);
+}
+
+static int _clause_list_add (struct _clause_list *list, struct _clause *c)
+{
+  if (list->n == list->max)
+    {
+      int new_max = list->max ? 2 * list->max : 4;
+      struct _clause **tmp = realloc (list->clause,
+                                      new_max * sizeof *list->clause);
+      if (tmp == NULL)
+        return 0;
+      list->clause = tmp;
+      list->max = new_max;
+    }
+  list->clause[list->n++] = c;
+  return 1;
+}
+
+/* Heap of unassigned variables, highest activity at the top */
+static void _heap_swap (sat_solver_t *s, int i, int j)
+{
+  int tmp = s->heap[i];
+  s->heap[i] = s->heap[j];
+  s->heap[j] = tmp;
+  s->heap_index[s->heap[i]] = i;
+  s->heap_index[s->heap[j]] = j;
+}
+
+static void _heap_up (sat_solver_t *s, int i)
+{
+  while (i > 0 && s->activity[s->heap[(i - 1) / 2]] < s->activity[s->heap[i]])
+    {
+      _heap_swap (s, i, (i - 1) / 2);
+      i = (i - 1) / 2;
+    }
+}
+
+static void _heap_down (sat_solver_t *s, int i)
+{
+  for (;;)
+    {
+      int child = 2 * i + 1;
+      if (child >= s->n_heap)
+        break;
+      if (child + 1 < s->n_heap &&
+          s->activity[s->heap[child + 1]] > s->activity[s->heap[child]])
+        ++child;
+      if (s->activity[s->heap[child]] <= s->activity[s->heap[i]])
+        break;
+      _heap_swap (s, i, child);
+      i = child;
+    }
+}
+
+static void _heap_insert (sat_solver_t *s, int var)
+{
+  if (s->heap_index[var] >= 0)
+    return;
+  s->heap[s->n_heap] = var;
+  s->heap_index[var] = s->n_heap;
+  _heap_up (s, s->n_heap++);
+}
+
+static int _heap_pop (sat_solver_t *s)
+{
+  int var = s->heap[0];
+  _heap_swap (s, 0, --s->n_heap);
+  s->heap_index[var] = -1;
+  _heap_down (s, 0);
+  return var;
+}
+
+/* VSIDS bookkeeping */
+static void _sat_bump_var (sat_solver_t *s, int var)
+{
+  if ((s->activity[var] += s->var_inc) > 1e100)
+    {
+      int i;
+      for (i = 0; i < s->n_vars; ++i)
+        s->activity[i] *= 1e-100;
+      s->var_inc *= 1e-100;
+    }
+  if (s->heap_index[var] >= 0)
+    _heap_up (s, s->heap_index[var]);
+}
+
+static void _sat_bump_clause (sat_solver_t *s, struct _clause *c)
+{
+  if ((c->activity += s->clause_inc) > 1e20)
+    {
+      int i;
+      for (i = 0; i < s->learnts.n; ++i)
+        s->learnts.clause[i]->activity *= 1e-20;
+      s->clause_inc *= 1e-20;
+    }
+}
+
+/* Assignment and propagation */
+static void _sat_enqueue (sat_solver_t *s, int lit, struct _clause *reason)
+{
+  int var = LIT_VAR (lit);
+  s->value[var] = !(lit & 1);
+  s->level[var] = s->n_levels;
+  s->reason[var] = reason;
+  s->trail[s->n_trail++] = lit;
+}
+
+static void _sat_backtrack (sat_solver_t *s, int level)
+{
+  int i;
+
+  if (s->n_levels <= level)
+    return;
+  for (i = s->n_trail - 1; i >= s->trail_lim[level]; --i)
+    {
+      int var = LIT_VAR (s->trail[i]);
+      s->phase[var] = s->value[var];
+      s->value[var] = -1;
+      s->reason[var] = NULL;
+      _heap_insert (s, var);
+    }
+  s->n_trail = s->q_head = s->trail_lim[level];
+  s->n_levels = level;
+}
+
+/* Propagate all enqueued assignments; returns a conflicting clause or NULL */
+static struct _clause *_sat_propagate (sat_solver_t *s)
+{
+  while (s->q_head < s->n_trail)
+    {
+      int false_lit = LIT_NEG (s->trail[s->q_head++]);
+      struct _clause_list *ws = &s->watches[false_lit];
+      int i, j;
+
+      ++s->propagations;
+      for (i = j = 0; i < ws->n; )
+        {
+          struct _clause *c = ws->clause[i++];
+          int k;
+
+          /* Make sure the false literal is lit[1] */
+          if (c->lit[0] == false_lit)
+            {
+              c->lit[0] = c->lit[1];
+              c->lit[1] = false_lit;
+            }
+          /* Clause is already satisfied */
+          if (_sat_lit_value (s, c->lit[0]) == 1)
+            {
+              ws->clause[j++] = c;
+              continue;
+            }
+          /* Look for a new literal to watch */
+          for (k = 2; k < c->size; ++k)
+            if (_sat_lit_value (s, c->lit[k]) != 0)
+              {
+                if (!_clause_list_add (&s->watches[c->lit[k]], c))
+                  s->out_of_memory = 1;
+                else
+                  {
+                    c->lit[1] = c->lit[k];
+                    c->lit[k] = false_lit;
+                  }
+                break;
+              }
+          if (k < c->size && !s->out_of_memory)
+            continue;
+
+          /* No new watch: clause is unit or conflicting */
+          ws->clause[j++] = c;
+          if (_sat_lit_value (s, c->lit[0]) == 0)
+            {
+              while (i < ws->n)
+                ws->clause[j++] = ws->clause[i++];
+              ws->n = j;
+              s->q_head = s->n_trail;
+              return c;
+            }
+          _sat_enqueue (s, c->lit[0], c);
+        }
+      ws->n = j;
+    }
+  return NULL;
+}
+
+/* First-UIP conflict analysis. Fills s->learnt with the asserting
+ * literal first and a literal of the backjump level second, and
+ * returns its size; *bt_level is set to the level to backjump to. */
+static int _sat_analyze (sat_solver_t *s, struct _clause *confl, int *bt_level)
+{
+  int path = 0;
+  int p = -1;
+  int idx = s->n_trail - 1;
+  int n_learnt = 1;
+  int i, j, k;
+
+  do
+    {
+      if (confl->learnt)
+        _sat_bump_clause (s, confl);
+      for (k = (p == -1) ? 0 : 1; k < confl->size; ++k)
+        {
+          int q = confl->lit[k];
+          int var = LIT_VAR (q);
+          if (!s->seen[var] && s->level[var] > 0)
+            {
+              s->seen[var] = 1;
+              _sat_bump_var (s, var);
+              if (s->level[var] == s->n_levels)
+                ++path;
+              else
+                s->learnt[n_learnt++] = q;
+            }
+        }
+      /* Next literal on the trail involved in the conflict */
+      while (!s->seen[LIT_VAR (s->trail[idx])])
+        --idx;
+      p = s->trail[idx--];
+      confl = s->reason[LIT_VAR (p)];
+      s->seen[LIT_VAR (p)] = 0;
+      --path;
+    }
+  while (path > 0);
+  s->learnt[0] = LIT_NEG (p);
+
+  /* Drop literals implied by other literals of the clause */
+  for (i = j = 1; i < n_learnt; ++i)
+    {
+      struct _clause *r = s->reason[LIT_VAR (s->learnt[i])];
+      bool redundant = (r != NULL);
+      for (k = 1; redundant && k < r->size; ++k)
+        {
+          int var = LIT_VAR (r->lit[k]);
+          if (!s->seen[var] && s->level[var] > 0)
+            redundant = 0;
+        }
+      /* Swap rather than overwrite, to clear all the flags below */
+      if (!redundant)
+        {
+          int tmp = s->learnt[j];
+          s->learnt[j++] = s->learnt[i];
+          s->learnt[i] = tmp;
+        }
+    }
+  for (i = 1; i < n_learnt; ++i)
+    s->seen[LIT_VAR (s->learnt[i])] = 0;
+  n_learnt = j;
+
+  /* Find the backjump level */
+  *bt_level = 0;
+  for (i = 1; i < n_learnt; ++i)
+    if (s->level[LIT_VAR (s->learnt[i])] > *bt_level)
+      {
+        int tmp = s->learnt[1];
+        s->learnt[1] = s->learnt[i];
+        s->learnt[i] = tmp;
+        *bt_level = s->level[LIT_VAR (s->learnt[1])];
+      }
+  return n_learnt;
+}
+
+static struct _clause *_sat_new_clause (const int *lits, int n, bool learnt)
+{
+  struct _clause *c = malloc (sizeof *c + n * sizeof *c->lit);
+  if (c == NULL)
+    return NULL;
+  c->size = n;
+  c->learnt = learnt;
+  c->deleted = 0;
+  c->activity = 0;
+  memcpy (c->lit, lits, n * sizeof *lits);
+  return c;
+}
+
+static int _sat_attach (sat_solver_t *s, struct _clause *c)
+{
+  return _clause_list_add (&s->watches[c->lit[0]], c) &&
+         _clause_list_add (&s->watches[c->lit[1]], c);
+}
+
+/* Sort learned clauses by increasing activity */
+static int _clause_cmp (const void *a, const void *b)
+{
+  const struct _clause *ca = *(struct _clause *const *) a;
+  const struct _clause *cb = *(struct _clause *const *) b;
+  return (ca->activity > cb->activity) - (ca->activity < cb->activity);
+}
+
+/* Delete the less active half of the learned clauses */
+static void _sat_reduce (sat_solver_t *s)
+{
+  int i, j;
+  int lit;
+
+  qsort (s->learnts.clause, s->learnts.n, sizeof *s->learnts.clause,
+         _clause_cmp);
+  for (i = 0; i < s->learnts.n / 2; ++i)
+    {
+      struct _clause *c = s->learnts.clause[i];
+      bool locked = s->reason[LIT_VAR (c->lit[0])] == c &&
+                    _sat_lit_value (s, c->lit[0]) == 1;
+      if (c->size > 2 && !locked)
+        c->deleted = 1;
+    }
+
+  for (lit = 0; lit < 2 * s->n_vars; ++lit)
+    {
+      struct _clause_list *ws = &s->watches[lit];
+      for (i = j = 0; i < ws->n; ++i)
+        if (!ws->clause[i]->deleted)
+          ws->clause[j++] = ws->clause[i];
+      ws->n = j;
+    }
+  for (i = j = 0; i < s->learnts.n; ++i)
+    if (s->learnts.clause[i]->deleted)
+      {
+        free (s->learnts.clause[i]);
+        ++s->n_deleted;
+      }
+    else
+      s->learnts.clause[j++] = s->learnts.clause[i];
+  s->learnts.n = j;
+}
+
+/* Luby sequence 1, 1, 2, 1, 1, 2, 4, 1, ... */
+static long _sat_luby (int x)
+{
+  int size, seq;
+
+  for (size = 1, seq = 0; size < x + 1; ++seq)
+    size = 2 * size + 1;
+  while (size - 1 != x)
+    {
+      size = (size - 1) >> 1;
+      --seq;
+      x %= size;
+    }
+  return 1L << seq;
+}
+
+/* PUBLIC INTERFACE */
+sat_solver_t *sat_new (int n_vars)
+{
+  sat_solver_t *s = calloc (1, sizeof *s);
+  int i;
+
+  if (s == NULL)
+    return NULL;
+  s->n_vars = n_vars;
+  s->value = malloc (n_vars * sizeof *s->value);
+  s->phase = malloc (n_vars * sizeof *s->phase);
+  s->level = malloc (n_vars * sizeof *s->level);
+  s->reason = malloc (n_vars * sizeof *s->reason);
+  s->trail = malloc (n_vars * sizeof *s->trail);
+  s->trail_lim = malloc (n_vars * sizeof *s->trail_lim);
+  s->watches = calloc (2 * n_vars, sizeof *s->watches);
+  s->activity = malloc (n_vars * sizeof *s->activity);
+  s->heap = malloc (n_vars * sizeof *s->heap);
+  s->heap_index = malloc (n_vars * sizeof *s->heap_index);
+  s->seen = calloc (n_vars, sizeof *s->seen);
+  s->learnt = malloc (n_vars * sizeof *s->learnt);
+  if ((n_vars > 0 && (s->value == NULL || s->phase == NULL ||
+       s->level == NULL || s->reason == NULL || s->trail == NULL ||
+       s->trail_lim == NULL || s->watches == NULL || s->activity == NULL ||
+       s->heap == NULL || s->heap_index == NULL || s->seen == NULL ||
+       s->learnt == NULL)))
+    {
+      sat_destroy (s);
+      return NULL;
+    }
+
+  s->var_inc = 1;
+  s->clause_inc = 1;
+  for (i = 0; i < n_vars; ++i)
+    {
+      s->value[i] = -1;
+      s->phase[i] = 0;
+      s->reason[i] = NULL;
+      s->activity[i] = 0;
+      s->heap_index[i] = -1;
+      _heap_insert (s, i);
+    }
+  return s;
+}
+
+int sat_add_clause (sat_solver_t *s, const int *lits, int n_lits)
+{
+  struct _clause *c;
+  int *buf;
+  int i, j, n = 0;
+
+  if (s->unsat)
+    return 1;
+  buf = malloc ((n_lits + 1) * sizeof *buf);
+  if (buf == NULL)
+    return 0;
+
+  for (i = 0; i < n_lits; ++i)
+    {
+      int lit = lits[i] > 0 ? 2 * (lits[i] - 1) : 2 * (-lits[i] - 1) + 1;
+      int val = _sat_lit_value (s, lit);
+      bool skip = (val == 0);
+
+      /* Already satisfied (by a unit clause) or tautological */
+      if (val == 1)
+        {
+          free (buf);
+          return 1;
+        }
+      for (j = 0; !skip && j < n; ++j)
+        {
+          if (buf[j] == LIT_NEG (lit))
+            {
+              free (buf);
+              return 1;
+            }
+          skip = (buf[j] == lit);
+        }
+      if (!skip)
+        buf[n++] = lit;
+    }
+
+  if (n == 0)
+    s->unsat = 1;
+  else if (n == 1)
+    {
+      _sat_enqueue (s, buf[0], NULL);
+      s->unsat = (_sat_propagate (s) != NULL);
+    }
+  else
+    {
+      if ((c = _sat_new_clause (buf, n, 0)) == NULL ||
+          !_clause_list_add (&s->clauses, c))
+        {
+          free (c);
+          free (buf);
+          return 0;
+        }
+      if (!_sat_attach (s, c))
+        {
+          free (buf);
+          return 0;
+        }
+    }
+  free (buf);
+  return 1;
+}
+
+int sat_solve (sat_solver_t *s, time_t deadline, const volatile bool *kill_now)
+{
+  s->max_learnts = s->clauses.n / 3.0 + 100;
+  s->next_adjust = 100;
+  if (s->unsat || _sat_propagate (s) != NULL)
+    {
+      s->unsat = 1;
+      return 0;
+    }
+
+  for (;;)
+    {
+      long budget = _sat_luby (s->restarts) * RESTART_UNIT;
+      long conflicts = 0;
+
+      for (;;)
+        {
+          struct _clause *confl = _sat_propagate (s);
+
+          if (s->out_of_memory)
+            {
+              fprintf (stderr, "Error: out of memory in SAT solver.\n");
+              return -1;
+            }
+          if (confl != NULL)
+            {
+              int bt_level, n;
+
+              ++s->conflicts;
+              ++conflicts;
+              if (s->n_levels == 0)
+                {
+                  s->unsat = 1;
+                  return 0;
+                }
+
+              n = _sat_analyze (s, confl, &bt_level);
+              _sat_backtrack (s, bt_level);
+              if (n == 1)
+                _sat_enqueue (s, s->learnt[0], NULL);
+              else
+                {
+                  struct _clause *c = _sat_new_clause (s->learnt, n, 1);
+                  if (c == NULL || !_clause_list_add (&s->learnts, c) ||
+                      !_sat_attach (s, c))
+                    {
+                      fprintf (stderr, "Error: out of memory in SAT solver.\n");
+                      return -1;
+                    }
+                  _sat_bump_clause (s, c);
+                  _sat_enqueue (s, c->lit[0], c);
+                }
+              s->var_inc /= VAR_DECAY;
+              s->clause_inc /= CLAUSE_DECAY;
+
+              /* Allow more learned clauses as the search goes on */
+              if (s->conflicts >= s->next_adjust)
+                {
+                  s->next_adjust *= LEARNT_ADJUST_INC;
+                  s->max_learnts *= LEARNT_INC;
+                }
+
+              if (s->conflicts % 1000 == 0 &&
+                  ((kill_now && *kill_now) ||
+                   (deadline && time (NULL) >= deadline)))
+                return -1;
+            }
+          else
+            {
+              int var = -1;
+
+              if (conflicts >= budget)
+                {
+                  _sat_backtrack (s, 0);
+                  break;
+                }
+              if (s->learnts.n - s->n_trail >= s->max_learnts)
+                _sat_reduce (s);
+
+              while (s->n_heap > 0 && var == -1)
+                {
+                  var = _heap_pop (s);
+                  if (s->value[var] >= 0)
+                    var = -1;
+                }
+              /* Everything assigned without conflict */
+              if (var == -1)
+                return 1;
+
+              ++s->decisions;
+              s->trail_lim[s->n_levels++] = s->n_trail;
+              _sat_enqueue (s, 2 * var + !s->phase[var], NULL);
+            }
+        }
+      ++s->restarts;
+    }
+}
+
+bool sat_get_value (const sat_solver_t *s, int var)
+{
+  return s->value[var - 1] == 1;
+}
+
+void sat_print_stats (const sat_solver_t *s, stream_t *out)
+{
+  stream_printf (out, "Decisions:\t%ld\n", s->decisions);
+  stream_printf (out, "Propagations:\t%ld\n", s->propagations);
+  stream_printf (out, "Conflicts:\t%ld\n", s->conflicts);
+  stream_printf (out, "Restarts:\t%ld\n", s->restarts);
+  stream_printf (out, "Learned:\t%d kept, %ld deleted\n",
+                 s->learnts.n, s->n_deleted);
+}
+
+void sat_destroy (sat_solver_t *s)
+{
+  int i;
+
+  if (s == NULL)
+    return;
+  for (i = 0; i < s->clauses.n; ++i)
+    free (s->clauses.clause[i]);
+  for (i = 0; i < s->learnts.n; ++i)
+    free (s->learnts.clause[i]);
+  free (s->clauses.clause);
+  free (s->learnts.clause);
+  if (s->watches)
+    for (i = 0; i < 2 * s->n_vars; ++i)
+      free (s->watches[i].clause);
+  free (s->watches);
+  free (s->value);
+  free (s->phase);
+  free (s->level);
+  free (s->reason);
+  free (s->trail);
+  free (s->trail_lim);
+  free (s->activity);
+  free (s->heap);
+  free (s->heap_index);
+  free (s->seen);
+  free (s->learnt);
+  free (s);
+}
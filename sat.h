@@ -0,0 +1,80 @@
+/* RamseyScript
+ * Written in 2012 by
+ *   Andrew Poelstra <apoelstra@wpsoftware.net>
+ *
+ * To the extent possible under law, the author(s) have dedicated all
+ * copyright and related and neighboring rights to this software to
+ * the public domain worldwide. This software is distributed without
+ * any warranty.
+ *
+ * You should have received a copy of the CC0 Public Domain Dedication
+ * along with this software.
+ * If not, see <http://creativecommons.org/publicdomain/zero/1.0/>.
+ */
+
+/*! \file sat.h
+ *  \brief Defines a small built-in SAT solver.
+ *
+ *  This is a conflict-driven clause-learning solver in the style of
+ *  MiniSat: two watched literals per clause, VSIDS branching with phase
+ *  saving, first-UIP learning, Luby restarts, and deletion of inactive
+ *  learned clauses. It is meant for the fixed-length coloring problems
+ *  produced by cnf.c, so that no external solver is needed.
+ *
+ *  Variables are numbered from 1, and literals are given as in DIMACS:
+ *  v for variable v true, -v for it false.
+ */
+
+#ifndef SAT_H
+#define SAT_H
+
+#include <time.h>
+
+#include "global.h"
+
+/*! \brief Convienence typedef for the SAT solver. */
+typedef struct _sat_solver_t sat_solver_t;
+
+/*! \brief Create a new solver with no clauses.
+ *
+ *  \param [in] n_vars  The number of variables.
+ *
+ *  \return A newly-allocated solver, or NULL on failure.
+ */
+sat_solver_t *sat_new (int n_vars);
+
+/*! \brief Add a clause to the solver. Must be called before sat_solve().
+ *
+ *  \param [in] solver  The solver.
+ *  \param [in] lits    The literals of the clause.
+ *  \param [in] n_lits  The number of literals.
+ *
+ *  \return 1 on success, 0 if out of memory.
+ */
+int sat_add_clause (sat_solver_t *solver, const int *lits, int n_lits);
+
+/*! \brief Decide whether the clauses can all be satisfied.
+ *
+ *  \param [in] solver    The solver.
+ *  \param [in] deadline  The time at which to give up, or 0 for none.
+ *  \param [in] kill_now  Flag to poll to see if we should give up,
+ *                        or NULL.
+ *
+ *  \return 1 if satisfiable, 0 if not, or -1 if the solver gave up.
+ */
+int sat_solve (sat_solver_t *solver, time_t deadline, const volatile bool *kill_now);
+
+/*! \brief Returns the value of a variable in the model found by sat_solve(). */
+bool sat_get_value (const sat_solver_t *solver, int var);
+
+/*! \brief Output statistics about the last sat_solve() call.
+ *
+ *  \param [in] solver  The solver.
+ *  \param [in] out     The stream to output to.
+ */
+void sat_print_stats (const sat_solver_t *solver, stream_t *out);
+
+/*! \brief Destroy a solver and free its resources. */
+void sat_destroy (sat_solver_t *solver);
+
+#endif
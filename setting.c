@@ -192,6 +192,23 @@ static void _setting_list_print (const setting_list_t *slist, stream_t *out)
     }
 }
 
+static setting_list_t *_setting_list_clone (const setting_list_t *slist)
+{
+  const struct _setting_list_priv *priv = (const struct _setting_list_priv *) slist;
+  setting_list_t *rv = setting_list_new ();
+  int i;
+
+  if (rv == NULL)
+    return NULL;
+  for (i = 0; i < HASH_TABLE_SIZE; ++i)
+    {
+      const struct _setting_priv *set;
+      for (set = priv->setting[i]; set; set = set->next)
+        rv->add_setting (rv, setting_new (set->name, set->text));
+    }
+  return rv;
+}
+
 static void _setting_list_destroy (setting_list_t *slist)
 {
   if (slist != NULL)
@@ -203,7 +220,7 @@ static void _setting_list_destroy (setting_list_t *slist)
           {
             struct _setting_priv *tmp = priv->setting[i];
             priv->setting[i] = tmp->next;
-            free (tmp);
+            ((setting_t *) tmp)->destroy ((setting_t *) tmp);
           }
     }
   free (slist);
@@ -221,6 +238,7 @@ setting_list_t *setting_list_new ()
       rv->get_setting = _setting_list_get_setting;
       rv->remove_setting = _setting_list_remove_setting;
       rv->print       = _setting_list_print;
+      rv->clone       = _setting_list_clone;
       rv->destroy     = _setting_list_destroy;
 
       for (i = 0; i < HASH_TABLE_SIZE; ++i)
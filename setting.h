@@ -67,6 +67,8 @@ struct _setting_list_t {
   const setting_t *(*get_setting) (const setting_list_t *, const char *name);
   /*! \brief Remove a script variable of a given name. */
   int  (*remove_setting) (setting_list_t *, const char *name);
+  /*! \brief Make a new table holding copies of the same variables. */
+  setting_list_t *(*clone) (const setting_list_t *);
   /*! \brief Destroys the table and frees its associated variables. */
   void (*destroy) (setting_list_t *);
 };
@@ -0,0 +1,347 @@
+/* RamseyScript
+ * Written in 2012 by
+ *   Andrew Poelstra <apoelstra@wpsoftware.net>
+ *
+ * To the extent possible under law, the author(s) have dedicated all
+ * copyright and related and neighboring rights to this software to
+ * the public domain worldwide. This software is distributed without
+ * any warranty.
+ *
+ * You should have received a copy of the CC0 Public Domain Dedication
+ * along with this software.
+ * If not, see <http://creativecommons.org/publicdomain/zero/1.0/>.
+ */
+
+/*! \file beam.c
+ *  \brief Beam search, for finding long objects when a full search is
+ *         hopeless.
+ *
+ *  The search works one level at a time. Every child of every object
+ *  in the frontier is tried; those which pass are scored, and the
+ *  beam-width best become the next frontier. Nothing is ever
+ *  backtracked over, so the search ends after at most (length of the
+ *  longest object) levels.
+ *
+ *  The frontier is not kept as a set of objects, but as the child
+ *  indices leading to each one from the seed, one row per object in a
+ *  single array. The rows are kept in lexicographic order, so moving
+ *  the one working object from each row to the next only undoes and
+ *  redoes the levels where they differ.
+ */
+
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../child-order.h"
+#include "../ramsey/ramsey.h"
+#include "strategy.h"
+#include "beam.h"
+
+/*! \brief Frontier size when no beam-width is set. */
+#define DEFAULT_WIDTH		100
+
+/*! \brief A child of the frontier, to be scored. */
+struct _candidate {
+  /*! \brief Row of the parent in the frontier. */
+  int parent;
+  /*! \brief Index of the child. */
+  int child;
+  /*! \brief Score; higher is better. */
+  long score;
+};
+
+/*! \brief Private data for the beam strategy. */
+struct _priv {
+  /*! \brief parent struct */
+  strategy_t parent;
+
+  /*! \brief Heuristic used to score children. */
+  long (*score) (ramsey_t *, global_data_t *);
+  /*! \brief Maximum frontier size. */
+  int width;
+
+  /*! \brief Paths to the frontier objects; row i is [i * depth, (i + 1) * depth). */
+  int *rows;
+  /*! \brief Paths to the next frontier. */
+  int *new_rows;
+  /*! \brief Number of ints allocated for each of rows and new_rows. */
+  long max_rows;
+  /*! \brief Path to the working object. */
+  int *cur;
+  /*! \brief Number of ints allocated for cur. */
+  int max_cur;
+  /*! \brief Length of cur. */
+  int cur_depth;
+  /*! \brief Children of the frontier. */
+  struct _candidate *cand;
+  /*! \brief Number of candidates allocated. */
+  int max_cand;
+};
+
+/* HEURISTICS */
+/* Number of children which pass the filters */
+static long _score_children (ramsey_t *rt, global_data_t *state)
+{
+  int n_children = rt->get_n_children (rt);
+  long rv = 0;
+  int i;
+
+  (void) state;
+  for (i = 0; i < n_children; ++i)
+    if (rt->child_append (rt, i))
+      {
+        rv += rt->run_filters (rt);
+        rt->child_deappend (rt, i);
+      }
+  return rv;
+}
+
+/* For colorings, the number of colors left open to each of the next
+ * few numbers; for other objects, the same as ``children'' */
+static long _score_future (ramsey_t *rt, global_data_t *state)
+{
+  (void) state;
+  return child_order_future (rt);
+}
+
+/* Breaks ties at random only; a randomized greedy search */
+static long _score_random (ramsey_t *rt, global_data_t *state)
+{
+  (void) rt;
+  return rng_range (&state->rng, 1 << 30);
+}
+
+static const struct {
+  const char *name;
+  long (*score) (ramsey_t *, global_data_t *);
+} g_score[] = {
+  { "future",   _score_future },
+  { "children", _score_children },
+  { "random",   _score_random }
+};
+static const int g_n_scores = sizeof g_score / sizeof g_score[0];
+
+/* SEARCH */
+/* Move the working object to the object at the end of a path */
+static int _beam_move (struct _priv *priv, ramsey_t *rt, const int *path, int depth)
+{
+  int common = 0;
+
+  if (depth > priv->max_cur)
+    {
+      int *tmp = realloc (priv->cur, 2 * depth * sizeof *tmp);
+      if (tmp == NULL)
+        return 0;
+      priv->cur = tmp;
+      priv->max_cur = 2 * depth;
+    }
+
+  while (common < depth && common < priv->cur_depth &&
+         path[common] == priv->cur[common])
+    ++common;
+  /* Undo, and redo, levels; these were counted when first visited,
+   * so only the depth is kept track of here */
+  while (priv->cur_depth > common)
+    {
+      rt->child_deappend (rt, priv->cur[--priv->cur_depth]);
+      recursion_postamble (rt);
+    }
+  while (priv->cur_depth < depth)
+    {
+      priv->cur[priv->cur_depth] = path[priv->cur_depth];
+      if (!rt->child_append (rt, priv->cur[priv->cur_depth]))
+        return 0;
+      ++rt->r_depth;
+      ++priv->cur_depth;
+    }
+  return 1;
+}
+
+static int _candidate_by_score (const void *a, const void *b)
+{
+  const struct _candidate *ca = a;
+  const struct _candidate *cb = b;
+  if (ca->score != cb->score)
+    return (ca->score < cb->score) - (ca->score > cb->score);
+  if (ca->parent != cb->parent)
+    return ca->parent - cb->parent;
+  return ca->child - cb->child;
+}
+
+static int _candidate_by_path (const void *a, const void *b)
+{
+  const struct _candidate *ca = a;
+  const struct _candidate *cb = b;
+  if (ca->parent != cb->parent)
+    return ca->parent - cb->parent;
+  return ca->child - cb->child;
+}
+
+static int _beam_add_candidate (struct _priv *priv, int n_cand, int parent,
+                                int child, long score)
+{
+  if (n_cand == priv->max_cand)
+    {
+      int new_max = priv->max_cand ? 2 * priv->max_cand : 64;
+      void *tmp = realloc (priv->cand, new_max * sizeof *priv->cand);
+      if (tmp == NULL)
+        return 0;
+      priv->cand = tmp;
+      priv->max_cand = new_max;
+    }
+  priv->cand[n_cand].parent = parent;
+  priv->cand[n_cand].child = child;
+  priv->cand[n_cand].score = score;
+  return 1;
+}
+
+static void _strategy_run (strategy_t *st, ramsey_t *rt, global_data_t *state)
+{
+  struct _priv *priv = (struct _priv *) st;
+  int n_rows = 1;
+  int depth;
+
+  assert (rt != NULL);
+
+  if (!recursion_preamble (rt, state))
+    return;
+
+  priv->cur_depth = 0;
+  for (depth = 0; !state->kill_now; ++depth)
+    {
+      int n_cand = 0;
+      int i;
+      int *tmp;
+
+      /* Try every child of the frontier */
+      for (i = 0; i < n_rows; ++i)
+        {
+          int n_children, child;
+
+          if (!_beam_move (priv, rt, depth ? &priv->rows[(long) i * depth] : NULL, depth))
+            break;
+          n_children = rt->get_n_children (rt);
+          for (child = 0; child < n_children; ++child)
+            if (rt->child_append (rt, child))
+              {
+                if (recursion_preamble (rt, state))
+                  {
+                    if (!_beam_add_candidate (priv, n_cand, i, child,
+                                              priv->score (rt, state)))
+                      fprintf (stderr, "Out of memory; dropping a child from the beam.\n");
+                    else
+                      ++n_cand;
+                    recursion_postamble (rt);
+                  }
+                rt->child_deappend (rt, child);
+              }
+        }
+      if (n_cand == 0)
+        break;
+
+      /* Keep the best, in order of their paths */
+      qsort (priv->cand, n_cand, sizeof *priv->cand, _candidate_by_score);
+      if (n_cand > priv->width)
+        n_cand = priv->width;
+      qsort (priv->cand, n_cand, sizeof *priv->cand, _candidate_by_path);
+
+      if ((long) n_cand * (depth + 1) > priv->max_rows)
+        {
+          long new_max = 2 * (long) n_cand * (depth + 1);
+          int *r1 = realloc (priv->rows, new_max * sizeof *r1);
+          int *r2 = r1 ? realloc (priv->new_rows, new_max * sizeof *r2) : NULL;
+          if (r1)
+            priv->rows = r1;
+          if (r2 == NULL)
+            {
+              fprintf (stderr, "Out of memory at depth %d; stopping beam search.\n",
+                       depth + 1);
+              break;
+            }
+          priv->new_rows = r2;
+          priv->max_rows = new_max;
+        }
+      for (i = 0; i < n_cand; ++i)
+        {
+          int *row = &priv->new_rows[(long) i * (depth + 1)];
+          if (depth > 0)
+            memcpy (row, &priv->rows[(long) priv->cand[i].parent * depth],
+                    depth * sizeof *row);
+          row[depth] = priv->cand[i].child;
+        }
+      tmp = priv->rows;
+      priv->rows = priv->new_rows;
+      priv->new_rows = tmp;
+      n_rows = n_cand;
+    }
+
+  /* Back to the seed */
+  _beam_move (priv, rt, NULL, 0);
+  recursion_postamble (rt);
+}
+
+static const char *_strategy_get_type (const strategy_t *st)
+{
+  (void) st;
+  return "beam";
+}
+
+static void _strategy_destroy (strategy_t *st)
+{
+  struct _priv *priv = (struct _priv *) st;
+  free (priv->rows);
+  free (priv->new_rows);
+  free (priv->cur);
+  free (priv->cand);
+  free (priv);
+}
+
+void *strategy_beam_new (const setting_list_t *vars)
+{
+  const setting_t *width_set = vars->get_setting (vars, "beam_width");
+  const setting_t *score_set = vars->get_setting (vars, "beam_score");
+  const char *score_name = score_set ? score_set->get_text (score_set) : "future";
+  struct _priv *priv;
+  strategy_t *rv;
+  int i;
+
+  for (i = 0; i < g_n_scores; ++i)
+    if (!strcmp (g_score[i].name, score_name))
+      break;
+  if (i == g_n_scores)
+    {
+      fprintf (stderr, "Error: unknown beam-score ``%s''; use future, children or random.\n",
+               score_name);
+      return NULL;
+    }
+
+  priv = malloc (sizeof *priv);
+  rv = (strategy_t *) priv;
+  if (priv == NULL)
+    return NULL;
+
+  priv->score = g_score[i].score;
+  priv->width = width_set ? width_set->get_int_value (width_set) : DEFAULT_WIDTH;
+  if (priv->width < 1)
+    {
+      fprintf (stderr, "Error: beam-width must be positive.\n");
+      free (priv);
+      return NULL;
+    }
+
+  /* The first frontier is the seed alone, with an empty path */
+  priv->rows = priv->new_rows = NULL;
+  priv->max_rows = 0;
+  priv->cur = NULL;
+  priv->max_cur = 0;
+  priv->cur_depth = 0;
+  priv->cand = NULL;
+  priv->max_cand = 0;
+
+  rv->get_type = _strategy_get_type;
+  rv->run      = _strategy_run;
+  rv->destroy  = _strategy_destroy;
+  return rv;
+}
@@ -0,0 +1,54 @@
+/* RamseyScript
+ * Written in 2012 by
+ *   Andrew Poelstra <apoelstra@wpsoftware.net>
+ *
+ * To the extent possible under law, the author(s) have dedicated all
+ * copyright and related and neighboring rights to this software to
+ * the public domain worldwide. This software is distributed without
+ * any warranty.
+ *
+ * You should have received a copy of the CC0 Public Domain Dedication
+ * along with this software.
+ * If not, see <http://creativecommons.org/publicdomain/zero/1.0/>.
+ */
+
+
+#include <assert.h>
+#include <stdlib.h>
+
+#include "../ramsey/ramsey.h"
+#include "strategy.h"
+#include "dfs.h"
+
+static const char *_strategy_get_type (const strategy_t *st)
+{
+  (void) st;
+  return "dfs";
+}
+
+static void _strategy_run (strategy_t *st, ramsey_t *rt, global_data_t *state)
+{
+  (void) st;
+  assert (rt != NULL);
+  rt->recurse (rt, state);
+}
+
+static void _strategy_destroy (strategy_t *st)
+{
+  free (st);
+}
+
+void *strategy_dfs_new (const setting_list_t *vars)
+{
+  strategy_t *rv = malloc (sizeof *rv);
+
+  (void) vars;
+  if (rv != NULL)
+    {
+      rv->get_type = _strategy_get_type;
+      rv->run      = _strategy_run;
+      rv->destroy  = _strategy_destroy;
+    }
+  return rv;
+}
+
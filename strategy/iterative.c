@@ -0,0 +1,119 @@
+/* RamseyScript
+ * Written in 2012 by
+ *   Andrew Poelstra <apoelstra@wpsoftware.net>
+ *
+ * To the extent possible under law, the author(s) have dedicated all
+ * copyright and related and neighboring rights to this software to
+ * the public domain worldwide. This software is distributed without
+ * any warranty.
+ *
+ * You should have received a copy of the CC0 Public Domain Dedication
+ * along with this software.
+ * If not, see <http://creativecommons.org/publicdomain/zero/1.0/>.
+ */
+
+/*! \file iterative.c
+ *  \brief Depth-first search without recursion.
+ *
+ *  The search visits exactly the same objects in the same order as
+ *  the recurse() method of each object (with the natural child-order,
+ *  which is the only one it uses), but keeps its place in the
+ *  tree on the heap as a list of child indices, one per level (see
+ *  strategy_dfs_search). So it is limited by memory rather than by
+ *  the size of the C stack, and the current path can be read straight
+ *  off the list.
+ */
+
+#include <assert.h>
+#include <stdlib.h>
+
+#include "../ramsey/ramsey.h"
+#include "strategy.h"
+#include "iterative.h"
+
+/*! \brief Search state kept for each level of the tree. */
+struct _level {
+  /*! \brief Next child to try. */
+  int next;
+  /*! \brief Number of children, counted once on the way down. */
+  int n_children;
+};
+
+/*! \brief Private data for the iterative strategy. */
+struct _priv {
+  /*! \brief parent struct */
+  strategy_t parent;
+
+  /*! \brief The search; its level data is a struct _level. */
+  strategy_dfs_t dfs;
+};
+
+static const char *_strategy_get_type (const strategy_t *st)
+{
+  (void) st;
+  return "iterative";
+}
+
+static int _iterative_enter (strategy_dfs_t *dfs, ramsey_t *rt,
+                             global_data_t *state, int depth)
+{
+  struct _level *level = STRATEGY_DFS_LEVEL (dfs, depth);
+
+  (void) state;
+  level->next = 0;
+  level->n_children = rt->get_n_children (rt);
+  return 1;
+}
+
+/* Children are tried in the natural order */
+static int _iterative_next (strategy_dfs_t *dfs, ramsey_t *rt,
+                            global_data_t *state, int depth)
+{
+  struct _level *level = STRATEGY_DFS_LEVEL (dfs, depth);
+
+  (void) rt;
+  (void) state;
+  return level->next < level->n_children ? level->next++ : -1;
+}
+
+static void _strategy_run (strategy_t *st, ramsey_t *rt, global_data_t *state)
+{
+  struct _priv *priv = (struct _priv *) st;
+
+  assert (rt != NULL);
+
+  if (!recursion_preamble (rt, state))
+    return;
+  strategy_dfs_search (&priv->dfs, rt, state, 0);
+  recursion_postamble (rt);
+}
+
+static void _strategy_destroy (strategy_t *st)
+{
+  struct _priv *priv = (struct _priv *) st;
+  strategy_dfs_clear (&priv->dfs);
+  free (priv);
+}
+
+void *strategy_iterative_new (const setting_list_t *vars)
+{
+  struct _priv *priv = malloc (sizeof *priv);
+  strategy_t *rv = (strategy_t *) priv;
+
+  (void) vars;
+  if (priv == NULL)
+    return NULL;
+
+  if (!strategy_dfs_init (&priv->dfs, priv, sizeof (struct _level)))
+    {
+      free (priv);
+      return NULL;
+    }
+  priv->dfs.enter = _iterative_enter;
+  priv->dfs.next  = _iterative_next;
+
+  rv->get_type = _strategy_get_type;
+  rv->run      = _strategy_run;
+  rv->destroy  = _strategy_destroy;
+  return rv;
+}
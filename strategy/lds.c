@@ -0,0 +1,237 @@
+/* RamseyScript
+ * Written in 2012 by
+ *   Andrew Poelstra <apoelstra@wpsoftware.net>
+ *
+ * To the extent possible under law, the author(s) have dedicated all
+ * copyright and related and neighboring rights to this software to
+ * the public domain worldwide. This software is distributed without
+ * any warranty.
+ *
+ * You should have received a copy of the CC0 Public Domain Dedication
+ * along with this software.
+ * If not, see <http://creativecommons.org/publicdomain/zero/1.0/>.
+ */
+
+/*! \file lds.c
+ *  \brief Limited-discrepancy search.
+ *
+ *  At each node the children are put in order by the child-order
+ *  heuristic, and the first child passing the filters is the one the
+ *  heuristic prefers. Going into any other child is a discrepancy.
+ *  Pass k of the search is a depth-first search which only follows
+ *  paths with at most k discrepancies, so pass 0 follows the heuristic
+ *  straight down, pass 1 tries each single deviation from it, and so
+ *  on. If the heuristic is usually right, good objects are found in
+ *  early passes, however far down the tree its mistakes are.
+ *
+ *  Each pass revisits the paths of the passes before it. The search
+ *  ends after the first pass which was not cut short anywhere.
+ */
+
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "../child-order.h"
+#include "../ramsey/ramsey.h"
+#include "strategy.h"
+#include "lds.h"
+
+/*! \brief Place of the search at one level of the tree. */
+struct _level {
+  /*! \brief Number of children tried so far. */
+  int n_tried;
+  /*! \brief Number of children gone into so far. */
+  int n_entered;
+  /*! \brief Number of children. */
+  int n_children;
+  /*! \brief Index in the order arena of this level's child order. */
+  int start;
+  /*! \brief Discrepancies on the path to this level. */
+  int discrepancies;
+  /*! \brief r_stall_index before the child being tried was appended. */
+  long stall_index;
+  /*! \brief The child which last led to a record at this level, or -1;
+   *         unlike the rest, this is kept from one visit to the next. */
+  int success;
+};
+
+/*! \brief Private data for the lds strategy. */
+struct _priv {
+  /*! \brief parent struct */
+  strategy_t parent;
+
+  /*! \brief Order to try children in. */
+  e_child_order order;
+  /*! \brief The search; its level data are struct _level's. */
+  strategy_dfs_t dfs;
+  /*! \brief Number of levels whose success has been set. */
+  int n_seen;
+  /*! \brief Order to try children in, for all levels, as a stack. */
+  int *child;
+  /*! \brief Scratch space for child_order_fill(). */
+  long *score;
+  /*! \brief Size of the child and score arenas. */
+  int max_child;
+
+  /*! \brief Discrepancies allowed in the current pass. */
+  int max_disc;
+  /*! \brief Whether any path of the current pass was cut short. */
+  bool limited;
+};
+
+/* Discrepancies on the path to the next child tried at a level */
+static int _lds_discrepancies (const struct _level *level)
+{
+  return level->discrepancies + (level->n_entered > 0);
+}
+
+/* Start a level, working out the order to try its children in */
+static int _lds_enter (strategy_dfs_t *dfs, ramsey_t *rt, global_data_t *state,
+                       int depth)
+{
+  struct _priv *priv = dfs->data;
+  struct _level *level = STRATEGY_DFS_LEVEL (dfs, depth);
+  int i;
+
+  if (depth >= priv->n_seen)
+    {
+      level->success = -1;
+      priv->n_seen = depth + 1;
+    }
+  level->n_tried = 0;
+  level->n_entered = 0;
+  level->n_children = rt->get_n_children (rt);
+  level->start = 0;
+  level->discrepancies = 0;
+  if (depth > 0)
+    {
+      struct _level *parent = STRATEGY_DFS_LEVEL (dfs, depth - 1);
+
+      level->start = parent->start + parent->n_children;
+      level->discrepancies = _lds_discrepancies (parent);
+      ++parent->n_entered;
+      if (rt->r_stall_index != parent->stall_index)
+        for (i = 0; i < depth; ++i)
+          ((struct _level *) STRATEGY_DFS_LEVEL (dfs, i))->success = dfs->child[i];
+    }
+
+  if (level->start + level->n_children > priv->max_child)
+    {
+      int new_max = 2 * (level->start + level->n_children);
+      int *tmp = realloc (priv->child, new_max * sizeof *tmp);
+      long *tmp_score = tmp ? realloc (priv->score, new_max * sizeof *tmp_score) : NULL;
+      if (tmp)
+        priv->child = tmp;
+      if (tmp_score == NULL)
+        return 0;
+      priv->score = tmp_score;
+      priv->max_child = new_max;
+    }
+
+  child_order_fill (priv->order, rt, state, &priv->child[level->start],
+                    &priv->score[level->start], level->n_children,
+                    level->success);
+  return 1;
+}
+
+static int _lds_next (strategy_dfs_t *dfs, ramsey_t *rt, global_data_t *state,
+                      int depth)
+{
+  struct _priv *priv = dfs->data;
+  struct _level *level = STRATEGY_DFS_LEVEL (dfs, depth);
+
+  (void) state;
+  if (level->n_tried >= level->n_children)
+    return -1;
+  if (_lds_discrepancies (level) > priv->max_disc)
+    {
+      priv->limited = 1;
+      return -1;
+    }
+  level->stall_index = rt->r_stall_index;
+  return priv->child[level->start + level->n_tried++];
+}
+
+static bool _lds_stop (strategy_dfs_t *dfs, const ramsey_t *rt,
+                       const global_data_t *state)
+{
+  (void) dfs;
+  (void) rt;
+  return state->kill_now;
+}
+
+/* One pass, allowing max_disc discrepancies; returns 1 if any path
+ * was cut short for having too many */
+static int _lds_search (struct _priv *priv, ramsey_t *rt, global_data_t *state,
+                        int max_disc)
+{
+  priv->max_disc = max_disc;
+  priv->limited = 0;
+  strategy_dfs_search (&priv->dfs, rt, state, 0);
+  return priv->limited;
+}
+
+static void _strategy_run (strategy_t *st, ramsey_t *rt, global_data_t *state)
+{
+  struct _priv *priv = (struct _priv *) st;
+  int max_disc;
+
+  assert (rt != NULL);
+
+  if (!recursion_preamble (rt, state))
+    return;
+
+  for (max_disc = 0; !state->kill_now; ++max_disc)
+    if (!_lds_search (priv, rt, state, max_disc))
+      break;
+
+  recursion_postamble (rt);
+}
+
+static const char *_strategy_get_type (const strategy_t *st)
+{
+  (void) st;
+  return "lds";
+}
+
+static void _strategy_destroy (strategy_t *st)
+{
+  struct _priv *priv = (struct _priv *) st;
+  strategy_dfs_clear (&priv->dfs);
+  free (priv->child);
+  free (priv->score);
+  free (priv);
+}
+
+void *strategy_lds_new (const setting_list_t *vars)
+{
+  struct _priv *priv = malloc (sizeof *priv);
+  strategy_t *rv = (strategy_t *) priv;
+
+  if (priv == NULL)
+    return NULL;
+  if (!child_order_get (vars, &priv->order))
+    {
+      free (priv);
+      return NULL;
+    }
+
+  priv->child = NULL;
+  priv->score = NULL;
+  priv->max_child = 0;
+  priv->n_seen = 0;
+  if (!strategy_dfs_init (&priv->dfs, priv, sizeof (struct _level)))
+    {
+      free (priv);
+      return NULL;
+    }
+  priv->dfs.enter = _lds_enter;
+  priv->dfs.next  = _lds_next;
+  priv->dfs.stop  = _lds_stop;
+
+  rv->get_type = _strategy_get_type;
+  rv->run      = _strategy_run;
+  rv->destroy  = _strategy_destroy;
+  return rv;
+}
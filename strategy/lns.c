@@ -0,0 +1,231 @@
+/* RamseyScript
+ * Written in 2012 by
+ *   Andrew Poelstra <apoelstra@wpsoftware.net>
+ *
+ * To the extent possible under law, the author(s) have dedicated all
+ * copyright and related and neighboring rights to this software to
+ * the public domain worldwide. This software is distributed without
+ * any warranty.
+ *
+ * You should have received a copy of the CC0 Public Domain Dedication
+ * along with this software.
+ * If not, see <http://creativecommons.org/publicdomain/zero/1.0/>.
+ */
+
+/*! \file lns.c
+ *  \brief Large-neighborhood search around the longest object found.
+ *
+ *  A depth-first search is run from the seed until it stalls (see the
+ *  stall-after variable). Then, rather than giving up, the last few
+ *  levels of the longest object found are removed, and a fresh search,
+ *  with a fresh stall-after allowance, is run from what is left. If
+ *  this finds a longer object, the next round works from that one;
+ *  otherwise one more level is removed each time. The search stops
+ *  once a round would have to start from the seed itself.
+ *
+ *  The searches drive the object's child methods, as the iterative
+ *  strategy does, and remember the child indices leading to the longest
+ *  object, so it can be rebuilt from the seed without knowing anything
+ *  about the type of object.
+ */
+
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "../ramsey/ramsey.h"
+#include "strategy.h"
+#include "lns.h"
+
+/*! \brief Number of levels removed when no lns-window is set. */
+#define DEFAULT_WINDOW		8
+
+/*! \brief Place of the search at one level of the tree. */
+struct _level {
+  /*! \brief Number of children tried so far. */
+  int n_tried;
+  /*! \brief Index of the first child tried. */
+  int first;
+};
+
+/*! \brief Private data for the lns strategy. */
+struct _priv {
+  /*! \brief parent struct */
+  strategy_t parent;
+
+  /*! \brief The search; its level data are struct _level's. */
+  strategy_dfs_t dfs;
+  /*! \brief Child indices leading to the longest object found. */
+  int *best_path;
+  /*! \brief Number of levels allocated for best_path. */
+  int max_best_path;
+  /*! \brief Depth of the longest object found. */
+  int best_depth;
+  /*! \brief Number of levels to remove after a round which improved. */
+  int window;
+  /*! \brief Whether the current round starts each level at a random child. */
+  bool shuffle;
+};
+
+/* Check whether the overall limits of the search have been reached */
+static bool _lns_done (const ramsey_t *rt, const global_data_t *state)
+{
+  return state->kill_now ||
+         (rt->r_max_iterations && rt->r_iterations >= rt->r_max_iterations) ||
+         (rt->r_max_run_time &&
+          (time (NULL) - rt->r_start_time) > rt->r_max_run_time);
+}
+
+/* Start a level; children are tried in cyclic order from a random one
+ * if shuffle is set, so each round goes a different way. Also notes
+ * the object if it is the longest yet. */
+static int _lns_enter (strategy_dfs_t *dfs, ramsey_t *rt, global_data_t *state,
+                       int depth)
+{
+  struct _priv *priv = dfs->data;
+  struct _level *level = STRATEGY_DFS_LEVEL (dfs, depth);
+  int n_children = rt->get_n_children (rt);
+
+  if (depth > priv->best_depth && rt->run_filters (rt))
+    {
+      if (depth > priv->max_best_path)
+        {
+          int new_max = 2 * depth;
+          int *tmp = realloc (priv->best_path, new_max * sizeof *tmp);
+          if (tmp == NULL)
+            return 0;
+          priv->best_path = tmp;
+          priv->max_best_path = new_max;
+        }
+      memcpy (priv->best_path, dfs->child, depth * sizeof *dfs->child);
+      priv->best_depth = depth;
+    }
+
+  level->n_tried = 0;
+  level->first = (priv->shuffle && n_children > 1) ? rng_range (&state->rng, n_children) : 0;
+  return 1;
+}
+
+static int _lns_next (strategy_dfs_t *dfs, ramsey_t *rt, global_data_t *state,
+                      int depth)
+{
+  struct _level *level = STRATEGY_DFS_LEVEL (dfs, depth);
+  int n_children = rt->get_n_children (rt);
+
+  (void) state;
+  if (level->n_tried >= n_children)
+    return -1;
+  return (level->first + level->n_tried++) % n_children;
+}
+
+/* Depth-first search below the current object, which is at the given
+ * depth and has already been through recursion_preamble() */
+static void _lns_search (struct _priv *priv, ramsey_t *rt, global_data_t *state,
+                         int base, bool shuffle)
+{
+  priv->shuffle = shuffle;
+  strategy_dfs_search (&priv->dfs, rt, state, base);
+}
+
+static void _strategy_run (strategy_t *st, ramsey_t *rt, global_data_t *state)
+{
+  struct _priv *priv = (struct _priv *) st;
+  int window = priv->window;
+
+  assert (rt != NULL);
+
+  if (!recursion_preamble (rt, state))
+    return;
+
+  /* The first search is an ordinary one */
+  priv->best_depth = 0;
+  _lns_search (priv, rt, state, 0, 0);
+
+  /* Without stall-after the first search ran to completion */
+  while (rt->r_stall_after && !_lns_done (rt, state) &&
+         priv->best_depth > window)
+    {
+      int old_best = priv->best_depth;
+      int base = priv->best_depth - window;
+      int depth;
+
+      /* Rebuild the longest object, less the window */
+      for (depth = 0; depth < base; ++depth)
+        {
+          priv->dfs.child[depth] = priv->best_path[depth];
+          if (!rt->child_append (rt, priv->dfs.child[depth]))
+            break;
+          if (!recursion_preamble (rt, state))
+            {
+              rt->child_deappend (rt, priv->dfs.child[depth]);
+              break;
+            }
+        }
+
+      rt->r_stall_index = rt->r_iterations;
+      if (depth == base)
+        _lns_search (priv, rt, state, base, 1);
+
+      while (depth-- > 0)
+        {
+          recursion_postamble (rt);
+          rt->child_deappend (rt, priv->dfs.child[depth]);
+        }
+
+      if (priv->best_depth > old_best)
+        window = priv->window;
+      else
+        ++window;
+    }
+
+  recursion_postamble (rt);
+}
+
+static void _strategy_destroy (strategy_t *st)
+{
+  struct _priv *priv = (struct _priv *) st;
+  strategy_dfs_clear (&priv->dfs);
+  free (priv->best_path);
+  free (priv);
+}
+
+static const char *_strategy_get_type (const strategy_t *st)
+{
+  (void) st;
+  return "lns";
+}
+
+void *strategy_lns_new (const setting_list_t *vars)
+{
+  const setting_t *window_set = vars->get_setting (vars, "lns_window");
+  struct _priv *priv = malloc (sizeof *priv);
+  strategy_t *rv = (strategy_t *) priv;
+
+  if (priv == NULL)
+    return NULL;
+
+  priv->window = window_set ? window_set->get_int_value (window_set) : DEFAULT_WINDOW;
+  if (priv->window < 1)
+    {
+      fprintf (stderr, "Error: lns-window must be positive.\n");
+      free (priv);
+      return NULL;
+    }
+
+  priv->best_path = NULL;
+  priv->max_best_path = 0;
+  if (!strategy_dfs_init (&priv->dfs, priv, sizeof (struct _level)))
+    {
+      free (priv);
+      return NULL;
+    }
+  priv->dfs.enter = _lns_enter;
+  priv->dfs.next  = _lns_next;
+
+  rv->get_type = _strategy_get_type;
+  rv->run      = _strategy_run;
+  rv->destroy  = _strategy_destroy;
+  return rv;
+}
@@ -0,0 +1,250 @@
+/* RamseyScript
+ * Written in 2012 by
+ *   Andrew Poelstra <apoelstra@wpsoftware.net>
+ *
+ * To the extent possible under law, the author(s) have dedicated all
+ * copyright and related and neighboring rights to this software to
+ * the public domain worldwide. This software is distributed without
+ * any warranty.
+ *
+ * You should have received a copy of the CC0 Public Domain Dedication
+ * along with this software.
+ * If not, see <http://creativecommons.org/publicdomain/zero/1.0/>.
+ */
+
+/*! \file restart.c
+ *  \brief Depth-first search with randomized restarts.
+ *
+ *  Used in place of the dfs and iterative strategies when the
+ *  restart-strategy variable is set. The search is run with a budget
+ *  of iterations; when the budget runs out it is abandoned and started
+ *  again from the seed, with the children at each level tried in a new
+ *  random order and a new budget. Budgets are restart-unit times the
+ *  Luby sequence 1, 1, 2, 1, 1, 2, 4, 1, ... for ``luby'', or just
+ *  restart-unit for ``fixed''. Since targets are not reset between
+ *  runs, the best object found is kept.
+ *
+ *  The first run uses the natural order, so until its budget runs out
+ *  this is the same as an ordinary search. A run which ends within
+ *  its budget has been through the whole tree, so the search ends.
+ */
+
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../ramsey/ramsey.h"
+#include "strategy.h"
+#include "restart.h"
+
+/*! \brief Budget unit when restart-unit is unset. */
+#define DEFAULT_UNIT		1000
+
+/*! \brief Place of the search at one level of the tree. */
+struct _level {
+  /*! \brief Number of children tried so far. */
+  int n_tried;
+  /*! \brief Number of children. */
+  int n_children;
+  /*! \brief Index in the order arena of this level's child order. */
+  int start;
+};
+
+/*! \brief Private data for the restart strategy. */
+struct _priv {
+  /*! \brief parent struct */
+  strategy_t parent;
+
+  /*! \brief The search; its level data are struct _level's. */
+  strategy_dfs_t dfs;
+  /*! \brief Order to try children in, for all levels, as a stack. */
+  int *order;
+  /*! \brief Size of the order arena. */
+  int max_order;
+
+  /*! \brief Whether budgets follow the Luby sequence. */
+  bool luby;
+  /*! \brief Budget unit. */
+  long unit;
+
+  /*! \brief Whether the current run shuffles the children. */
+  bool shuffle;
+  /*! \brief Iteration count at the start of the current run. */
+  long run_start;
+  /*! \brief Budget of the current run. */
+  long budget;
+};
+
+/* Luby sequence 1, 1, 2, 1, 1, 2, 4, 1, ... */
+static long _restart_luby (int x)
+{
+  int size, seq;
+
+  for (size = 1, seq = 0; size < x + 1; ++seq)
+    size = 2 * size + 1;
+  while (size - 1 != x)
+    {
+      size = (size - 1) >> 1;
+      --seq;
+      x %= size;
+    }
+  return 1L << seq;
+}
+
+/* Start a level, working out the order to try its children in */
+static int _restart_enter (strategy_dfs_t *dfs, ramsey_t *rt, global_data_t *state,
+                           int depth)
+{
+  struct _priv *priv = dfs->data;
+  struct _level *level = STRATEGY_DFS_LEVEL (dfs, depth);
+  int *order;
+  int i;
+
+  level->n_tried = 0;
+  level->n_children = rt->get_n_children (rt);
+  if (depth == 0)
+    level->start = 0;
+  else
+    {
+      const struct _level *parent = STRATEGY_DFS_LEVEL (dfs, depth - 1);
+      level->start = parent->start + parent->n_children;
+    }
+
+  if (level->start + level->n_children > priv->max_order)
+    {
+      int new_max = 2 * (level->start + level->n_children);
+      int *tmp = realloc (priv->order, new_max * sizeof *tmp);
+      if (tmp == NULL)
+        return 0;
+      priv->order = tmp;
+      priv->max_order = new_max;
+    }
+
+  /* Fisher-Yates shuffle */
+  order = &priv->order[level->start];
+  for (i = 0; i < level->n_children; ++i)
+    {
+      int j = priv->shuffle ? rng_range (&state->rng, i + 1) : i;
+      if (j != i)
+        order[i] = order[j];
+      order[j] = i;
+    }
+  return 1;
+}
+
+static int _restart_next (strategy_dfs_t *dfs, ramsey_t *rt, global_data_t *state,
+                          int depth)
+{
+  const struct _priv *priv = dfs->data;
+  struct _level *level = STRATEGY_DFS_LEVEL (dfs, depth);
+
+  (void) rt;
+  (void) state;
+  if (level->n_tried >= level->n_children)
+    return -1;
+  return priv->order[level->start + level->n_tried++];
+}
+
+/* Whether the run's budget has run out */
+static bool _restart_stop (strategy_dfs_t *dfs, const ramsey_t *rt,
+                           const global_data_t *state)
+{
+  const struct _priv *priv = dfs->data;
+
+  (void) state;
+  return rt->r_iterations - priv->run_start >= priv->budget;
+}
+
+/* Search until the budget runs out; returns 1 if it did not */
+static int _restart_search (struct _priv *priv, ramsey_t *rt, global_data_t *state,
+                            long budget, bool shuffle)
+{
+  priv->run_start = rt->r_iterations;
+  priv->budget = budget;
+  priv->shuffle = shuffle;
+  strategy_dfs_search (&priv->dfs, rt, state, 0);
+  return !_restart_stop (&priv->dfs, rt, state);
+}
+
+static void _strategy_run (strategy_t *st, ramsey_t *rt, global_data_t *state)
+{
+  struct _priv *priv = (struct _priv *) st;
+  int run;
+
+  assert (rt != NULL);
+
+  if (!recursion_preamble (rt, state))
+    return;
+
+  /* A run also ends early if a search limit is reached, which ends
+   * the search just as well */
+  for (run = 0; !state->kill_now; ++run)
+    {
+      long budget = priv->unit * (priv->luby ? _restart_luby (run) : 1);
+      if (_restart_search (priv, rt, state, budget, run > 0))
+        break;
+    }
+
+  recursion_postamble (rt);
+}
+
+static const char *_strategy_get_type (const strategy_t *st)
+{
+  return ((struct _priv *) st)->luby ? "luby restarts" : "fixed restarts";
+}
+
+static void _strategy_destroy (strategy_t *st)
+{
+  struct _priv *priv = (struct _priv *) st;
+  strategy_dfs_clear (&priv->dfs);
+  free (priv->order);
+  free (priv);
+}
+
+void *strategy_restart_new (const setting_list_t *vars)
+{
+  const setting_t *restart_set = vars->get_setting (vars, "restart_strategy");
+  const setting_t *unit_set = vars->get_setting (vars, "restart_unit");
+  struct _priv *priv;
+  strategy_t *rv;
+
+  assert (restart_set != NULL);
+  if (strcmp (restart_set->get_text (restart_set), "luby") &&
+      strcmp (restart_set->get_text (restart_set), "fixed"))
+    {
+      fprintf (stderr, "Error: unknown restart-strategy ``%s''; use luby, fixed or none.\n",
+               restart_set->get_text (restart_set));
+      return NULL;
+    }
+
+  priv = malloc (sizeof *priv);
+  rv = (strategy_t *) priv;
+  if (priv == NULL)
+    return NULL;
+
+  priv->luby = !strcmp (restart_set->get_text (restart_set), "luby");
+  priv->unit = unit_set ? unit_set->get_int_value (unit_set) : DEFAULT_UNIT;
+  if (priv->unit < 1)
+    {
+      fprintf (stderr, "Error: restart-unit must be positive.\n");
+      free (priv);
+      return NULL;
+    }
+
+  priv->max_order = 0;
+  priv->order = NULL;
+  if (!strategy_dfs_init (&priv->dfs, priv, sizeof (struct _level)))
+    {
+      free (priv);
+      return NULL;
+    }
+  priv->dfs.enter = _restart_enter;
+  priv->dfs.next  = _restart_next;
+  priv->dfs.stop  = _restart_stop;
+
+  rv->get_type = _strategy_get_type;
+  rv->run      = _strategy_run;
+  rv->destroy  = _strategy_destroy;
+  return rv;
+}
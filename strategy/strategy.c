@@ -0,0 +1,183 @@
+/* RamseyScript
+ * Written in 2012 by
+ *   Andrew Poelstra <apoelstra@wpsoftware.net>
+ *
+ * To the extent possible under law, the author(s) have dedicated all
+ * copyright and related and neighboring rights to this software to
+ * the public domain worldwide. This software is distributed without
+ * any warranty.
+ *
+ * You should have received a copy of the CC0 Public Domain Dedication
+ * along with this software.
+ * If not, see <http://creativecommons.org/publicdomain/zero/1.0/>.
+ */
+
+
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+
+#include "../ramsey/ramsey.h"
+#include "strategy.h"
+
+/* INSTALL STRATEGIES HERE */
+#include "beam.h"
+#include "dfs.h"
+#include "iterative.h"
+#include "lds.h"
+#include "lns.h"
+#include "restart.h"
+static const parser_t g_strategy[] = {
+  { "dfs",       "Depth-first search by recursion (the default).",     strategy_dfs_new },
+  { "iterative", "Depth-first search using an explicit stack, for very deep searches.",
+    strategy_iterative_new },
+  { "lns",       "Restart stalled searches near the longest object found.",
+    strategy_lns_new },
+  { "beam",      "Keep only the beam-width most promising objects at each length.",
+    strategy_beam_new },
+  { "lds",       "Limited-discrepancy search, following child-order.",
+    strategy_lds_new }
+};
+static const int g_n_strategies = sizeof g_strategy / sizeof g_strategy[0];
+/* end INSTALL STRATEGIES HERE */
+
+strategy_t *strategy_new (const char *data, const setting_list_t *vars)
+{
+  assert (data != NULL);
+  if (data && *data)
+    {
+      int i;
+      const setting_t *restart_set = vars->get_setting (vars, "restart_strategy");
+
+      /* Restarts replace an ordinary depth-first search */
+      if (restart_set && strcmp (restart_set->get_text (restart_set), "none"))
+        {
+          if (!strcmp (data, "dfs") || !strcmp (data, "iterative"))
+            return strategy_restart_new (vars);
+          fprintf (stderr, "Error: restart-strategy cannot be used with strategy ``%s''.\n",
+                   data);
+          return NULL;
+        }
+
+      for (i = 0; i < g_n_strategies; ++i)
+        if (!strcmp (g_strategy[i].name, data))
+          return g_strategy[i].construct (vars);
+      fprintf (stderr, "Error: unknown strategy ``%s''.\n", data);
+    }
+  return NULL;
+}
+
+void strategy_usage (stream_t *out)
+{
+  int i;
+  stream_printf (out,
+    "Usage: \n"
+    "  set strategy <strategy>  Choose how ``search'' explores the space\n"
+    "\n"
+    "Available strategies:\n");
+  for (i = 0; i < g_n_strategies; ++i)
+    stream_printf (out, "  %20s  %s\n", g_strategy[i].name, g_strategy[i].help);
+}
+
+
+/* EXPLICIT-STACK SEARCH */
+
+/*! \brief Initial number of levels allocated for an explicit-stack search. */
+#define DEFAULT_MAX_PATH	1024
+
+int strategy_dfs_init (strategy_dfs_t *dfs, void *data, size_t level_size)
+{
+  dfs->data = data;
+  dfs->enter = NULL;
+  dfs->next = NULL;
+  dfs->stop = NULL;
+  dfs->level_size = level_size;
+  dfs->max_path = DEFAULT_MAX_PATH;
+  dfs->child = malloc (dfs->max_path * sizeof *dfs->child);
+  dfs->level = malloc (dfs->max_path * level_size + 1);
+  if (dfs->child == NULL || dfs->level == NULL)
+    {
+      strategy_dfs_clear (dfs);
+      return 0;
+    }
+  return 1;
+}
+
+void strategy_dfs_clear (strategy_dfs_t *dfs)
+{
+  free (dfs->child);
+  free (dfs->level);
+  dfs->child = NULL;
+  dfs->level = NULL;
+}
+
+/* Make room for the given depth; returns 0 if out of memory */
+static int _strategy_dfs_grow (strategy_dfs_t *dfs, int depth)
+{
+  int new_max = 2 * dfs->max_path;
+  int *tmp;
+  char *tmp_level;
+
+  if (depth < dfs->max_path)
+    return 1;
+  tmp = realloc (dfs->child, new_max * sizeof *tmp);
+  if (tmp == NULL)
+    return 0;
+  dfs->child = tmp;
+  tmp_level = realloc (dfs->level, new_max * dfs->level_size + 1);
+  if (tmp_level == NULL)
+    return 0;
+  dfs->level = tmp_level;
+  dfs->max_path = new_max;
+  return 1;
+}
+
+void strategy_dfs_search (strategy_dfs_t *dfs, ramsey_t *rt,
+                          global_data_t *state, int base)
+{
+  int depth = base;
+
+  assert (rt != NULL);
+  assert (dfs->enter != NULL && dfs->next != NULL);
+
+  if (!_strategy_dfs_grow (dfs, base) || !dfs->enter (dfs, rt, state, base))
+    return;
+  for (;;)
+    {
+      int child = (dfs->stop && dfs->stop (dfs, rt, state)) ? -1
+                : dfs->next (dfs, rt, state, depth);
+
+      /* Out of children; go back up */
+      if (child < 0)
+        {
+          if (depth == base)
+            break;
+          recursion_postamble (rt);
+          --depth;
+          rt->child_deappend (rt, dfs->child[depth]);
+          continue;
+        }
+
+      dfs->child[depth] = child;
+      if (!rt->child_append (rt, child))
+        continue;
+      if (!recursion_preamble (rt, state))
+        {
+          rt->child_deappend (rt, child);
+          continue;
+        }
+
+      /* Go down into the child */
+      if (!_strategy_dfs_grow (dfs, depth + 1) ||
+          !dfs->enter (dfs, rt, state, depth + 1))
+        {
+          fprintf (stderr, "Out of memory at depth %d; not going deeper.\n",
+                   depth + 1);
+          recursion_postamble (rt);
+          rt->child_deappend (rt, child);
+          continue;
+        }
+      ++depth;
+    }
+}
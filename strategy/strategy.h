@@ -0,0 +1,121 @@
+/* RamseyScript
+ * Written in 2012 by
+ *   Andrew Poelstra <apoelstra@wpsoftware.net>
+ *
+ * To the extent possible under law, the author(s) have dedicated all
+ * copyright and related and neighboring rights to this software to
+ * the public domain worldwide. This software is distributed without
+ * any warranty.
+ *
+ * You should have received a copy of the CC0 Public Domain Dedication
+ * along with this software.
+ * If not, see <http://creativecommons.org/publicdomain/zero/1.0/>.
+ */
+
+/*! \file strategy.h
+ *  \brief Defines the search strategy type.
+ */
+
+#ifndef STRATEGY_H
+#define STRATEGY_H
+
+#include <stddef.h>
+
+#include "../global.h"
+#include "../stream.h"
+
+/*! \brief A way of exploring the search space of a Ramsey object.
+ *
+ *  The default strategy simply calls the object's recurse() method;
+ *  others drive the search themselves, through the object's
+ *  get_n_children(), child_append() and child_deappend() methods.
+ */
+struct _strategy_t {
+  /*! \brief Returns a string description of the strategy. */
+  const char *(*get_type) (const strategy_t *);
+  /*! \brief Search the space of objects, using the given object as a seed. */
+  void (*run)     (strategy_t *, ramsey_t *, global_data_t *);
+  /*! \brief Destroy the strategy and free its associated resources. */
+  void (*destroy) (strategy_t *);
+};
+
+/*! \brief Creates a new search strategy.
+ *
+ *  \param [in] data   The name of the strategy (i.e., "dfs").
+ *  \param [in] vars   The table of script variables.
+ *
+ *  \return A newly-allocated strategy, or NULL on failure.
+ */
+strategy_t *strategy_new (const char *data, const setting_list_t *vars);
+
+/*! \brief Output the list of installed strategies. */
+void strategy_usage (stream_t *out);
+
+/*! \brief Convienence typedef for explicit-stack searches. */
+typedef struct _strategy_dfs strategy_dfs_t;
+
+/*! \brief A depth-first search using an explicit stack.
+ *
+ *  The search goes through the object's child methods, and keeps its
+ *  place in the tree on the heap, one level per depth, so it is limited
+ *  by memory rather than by the size of the C stack. Strategies built
+ *  on it choose through the hooks which children are tried, in what
+ *  order, and when to give up.
+ */
+struct _strategy_dfs {
+  /*! \brief Data for the hooks; usually the strategy itself. */
+  void *data;
+  /*! \brief Start a level, as the search goes down into it. Returns 0 if
+   *         the level could not be started (e.g., for lack of memory), in
+   *         which case the search does not go down after all. */
+  int  (*enter) (strategy_dfs_t *, ramsey_t *, global_data_t *, int depth);
+  /*! \brief Returns the index of the next child to try at a level, or -1
+   *         if there are no more and the search should go back up. */
+  int  (*next)  (strategy_dfs_t *, ramsey_t *, global_data_t *, int depth);
+  /*! \brief Returns 1 if the search should go back up to where it started
+   *         (e.g., when a budget runs out). May be NULL. */
+  bool (*stop)  (strategy_dfs_t *, const ramsey_t *, const global_data_t *);
+
+  /*! \brief Index of the child being explored at each level. */
+  int *child;
+  /*! \brief The hooks' own data for each level (see STRATEGY_DFS_LEVEL). */
+  char *level;
+  /*! \brief Size of the hooks' data for one level. */
+  size_t level_size;
+  /*! \brief Number of levels allocated. */
+  int max_path;
+};
+
+/*! \brief The hooks' data for one level of an explicit-stack search. */
+#define STRATEGY_DFS_LEVEL(dfs, depth) \
+  ((void *) ((dfs)->level + (size_t) (depth) * (dfs)->level_size))
+
+/*! \brief Sets up an explicit-stack search. The hooks are left to the caller.
+ *
+ *  \param [out] dfs         The search.
+ *  \param [in]  data        Data for the hooks.
+ *  \param [in]  level_size  Size of the hooks' data for one level.
+ *
+ *  \return 1 on success, 0 if out of memory.
+ */
+int strategy_dfs_init (strategy_dfs_t *dfs, void *data, size_t level_size);
+
+/*! \brief Frees the resources of an explicit-stack search. */
+void strategy_dfs_clear (strategy_dfs_t *dfs);
+
+/*! \brief Searches below an object.
+ *
+ *  The object must have been through recursion_preamble(), and if base
+ *  is not 0, the caller must have put the children leading to it in
+ *  dfs->child. The object is left as it was found.
+ *
+ *  \param [in] dfs    The search.
+ *  \param [in] rt     The object to search below.
+ *  \param [in] state  The global state of the program.
+ *  \param [in] base   The depth of the object.
+ */
+void strategy_dfs_search (strategy_dfs_t *dfs, ramsey_t *rt,
+                          global_data_t *state, int base);
+
+#endif
+
@@ -0,0 +1,475 @@
+/* RamseyScript
+ * Written in 2012 by
+ *   Andrew Poelstra <apoelstra@wpsoftware.net>
+ *
+ * To the extent possible under law, the author(s) have dedicated all
+ * copyright and related and neighboring rights to this software to
+ * the public domain worldwide. This software is distributed without
+ * any warranty.
+ *
+ * You should have received a copy of the CC0 Public Domain Dedication
+ * along with this software.
+ * If not, see <http://creativecommons.org/publicdomain/zero/1.0/>.
+ */
+/*! \file sweep.c
+ *  \brief Implementation of parameter sweeps.
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <ctype.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <time.h>
+
+#include "global.h"
+#include "batch.h"
+#include "buffer-stream.h"
+#include "estimate.h"
+#include "process.h"
+#include "recurse.h"
+#include "sweep.h"
+#include "dump/dump.h"
+#include "ramsey/ramsey.h"
+#include "target/max-length.h"
+#include "target/target.h"
+
+/*! \brief One run of the block of a sweep. */
+struct _point {
+  /*! \brief The value of the variable. */
+  char *value;
+  /*! \brief The point's own state, or NULL if it could not be set up. */
+  global_data_t *state;
+  /*! \brief Estimated iterations of the block's first search. */
+  double estimate;
+  /*! \brief Wall-clock time the block took, in seconds. */
+  double seconds;
+};
+
+/*! \brief State shared between the threads of a sweep. */
+struct _sweep {
+  /*! \brief Guards next. */
+  pthread_mutex_t lock;
+  /*! \brief The points, largest estimate first. */
+  struct _point **order;
+  /*! \brief Number of points. */
+  int n_points;
+  /*! \brief Index into order of the next point to run. */
+  int next;
+  /*! \brief The global state of the program. */
+  global_data_t *state;
+};
+
+/* Copy out the next value of a sweep line, or return NULL at the end */
+static char *_next_value (const char **scan)
+{
+  const char *start;
+  int depth = 0;
+
+  while (isspace (**scan))
+    ++*scan;
+  start = *scan;
+  if (*start == 0 || *start == '{')
+    return NULL;
+  do
+    {
+      if (**scan == '[')
+        ++depth;
+      else if (**scan == ']')
+        --depth;
+      ++*scan;
+    }
+  while (**scan && (depth > 0 || !(isspace (**scan) || **scan == '{')));
+
+  return strndup (start, *scan - start);
+}
+
+/* Read a block, given the text after its opening brace, into a stream;
+ * returns 0 if it is not closed */
+static int _read_block (stream_t *block, const char *rest, stream_t *in)
+{
+  char *line;
+  int depth = 0;
+
+  while (isspace (*rest))
+    ++rest;
+  /* A block on a single line */
+  if (*rest)
+    {
+      size_t n = strlen (rest);
+      while (n > 0 && isspace (rest[n - 1]))
+        --n;
+      if (rest[n - 1] != '}' || (line = strndup (rest, n - 1)) == NULL)
+        return 0;
+      block->write (block, line);
+      block->write (block, "\n");
+      free (line);
+      return 1;
+    }
+
+  while ((line = in->read_line (in)) != NULL)
+    {
+      const char *start = line;
+      const char *end = line + strlen (line);
+
+      while (isspace (*start))
+        ++start;
+      while (end > start && isspace (end[-1]))
+        --end;
+      if (end - start == 1 && *start == '}' && depth-- == 0)
+        {
+          free (line);
+          return 1;
+        }
+      else if (end > start && end[-1] == '{')
+        ++depth;
+
+      block->write (block, line);
+      if (*line && line[strlen (line) - 1] != '\n')
+        block->write (block, "\n");
+      free (line);
+    }
+  return 0;
+}
+
+/* Find the first ``search'' line of a block, outside of any blocks
+ * within it, or NULL if it has none */
+static const char *_find_search (const char *text)
+{
+  int depth = 0;
+
+  while (text && *text)
+    {
+      const char *word = text;
+      const char *end = strchr (text, '\n');
+
+      if (end == NULL)
+        end = text + strlen (text);
+      while (*word == ' ' || *word == '\t')
+        ++word;
+      if (depth == 0 && !strncasecmp (word, "search", 6) && isspace (word[6]))
+        return text;
+
+      while (end > word && isspace (end[-1]))
+        --end;
+      if (end - word == 1 && *word == '}')
+        --depth;
+      else if (end > word && end[-1] == '{')
+        ++depth;
+
+      text = strchr (text, '\n');
+      if (text)
+        ++text;
+    }
+  return NULL;
+}
+
+/* Estimate the iterations of the search a ``search'' line would run */
+static double _estimate_search (const char *line, global_data_t *state)
+{
+  const setting_t *n_probes_set = SETTING ("estimate_probes");
+  const setting_t *rand_len_set = SETTING ("random_length");
+  char *buf = strndup (line, strcspn (line, "\n"));
+  char *tok, *save;
+  ramsey_t *seed = NULL;
+  double rv = 0;
+  int i;
+
+  if (buf == NULL)
+    return 0;
+  /* Read it as process() would */
+  for (i = 0; buf[i]; ++i)
+    if (buf[i] == '-')
+      buf[i] = '_';
+    else if (isalpha (buf[i]))
+      buf[i] = tolower (buf[i]);
+  strtok_r (buf, " \t", &save);
+  tok = strtok_r (NULL, " #\t", &save);
+  if (tok)
+    seed = ramsey_new (tok, state->settings);
+  tok = strtok_r (NULL, "\n", &save);
+
+  /* A search from a file of seeds is not estimated */
+  if (seed && n_probes_set && !(tok && *tok == '@'))
+    {
+      filter_list *flist;
+      rng_t rng = state->rng;
+
+      for (flist = state->filters; flist; flist = flist->next)
+        seed->add_filter (seed, flist->data->clone (flist->data));
+      if (tok && *tok == '[')
+        seed->parse (seed, tok);
+      else if (tok && !strcmp (tok, "random"))
+        seed->randomize (seed, rand_len_set->get_int_value (rand_len_set), &rng);
+
+      recursion_reset (seed, state);
+      rv = estimate_size (seed, n_probes_set->get_int_value (n_probes_set), state);
+    }
+
+  if (seed)
+    seed->destroy (seed);
+  free (buf);
+  return rv;
+}
+
+/* Set up a point, and run its block up to the first search */
+static global_data_t *_point_new (struct _point *p, const char *name,
+                                  const char *text, const char *split,
+                                  global_data_t *state)
+{
+  stream_t *in = buffer_stream_new ();
+  stream_t *out = buffer_stream_new ();
+  global_data_t *rv = NULL;
+
+  if (in && out)
+    rv = copy_defaults (state, in, out, state->err_stream);
+  if (rv == NULL)
+    {
+      fprintf (stderr, "Out of memory setting up sweep point ``%s''.\n", p->value);
+      if (in)
+        in->destroy (in);
+      if (out)
+        out->destroy (out);
+      return NULL;
+    }
+
+  if (!rv->settings->add_setting (rv->settings, setting_new (name, p->value)))
+    {
+      fprintf (stderr, "Failed to set ``%s'' to ``%s''.\n", name, p->value);
+      free_defaults (rv);
+      in->destroy (in);
+      out->destroy (out);
+      return NULL;
+    }
+  /* The collectors may read the variable when constructed */
+  free_collectors (rv->targets);
+  free_collectors (rv->dumps);
+  rv->targets = copy_collectors (state->targets, target_new, rv->settings);
+  rv->dumps = copy_collectors (state->dumps, dump_new, rv->settings);
+
+  if (split)
+    {
+      char *prefix = strndup (text, split - text);
+      if (prefix)
+        {
+          in->write (in, prefix);
+          process (rv);
+          free (prefix);
+        }
+      p->estimate = _estimate_search (split, rv);
+      buffer_stream_clear (in);
+      text = split;
+    }
+  in->write (in, text);
+  return rv;
+}
+
+static void _point_destroy (struct _point *p)
+{
+  if (p->state)
+    {
+      p->state->in_stream->destroy (p->state->in_stream);
+      p->state->out_stream->destroy (p->state->out_stream);
+      free_defaults (p->state);
+    }
+  free (p->value);
+}
+
+/* Largest estimate first, then in the order given */
+static int _point_compare (const void *a, const void *b)
+{
+  const struct _point *pa = *(struct _point * const *) a;
+  const struct _point *pb = *(struct _point * const *) b;
+
+  if (pa->estimate != pb->estimate)
+    return pa->estimate < pb->estimate ? 1 : -1;
+  return pa < pb ? -1 : pa > pb;
+}
+
+static void *_sweep_main (void *arg)
+{
+  struct _sweep *s = arg;
+
+  while (1)
+    {
+      struct _point *p = NULL;
+      struct timespec start, end;
+
+      pthread_mutex_lock (&s->lock);
+      if (s->next < s->n_points)
+        p = s->order[s->next++];
+      pthread_mutex_unlock (&s->lock);
+      if (p == NULL)
+        break;
+      if (p->state == NULL || s->state->kill_now)
+        continue;
+
+      clock_gettime (CLOCK_MONOTONIC, &start);
+      process (p->state);
+      clock_gettime (CLOCK_MONOTONIC, &end);
+      p->seconds = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+    }
+  return NULL;
+}
+
+/* Output each point's output, then the table of results */
+static void _sweep_output (const struct _point *point, int n_points,
+                           const char *name, global_data_t *state)
+{
+  stream_t *out = state->out_stream;
+  int width = strlen (name);
+  int i;
+
+  for (i = 0; i < n_points; ++i)
+    if ((int) strlen (point[i].value) > width)
+      width = strlen (point[i].value);
+
+  for (i = 0; i < n_points; ++i)
+    if (point[i].state)
+      {
+        if (!state->quiet)
+          stream_printf (out, "#### Sweep: %s = %s ####\n", name, point[i].value);
+        out->write (out, buffer_stream_get_text (point[i].state->out_stream));
+      }
+
+  stream_printf (out, "#### Sweep results ####\n");
+  stream_printf (out, "%*s  %11s  %12s  %10s\n", width, name,
+                 "max. length", "iterations", "time");
+  for (i = 0; i < n_points; ++i)
+    if (point[i].state)
+      {
+        const dc_list *dlist;
+        long max_length = -1;
+
+        for (dlist = point[i].state->targets; dlist; dlist = dlist->next)
+          if (dlist->data && !strcmp (dlist->data->get_type (dlist->data), "max-length"))
+            max_length = target_max_length_get_length (dlist->data);
+
+        stream_printf (out, "%*s  ", width, point[i].value);
+        if (max_length >= 0)
+          stream_printf (out, "%11ld  ", max_length);
+        else
+          stream_printf (out, "%11s  ", "-");
+        stream_printf (out, "%12ld  %9.2fs\n", point[i].state->iterations,
+                       point[i].seconds);
+      }
+  stream_printf (out, "#### Done. ####\n\n");
+}
+
+int sweep_run (const char *name, const char *values, global_data_t *state)
+{
+  struct _sweep s;
+  struct _point *point = NULL;
+  stream_t *block;
+  pthread_t *thread;
+  const char *text, *split;
+  char *value;
+  int max_points = 0;
+  int n_threads;
+  int n_started = 0;
+  int i;
+
+  /* Parse values */
+  s.n_points = 0;
+  while ((value = _next_value (&values)) != NULL)
+    {
+      if (s.n_points == max_points)
+        {
+          struct _point *tmp;
+          max_points = max_points ? 2 * max_points : 8;
+          tmp = realloc (point, max_points * sizeof *point);
+          if (tmp == NULL)
+            {
+              free (value);
+              break;
+            }
+          point = tmp;
+        }
+      point[s.n_points].value = value;
+      point[s.n_points].state = NULL;
+      point[s.n_points].estimate = 0;
+      point[s.n_points].seconds = 0;
+      ++s.n_points;
+    }
+  if (*values != '{' || s.n_points == 0)
+    {
+      for (i = 0; i < s.n_points; ++i)
+        _point_destroy (&point[i]);
+      free (point);
+      return -1;
+    }
+
+  /* Read block */
+  block = buffer_stream_new ();
+  if (block == NULL || !_read_block (block, values + 1, state->in_stream))
+    {
+      if (block == NULL)
+        fprintf (stderr, "Out of memory reading sweep block.\n");
+      else
+        fprintf (stderr, "Error: sweep block is not closed by ``}''.\n");
+      for (i = 0; i < s.n_points; ++i)
+        _point_destroy (&point[i]);
+      free (point);
+      if (block)
+        block->destroy (block);
+      return 0;
+    }
+  text = buffer_stream_get_text (block);
+  split = _find_search (text);
+
+  /* Set up points, and order them by estimate */
+  s.order = malloc (s.n_points * sizeof *s.order);
+  n_threads = batch_get_n_threads (state);
+  if (n_threads > s.n_points)
+    n_threads = s.n_points;
+  thread = malloc (n_threads * sizeof *thread);
+  if (s.order == NULL || thread == NULL)
+    {
+      fprintf (stderr, "Out of memory starting sweep.\n");
+      for (i = 0; i < s.n_points; ++i)
+        _point_destroy (&point[i]);
+      free (point);
+      free (s.order);
+      free (thread);
+      block->destroy (block);
+      return 0;
+    }
+  for (i = 0; i < s.n_points; ++i)
+    {
+      point[i].state = _point_new (&point[i], name, text, split, state);
+      s.order[i] = &point[i];
+    }
+  qsort (s.order, s.n_points, sizeof *s.order, _point_compare);
+
+  /* Run points */
+  pthread_mutex_init (&s.lock, NULL);
+  s.next = 0;
+  s.state = state;
+  for (i = 0; i < n_threads; ++i)
+    if (pthread_create (&thread[n_started], NULL, _sweep_main, &s) == 0)
+      ++n_started;
+  /* If no thread could be started, run the points here */
+  if (n_started == 0)
+    _sweep_main (&s);
+  for (i = 0; i < n_started; ++i)
+    pthread_join (thread[i], NULL);
+  pthread_mutex_destroy (&s.lock);
+
+  _sweep_output (point, s.n_points, name, state);
+
+  /* Cleanup */
+  for (i = 0; i < s.n_points; ++i)
+    {
+      if (point[i].state)
+        state->iterations += point[i].state->iterations;
+      _point_destroy (&point[i]);
+    }
+  free (point);
+  free (s.order);
+  free (thread);
+  block->destroy (block);
+  return s.n_points;
+}
@@ -0,0 +1,49 @@
+/* RamseyScript
+ * Written in 2012 by
+ *   Andrew Poelstra <apoelstra@wpsoftware.net>
+ *
+ * To the extent possible under law, the author(s) have dedicated all
+ * copyright and related and neighboring rights to this software to
+ * the public domain worldwide. This software is distributed without
+ * any warranty.
+ *
+ * You should have received a copy of the CC0 Public Domain Dedication
+ * along with this software.
+ * If not, see <http://creativecommons.org/publicdomain/zero/1.0/>.
+ */
+/*! \file sweep.h
+ *  \brief Defines parameter sweeps: running a block of script once for
+ *         each of a list of values of a variable.
+ */
+
+#ifndef SWEEP_H
+#define SWEEP_H
+
+#include "global.h"
+
+/*! \brief Runs a block of script once for each value of a variable.
+ *
+ *  The values are read from the rest of a ``sweep'' line, up to the
+ *  opening brace; a value is either a word or a bracketed object such as
+ *  [1, 2]. The block follows, up to its closing brace, on the same line
+ *  or on the lines after it, read from the state's input stream.
+ *
+ *  Each run ("point") has its own copy of the variables, filters,
+ *  targets and dumps, with the variable set to its value. The commands
+ *  of the block before its first ``search'' are run on every point, and
+ *  that search is then estimated (see estimate_size()). The rest of each
+ *  block is run on a pool of threads (see batch_get_n_threads()), the
+ *  points of largest estimate first. The output of each point is held
+ *  back, and output in the order of the values once all are done,
+ *  followed by a table of each point's max. length, iterations and time.
+ *
+ *  \param [in] name    The name of the variable to sweep.
+ *  \param [in] values  The text after the name on the ``sweep'' line.
+ *  \param [in] state   The global state of the program.
+ *
+ *  \return The number of points run, or -1 if the line could not be
+ *          parsed, in which case no block was read.
+ */
+int sweep_run (const char *name, const char *values, global_data_t *state);
+
+#endif
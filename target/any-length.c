@@ -53,6 +53,21 @@ static void _target_output  (const data_collector_t *dc, stream_t *out)
   (void) out;
 }
 
+/* Everything is output as it is found, so there is nothing to merge */
+static void _target_save (const data_collector_t *dc, stream_t *out)
+{
+  (void) dc;
+  (void) out;
+}
+
+static void _target_merge (data_collector_t *dc, const char *text,
+                           const ramsey_t *proto)
+{
+  (void) dc;
+  (void) text;
+  (void) proto;
+}
+
 static void _target_destroy (data_collector_t *dc)
 {
   free (dc);
@@ -67,6 +82,8 @@ void *target_any_length_new (const setting_list_t *vars)
     {
       rv->reset   = _target_reset;
       rv->output  = _target_output;
+      rv->save    = _target_save;
+      rv->merge   = _target_merge;
       rv->destroy = _target_destroy;
 
       rv->get_type = _target_get_type;
@@ -65,6 +65,12 @@ static void _target_reset (data_collector_t *dc)
   priv->max_obj = NULL;
 }
 
+long target_max_length_get_length (const data_collector_t *dc)
+{
+  const struct _target_priv *priv = (const struct _target_priv *) dc;
+  return priv->max_recorded;
+}
+
 static void _target_output  (const data_collector_t *dc, stream_t *out)
 {
   const struct _target_priv *priv = (struct _target_priv *) dc;
@@ -78,8 +84,29 @@ static void _target_output  (const data_collector_t *dc, stream_t *out)
     }
 }
 
+static void _target_save (const data_collector_t *dc, stream_t *out)
+{
+  const struct _target_priv *priv = (struct _target_priv *) dc;
+  if (priv->max_obj)
+    priv->max_obj->print (priv->max_obj, out);
+}
+
+static void _target_merge (data_collector_t *dc, const char *text,
+                           const ramsey_t *proto)
+{
+  ramsey_t *obj;
+
+  if (*text != '[' || (obj = proto->clone (proto)) == NULL)
+    return;
+  obj->empty (obj);
+  obj->parse (obj, text);
+  dc->record (dc, obj, NULL);
+  obj->destroy (obj);
+}
+
 static void _target_destroy (data_collector_t *dc)
 {
+  _target_reset (dc);
   free (dc);
 }
 
@@ -93,6 +120,8 @@ void *target_max_length_new (const setting_list_t *vars)
     {
       rv->reset   = _target_reset;
       rv->output  = _target_output;
+      rv->save    = _target_save;
+      rv->merge   = _target_merge;
       rv->destroy = _target_destroy;
 
       priv->verbose = !!vars->get_setting (vars, "verbose");
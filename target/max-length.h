@@ -18,5 +18,6 @@
 #include "../global.h"
 
 void *target_max_length_new (const setting_list_t *);
+long target_max_length_get_length (const data_collector_t *);
 
 #endif
@@ -0,0 +1,54 @@
+# Exports the CNF for 2-colorings of [1, 8] without 3-APs, checks that a
+# known coloring, given as a model, satisfies every clause of it, and
+# that import-model turns the model back into that coloring.
+#
+# Usage: cmake -DRAMSEY_CLI=<path> -DMODEL=<model file> -P cnf-round-trip.cmake
+
+# Scripts read ``-'' in file names as ``_'', so keep them out of both
+set(cnf roundtrip.cnf)
+file(REMOVE ${cnf})
+configure_file(${MODEL} roundtrip.model COPYONLY)
+file(WRITE cnf-round-trip.rs "set n-colors 2
+filter no-3-aps
+export-cnf colorings 8 ${cnf}
+import-model roundtrip.model
+")
+execute_process(COMMAND ${RAMSEY_CLI} cnf-round-trip.rs
+                OUTPUT_VARIABLE out RESULT_VARIABLE rc)
+if(NOT rc EQUAL 0)
+  message(FATAL_ERROR "ramsey-cli failed:\n${out}")
+endif()
+if(NOT out MATCHES "Imported model \\(passes filters\\): \\[\\[1, 4, 5, 8\\] \\[2, 3, 6, 7\\]\\]")
+  message(FATAL_ERROR "Model did not come back as the coloring:\n${out}")
+endif()
+
+# Read the model's true literals
+file(STRINGS ${MODEL} model_lines REGEX "^v ")
+string(REGEX MATCHALL "-?[0-9]+" model "${model_lines}")
+
+file(STRINGS ${cnf} lines)
+set(n_clauses 0)
+foreach(line IN LISTS lines)
+  if(line MATCHES "^p cnf ([0-9]+) ([0-9]+)")
+    set(n_vars ${CMAKE_MATCH_1})
+    set(n_expected ${CMAKE_MATCH_2})
+  elseif(NOT line MATCHES "^c")
+    string(REGEX MATCHALL "-?[0-9]+" lits "${line}")
+    list(REMOVE_ITEM lits 0)
+    set(satisfied FALSE)
+    foreach(lit IN LISTS lits)
+      list(FIND model ${lit} found)
+      if(NOT found EQUAL -1)
+        set(satisfied TRUE)
+      endif()
+    endforeach()
+    if(NOT satisfied)
+      message(FATAL_ERROR "Model violates clause ``${line}''")
+    endif()
+    math(EXPR n_clauses "${n_clauses} + 1")
+  endif()
+endforeach()
+
+if(NOT n_vars EQUAL 16 OR NOT n_clauses EQUAL n_expected)
+  message(FATAL_ERROR "Bad CNF: ${n_vars} variables, ${n_clauses} of ${n_expected} clauses")
+endif()
@@ -0,0 +1,7 @@
+# no-odd-lattice-aps on 3 columns: the longest lattice of 15 cells has
+# 5 full rows.
+set max-depth 16
+set n-colors 2
+set n-columns 3
+filter no-odd-lattice-aps
+search lattices
@@ -0,0 +1,8 @@
+# no-odd-lattice-aps on an even number of columns. Some lattices (e.g.
+# every row 1 1 1 2) have no 4-AP of odd gap at any height, so the
+# search must be bounded by max-depth; it must stop there.
+set max-depth 16
+set n-colors 2
+set n-columns 4
+filter no-odd-lattice-aps
+search lattices
@@ -0,0 +1,8 @@
+# Local search with a fixed seed: it should find a 3-coloring of
+# [1, 26] without 3-APs, the longest there is (W(3;3) = 27), and then
+# stall, since there is none of [1, 27].
+set n-colors 3
+set random-seed 1
+set stall-after 200000
+filter no-3-aps
+local-search colorings 20
@@ -0,0 +1,40 @@
+# Checks that the shards of a search add up to the whole of it.
+#
+# Usage: cmake -DRAMSEY_CLI=<path> -DSCRIPT=<script> -DSHARD_BY=<hash|index>
+#              -DCHILD_ORDER=<order> [-DN_SHARDS=<n>] -P shard-sums.cmake
+
+if(NOT N_SHARDS)
+  set(N_SHARDS 3)
+endif()
+file(READ ${SCRIPT} body)
+
+function(count_iterations name settings result)
+  file(WRITE ${name} "${settings}${body}")
+  execute_process(COMMAND ${RAMSEY_CLI} ${name}
+                  OUTPUT_VARIABLE out RESULT_VARIABLE rc)
+  if(NOT rc EQUAL 0)
+    message(FATAL_ERROR "ramsey-cli failed on ${name}:\n${out}")
+  endif()
+  if(NOT out MATCHES "Iterations: ([0-9]+)")
+    message(FATAL_ERROR "No iteration count from ${name}:\n${out}")
+  endif()
+  set(${result} ${CMAKE_MATCH_1} PARENT_SCOPE)
+endfunction()
+
+set(common "set child-order ${CHILD_ORDER}\nset random-seed 1\n")
+set(prefix shard-sums-${SHARD_BY}-${CHILD_ORDER})
+count_iterations(${prefix}-whole.rs "${common}" whole)
+
+set(sum 0)
+math(EXPR last "${N_SHARDS} - 1")
+foreach(i RANGE ${last})
+  count_iterations(${prefix}-${i}.rs
+    "${common}set shard ${i}/${N_SHARDS}\nset shard-by ${SHARD_BY}\n" n)
+  message(STATUS "shard ${i}/${N_SHARDS}: ${n}")
+  math(EXPR sum "${sum} + ${n}")
+endforeach()
+
+if(NOT sum EQUAL whole)
+  message(FATAL_ERROR "Shards by ${SHARD_BY} (child-order ${CHILD_ORDER}) sum to ${sum}, not ${whole}")
+endif()
+message(STATUS "Shards sum to ${sum}, as does the whole search")
@@ -0,0 +1,8 @@
+# Colorings with no monochromatic 4-AP: 10176 iterations unsharded.
+# shard-sums.cmake runs this once whole and once per shard, and checks
+# that the shards' iteration counts add up.
+set n-colors 2
+set ap-length 4
+set prune-tree 1
+filter no-n-aps
+search colorings
@@ -0,0 +1,10 @@
+# The built-in solver on van der Waerden numbers: W(3;2) = 9 and
+# W(3;3) = 27, so [1, 8] and [1, 26] can be colored without 3-APs,
+# but [1, 9] and [1, 27] cannot.
+filter no-3-aps
+set n-colors 2
+solve colorings 8
+solve colorings 9
+set n-colors 3
+solve colorings 26
+solve colorings 27